@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "AllocTracker.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+namespace
+{
+
+const size_t kNumStages = static_cast<size_t>(
+    ign_imgui::AllocStage::kNumStages);
+
+const char *kStageNames[kNumStages] = {
+  "other", "transport", "ingest", "export", "checkpoint", "render"};
+
+// Only trivially constructible state, so touching it from operator new
+// never allocates itself.
+std::atomic<uint64_t> gAllocations[kNumStages];
+std::atomic<uint64_t> gBytes[kNumStages];
+thread_local ign_imgui::AllocStage tStage = ign_imgui::AllocStage::kOther;
+thread_local uint64_t tAllocations[kNumStages];
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+bool AllocTracker::Enabled()
+{
+#ifdef IGN_IMGUI_TRACK_ALLOCATIONS
+  return true;
+#else
+  return false;
+#endif
+}
+
+//////////////////////////////////////////////////
+const char *AllocTracker::StageName(AllocStage _stage)
+{
+  const auto index = static_cast<size_t>(_stage);
+  return index < kNumStages ? kStageNames[index] : "unknown";
+}
+
+//////////////////////////////////////////////////
+AllocStats AllocTracker::Stage(AllocStage _stage)
+{
+  const auto index = static_cast<size_t>(_stage);
+  AllocStats stats;
+  if (index < kNumStages)
+  {
+    stats.allocations = gAllocations[index].load(std::memory_order_relaxed);
+    stats.bytes = gBytes[index].load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+//////////////////////////////////////////////////
+uint64_t AllocTracker::ThreadAllocations(AllocStage _stage)
+{
+  const auto index = static_cast<size_t>(_stage);
+  return index < kNumStages ? tAllocations[index] : 0;
+}
+
+//////////////////////////////////////////////////
+AllocStage AllocTracker::CurrentStage()
+{
+  return tStage;
+}
+
+//////////////////////////////////////////////////
+void AllocTracker::Record(size_t _bytes)
+{
+  const auto index = static_cast<size_t>(tStage);
+  ++tAllocations[index];
+  gAllocations[index].fetch_add(1, std::memory_order_relaxed);
+  gBytes[index].fetch_add(_bytes, std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+void AllocTracker::SetStage(AllocStage _stage)
+{
+  tStage = _stage;
+}
+
+//////////////////////////////////////////////////
+AllocScope::AllocScope(AllocStage _stage)
+  : previous(AllocTracker::CurrentStage())
+{
+  AllocTracker::SetStage(_stage);
+}
+
+//////////////////////////////////////////////////
+AllocScope::~AllocScope()
+{
+  AllocTracker::SetStage(this->previous);
+}
+
+}  // namespace ign_imgui
+
+#ifdef IGN_IMGUI_TRACK_ALLOCATIONS
+
+// Replacements of the global allocation functions. Every form of operator
+// new funnels into Allocate(), every form of delete frees with free().
+
+namespace
+{
+
+//////////////////////////////////////////////////
+void *Allocate(size_t _size, size_t _alignment, bool _throw)
+{
+  ign_imgui::AllocTracker::Record(_size);
+  if (_size == 0)
+    _size = 1;
+  void *ptr = nullptr;
+  if (_alignment <= alignof(std::max_align_t))
+    ptr = std::malloc(_size);
+  else if (0 != posix_memalign(&ptr, _alignment, _size))
+    ptr = nullptr;
+  if (!ptr && _throw)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+}  // namespace
+
+//////////////////////////////////////////////////
+void *operator new(size_t _size)
+{
+  return Allocate(_size, 0, true);
+}
+
+//////////////////////////////////////////////////
+void *operator new[](size_t _size)
+{
+  return Allocate(_size, 0, true);
+}
+
+//////////////////////////////////////////////////
+void *operator new(size_t _size, const std::nothrow_t &) noexcept
+{
+  return Allocate(_size, 0, false);
+}
+
+//////////////////////////////////////////////////
+void *operator new[](size_t _size, const std::nothrow_t &) noexcept
+{
+  return Allocate(_size, 0, false);
+}
+
+//////////////////////////////////////////////////
+void *operator new(size_t _size, std::align_val_t _alignment)
+{
+  return Allocate(_size, static_cast<size_t>(_alignment), true);
+}
+
+//////////////////////////////////////////////////
+void *operator new[](size_t _size, std::align_val_t _alignment)
+{
+  return Allocate(_size, static_cast<size_t>(_alignment), true);
+}
+
+//////////////////////////////////////////////////
+void operator delete(void *_ptr) noexcept
+{
+  std::free(_ptr);
+}
+
+//////////////////////////////////////////////////
+void operator delete[](void *_ptr) noexcept
+{
+  std::free(_ptr);
+}
+
+//////////////////////////////////////////////////
+void operator delete(void *_ptr, size_t) noexcept
+{
+  std::free(_ptr);
+}
+
+//////////////////////////////////////////////////
+void operator delete[](void *_ptr, size_t) noexcept
+{
+  std::free(_ptr);
+}
+
+//////////////////////////////////////////////////
+void operator delete(void *_ptr, std::align_val_t) noexcept
+{
+  std::free(_ptr);
+}
+
+//////////////////////////////////////////////////
+void operator delete[](void *_ptr, std::align_val_t) noexcept
+{
+  std::free(_ptr);
+}
+
+//////////////////////////////////////////////////
+void operator delete(void *_ptr, size_t, std::align_val_t) noexcept
+{
+  std::free(_ptr);
+}
+
+//////////////////////////////////////////////////
+void operator delete[](void *_ptr, size_t, std::align_val_t) noexcept
+{
+  std::free(_ptr);
+}
+
+#endif  // IGN_IMGUI_TRACK_ALLOCATIONS
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__ALLOC_TRACKER_HH_
+#define IGN_IMGUI__ALLOC_TRACKER_HH_
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace ign_imgui
+{
+
+/// \brief Pipeline stage that heap allocations are attributed to.
+enum class AllocStage : uint8_t
+{
+  kOther,
+  kTransport,
+  kIngest,
+  kExport,
+  kCheckpoint,
+  kRender,
+  kNumStages
+};
+
+struct AllocStats
+{
+  uint64_t allocations{0};
+  uint64_t bytes{0};
+};
+
+/// \brief Counts heap allocations per thread and per pipeline stage.
+///
+/// Counting needs a build with IGN_IMGUI_TRACK_ALLOCATIONS, which replaces
+/// the global operator new. Otherwise every count stays 0 and Enabled() is
+/// false. Threads tag what they are doing with an AllocScope, untagged
+/// allocations count as AllocStage::kOther.
+class AllocTracker
+{
+  public: static bool Enabled();
+  public: static const char *StageName(AllocStage _stage);
+
+  /// \brief Totals of all threads for _stage.
+  public: static AllocStats Stage(AllocStage _stage);
+
+  /// \brief Allocations of the calling thread while tagged with _stage.
+  public: static uint64_t ThreadAllocations(AllocStage _stage);
+
+  /// \brief Stage of the calling thread.
+  public: static AllocStage CurrentStage();
+
+  /// \brief Count an allocation of _bytes on the calling thread.
+  public: static void Record(size_t _bytes);
+
+  protected: friend class AllocScope;
+  protected: static void SetStage(AllocStage _stage);
+};
+
+/// \brief Attribute the allocations of this thread to _stage while alive.
+class AllocScope
+{
+  public: explicit AllocScope(AllocStage _stage);
+  public: ~AllocScope();
+
+  public: AllocScope(const AllocScope &) = delete;
+  public: AllocScope &operator=(const AllocScope &) = delete;
+
+  protected: AllocStage previous;
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__ALLOC_TRACKER_HH_
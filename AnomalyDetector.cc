@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "AnomalyDetector.hh"
+
+#include <algorithm>
+#include <cmath>
+
+#include <imgui/imgui.h>
+
+namespace
+{
+
+/// \brief Makes the MAD of a normal distribution comparable to sigma.
+const double kMadScale = 0.6745;
+
+/// \brief Lower bound for the MAD, so a perfectly steady RTF does not
+/// turn every tiny wobble into an anomaly.
+const double kMinMad = 1e-6;
+
+//////////////////////////////////////////////////
+bool MoreExtreme(const ign_imgui::AnomalyEvent &_a,
+                 const ign_imgui::AnomalyEvent &_b)
+{
+  return std::abs(_a.score) > std::abs(_b.score);
+}
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+AnomalyDetector::AnomalyDetector()
+{
+  this->extremes.reserve(kMaxEvents);
+}
+
+//////////////////////////////////////////////////
+void AnomalyDetector::SetThreshold(double _threshold)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->threshold = _threshold;
+}
+
+//////////////////////////////////////////////////
+void AnomalyDetector::SetRefreshInterval(uint64_t _samples)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->refreshInterval = std::max<uint64_t>(_samples, 1);
+}
+
+//////////////////////////////////////////////////
+bool AnomalyDetector::NeedsRefresh() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->sinceRefresh >= this->refreshInterval;
+}
+
+//////////////////////////////////////////////////
+void AnomalyDetector::Refresh(const Distribution &_distribution)
+{
+  // Estimate without holding the lock, the distribution takes its own.
+  const bool enough = _distribution.Count() >= kMinSamples;
+  const double newMedian = enough ? _distribution.Quantile(0.5) : 0.0;
+  const double newMad = enough ?
+    _distribution.MedianAbsDeviation(newMedian) : 0.0;
+
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->sinceRefresh = 0;
+  if (!enough || !std::isfinite(newMedian) || !std::isfinite(newMad))
+    return;
+
+  this->median = newMedian;
+  this->mad = std::max(newMad, kMinMad);
+  this->scale = kMadScale / this->mad;
+  this->ready = true;
+}
+
+//////////////////////////////////////////////////
+bool AnomalyDetector::Score(double _rtf, double _simTime, double _steady)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  ++this->sinceRefresh;
+  if (!this->ready)
+    return false;
+
+  ++this->scored;
+  const double score = (_rtf - this->median) * this->scale;
+  if (!(std::abs(score) > this->threshold))
+    return false;
+
+  if (score > 0.0)
+    ++this->high;
+  else
+    ++this->low;
+
+  const AnomalyEvent event{_rtf, score, _simTime, _steady};
+  if (this->extremes.size() < kMaxEvents)
+  {
+    this->extremes.push_back(event);
+    std::push_heap(this->extremes.begin(), this->extremes.end(), MoreExtreme);
+  }
+  else if (MoreExtreme(event, this->extremes.front()))
+  {
+    std::pop_heap(this->extremes.begin(), this->extremes.end(), MoreExtreme);
+    this->extremes.back() = event;
+    std::push_heap(this->extremes.begin(), this->extremes.end(), MoreExtreme);
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+double AnomalyDetector::Median() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->median;
+}
+
+//////////////////////////////////////////////////
+double AnomalyDetector::Mad() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->mad;
+}
+
+//////////////////////////////////////////////////
+uint64_t AnomalyDetector::Scored() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->scored;
+}
+
+//////////////////////////////////////////////////
+uint64_t AnomalyDetector::High() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->high;
+}
+
+//////////////////////////////////////////////////
+uint64_t AnomalyDetector::Low() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->low;
+}
+
+//////////////////////////////////////////////////
+std::vector<AnomalyEvent> AnomalyDetector::Extremes() const
+{
+  std::vector<AnomalyEvent> events;
+  {
+    std::lock_guard<std::mutex> lock(this->dataMutex);
+    events = this->extremes;
+  }
+  std::sort(events.begin(), events.end(), MoreExtreme);
+  return events;
+}
+
+//////////////////////////////////////////////////
+void AnomalyDetector::Draw()
+{
+  ImGui::Text("median %.4f, MAD %.4f: %llu high, %llu low of %llu",
+      this->Median(), this->Mad(),
+      static_cast<unsigned long long>(this->High()),
+      static_cast<unsigned long long>(this->Low()),
+      static_cast<unsigned long long>(this->Scored()));
+  for (const auto &event : this->Extremes())
+  {
+    ImGui::Text("  rtf %.4f (score %+.1f) at sim time %.3f", event.rtf,
+        event.score, event.simTime);
+  }
+}
+
+}  // namespace ign_imgui
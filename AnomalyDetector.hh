@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__ANOMALY_DETECTOR_HH_
+#define IGN_IMGUI__ANOMALY_DETECTOR_HH_
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <mutex>
+#include <vector>
+
+#include "Distribution.hh"
+
+namespace ign_imgui
+{
+
+/// \brief One sample scored as an anomaly.
+struct AnomalyEvent
+{
+  double rtf;
+  double score;
+  double simTime;
+  /// \brief Local receive time, see SteadySeconds().
+  double steady;
+};
+
+/// \brief Scores RTF samples against a robust estimate of the typical RTF.
+///
+/// The score is the modified z-score 0.6745 * (x - median) / MAD, which a
+/// few huge spikes cannot inflate the way they inflate the variance. Median
+/// and MAD come from the Distribution and are only re-estimated every
+/// refresh interval, so scoring a sample is O(1).
+class AnomalyDetector
+{
+  /// \brief Score magnitude above which a sample is an anomaly.
+  public: static constexpr double kDefaultThreshold = 3.5;
+
+  /// \brief Samples scored between two estimates of median and MAD.
+  public: static constexpr uint64_t kDefaultRefreshInterval = 1024;
+
+  /// \brief Samples the distribution needs before scoring starts.
+  public: static constexpr uint64_t kMinSamples = 100;
+
+  /// \brief Number of most extreme events kept.
+  public: static constexpr size_t kMaxEvents = 10;
+
+  public: AnomalyDetector();
+
+  public: void SetThreshold(double _threshold);
+  public: void SetRefreshInterval(uint64_t _samples);
+
+  /// \brief True once a refresh interval of samples was scored since the
+  /// last Refresh().
+  public: bool NeedsRefresh() const;
+
+  /// \brief Re-estimate median and MAD from _distribution.
+  public: void Refresh(const Distribution &_distribution);
+
+  /// \brief Score a sample, counting it if it is an anomaly. Samples are
+  /// not scored before the first Refresh() with enough data.
+  /// \return True if the sample is an anomaly.
+  public: bool Score(double _rtf, double _simTime, double _steady);
+
+  public: double Median() const;
+  public: double Mad() const;
+
+  /// \brief Samples scored since the first usable Refresh().
+  public: uint64_t Scored() const;
+
+  /// \brief Anomalies above and below the median.
+  public: uint64_t High() const;
+  public: uint64_t Low() const;
+
+  /// \brief Most extreme events, largest score magnitude first.
+  public: std::vector<AnomalyEvent> Extremes() const;
+
+  public: void Draw();
+
+  protected: double threshold{kDefaultThreshold};
+  protected: uint64_t refreshInterval{kDefaultRefreshInterval};
+  protected: uint64_t sinceRefresh{0};
+  protected: bool ready{false};
+  protected: double median{0.0};
+  protected: double mad{0.0};
+  /// \brief 0.6745 / MAD, so scoring is one multiply.
+  protected: double scale{0.0};
+  protected: uint64_t scored{0};
+  protected: uint64_t high{0};
+  protected: uint64_t low{0};
+
+  /// \brief Min-heap on score magnitude of the kMaxEvents most extreme.
+  protected: std::vector<AnomalyEvent> extremes;
+  protected: mutable std::mutex dataMutex;
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__ANOMALY_DETECTOR_HH_
@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "ArrowExport.hh"
+
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include "Export.hh"
+
+namespace
+{
+
+//////////////////////////////////////////////////
+template<typename T>
+std::string ToString(T _value)
+{
+  std::ostringstream oss;
+  oss << _value;
+  return oss.str();
+}
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+ArrowExport::~ArrowExport()
+{
+  // The owner had its chance to see write errors by calling Close().
+  try
+  {
+    this->Close();
+  }
+  catch (const std::runtime_error &)
+  {
+  }
+}
+
+//////////////////////////////////////////////////
+void ArrowExport::Open(const std::string &_prefix)
+{
+  this->Close();
+  this->prefix = _prefix;
+  Allocate(this->staging);
+  this->spare.resize(kSpareBatches);
+  for (auto &batch : this->spare)
+    Allocate(batch);
+  // Handing over must not allocate while the writer keeps up.
+  this->ready.reserve(kSpareBatches + 1);
+  this->writing.reserve(kSpareBatches + 1);
+  this->nextInterval = 0;
+
+  // Either every file is open or none, IsOpen() only looks at the first.
+  try
+  {
+    this->samples.Open(_prefix + ".samples.arrow", {
+        {"rtf", ArrowType::kFloat64},
+        {"sim_time", ArrowType::kFloat64},
+        {"real_time", ArrowType::kFloat64}});
+    this->stats.Open(_prefix + ".stats.arrow", {
+        {"wall_time", ArrowType::kFloat64},
+        {"sim_time", ArrowType::kFloat64},
+        {"real_time", ArrowType::kFloat64},
+        {"count", ArrowType::kUInt64},
+        {"mean", ArrowType::kFloat64},
+        {"variance", ArrowType::kFloat64},
+        {"min", ArrowType::kFloat64},
+        {"max", ArrowType::kFloat64},
+        {"skewness", ArrowType::kFloat64},
+        {"kurtosis", ArrowType::kFloat64}});
+  }
+  catch (const std::runtime_error &)
+  {
+    this->samples.Close();
+    this->stats.Close();
+    throw;
+  }
+}
+
+//////////////////////////////////////////////////
+void ArrowExport::Close()
+{
+  // The files are closed even if writing the last samples fails.
+  try
+  {
+    if (this->samples.IsOpen())
+    {
+      this->HandOffSamples();
+      this->WriteSamples();
+    }
+  }
+  catch (const std::runtime_error &)
+  {
+    this->samples.Close();
+    this->intervals.Close();
+    this->stats.Close();
+    throw;
+  }
+  this->samples.Close();
+  this->intervals.Close();
+  this->stats.Close();
+}
+
+//////////////////////////////////////////////////
+bool ArrowExport::IsOpen() const
+{
+  return this->samples.IsOpen();
+}
+
+//////////////////////////////////////////////////
+void ArrowExport::AppendSamples(const Reservoir &_reservoir)
+{
+  this->HandOffSamples();
+  for (const auto &sample : _reservoir.Samples())
+    this->AppendSample(sample);
+  this->HandOffSamples();
+  this->WriteSamples();
+}
+
+//////////////////////////////////////////////////
+void ArrowExport::HandOffSamples()
+{
+  if (this->staging.rows == 0)
+    return;
+  std::lock_guard<std::mutex> lock(this->batchMutex);
+  this->ready.push_back(std::move(this->staging));
+  if (this->spare.empty())
+  {
+    // The writer is behind, grow the pool rather than drop samples.
+    this->staging = SampleBatch();
+    Allocate(this->staging);
+  }
+  else
+  {
+    this->staging = std::move(this->spare.back());
+    this->spare.pop_back();
+  }
+}
+
+//////////////////////////////////////////////////
+void ArrowExport::WriteSamples()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->batchMutex);
+    std::swap(this->writing, this->ready);
+  }
+  if (this->writing.empty())
+    return;
+
+  for (auto &batch : this->writing)
+  {
+    this->samples.WriteBatch(
+        {batch.rtf.data(), batch.sim.data(), batch.real.data()}, batch.rows);
+    batch.rows = 0;
+  }
+
+  std::lock_guard<std::mutex> lock(this->batchMutex);
+  for (auto &batch : this->writing)
+    this->spare.push_back(std::move(batch));
+  this->writing.clear();
+}
+
+//////////////////////////////////////////////////
+void ArrowExport::Allocate(SampleBatch &_batch)
+{
+  _batch.rtf.resize(kBatchRows);
+  _batch.sim.resize(kBatchRows);
+  _batch.real.resize(kBatchRows);
+  _batch.rows = 0;
+}
+
+//////////////////////////////////////////////////
+void ArrowExport::AppendIntervals(const IntervalHeatmap &_intervals)
+{
+  if (!this->IsOpen())
+    return;
+  const auto columns = _intervals.Columns(this->nextInterval);
+  const int32_t numPercentiles =
+    static_cast<int32_t>(IntervalHeatmap::kPercentiles.size());
+  if (!this->intervals.IsOpen())
+  {
+    std::string percentiles;
+    for (auto percentile : IntervalHeatmap::kPercentiles)
+      percentiles += (percentiles.empty() ? "" : ",") + ToString(percentile);
+    this->intervals.Open(this->prefix + ".intervals.arrow", {
+        {"interval", ArrowType::kUInt64},
+        {"percentiles", ArrowType::kFloat32, numPercentiles},
+        {"counts", ArrowType::kFloat32,
+          static_cast<int32_t>(columns.numBins)}}, {
+        {"bin_min", ToString(columns.min)},
+        {"bin_max", ToString(columns.max)},
+        {"interval_seconds", ToString(columns.interval)},
+        {"percentiles", percentiles}});
+  }
+
+  const size_t count = columns.percentiles.size() / numPercentiles;
+  this->nextInterval = columns.first + count;
+  if (count == 0)
+    return;
+  std::vector<uint64_t> numbers(count);
+  std::iota(numbers.begin(), numbers.end(), columns.first);
+  this->intervals.WriteBatch({numbers.data(), columns.percentiles.data(),
+      columns.counts.data()}, count);
+}
+
+//////////////////////////////////////////////////
+void ArrowExport::AppendStats(const Moments &_moments, double _simTime,
+                              double _realTime)
+{
+  const double wallTime = WallSeconds();
+  const uint64_t count = _moments.Count();
+  const double mean = _moments.Mean();
+  const double variance = _moments.Variance();
+  const double min = _moments.Min();
+  const double max = _moments.Max();
+  const double skewness = _moments.Skewness();
+  const double kurtosis = _moments.Kurtosis();
+  this->stats.WriteBatch({&wallTime, &_simTime, &_realTime, &count, &mean,
+      &variance, &min, &max, &skewness, &kurtosis}, 1);
+}
+
+}  // namespace ign_imgui
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__ARROW_EXPORT_HH_
+#define IGN_IMGUI__ARROW_EXPORT_HH_
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ArrowWriter.hh"
+#include "IntervalHeatmap.hh"
+#include "Moments.hh"
+#include "Reservoir.hh"
+
+namespace ign_imgui
+{
+
+/// \brief Writes RTF data as Arrow IPC files next to each other:
+///
+/// - <prefix>.samples.arrow: rtf, sim_time and real_time of raw samples.
+/// - <prefix>.intervals.arrow: per interval its number, the percentiles of
+///   IntervalHeatmap::kPercentiles and the bin counts, with the bin range
+///   and interval length in the schema metadata.
+/// - <prefix>.stats.arrow: one row of summary statistics per snapshot.
+///
+/// Samples are staged column by column and written kBatchRows at a time,
+/// each file stays readable while batches are appended. Staging and
+/// writing are split, so the ingest thread only fills columns and hands
+/// full ones over, and another thread writes them with WriteSamples().
+/// Two batches are allocated up front, one staging and one being written,
+/// more are only allocated when the writer falls behind.
+class ArrowExport
+{
+  /// \brief Rows of samples per record batch.
+  public: static constexpr size_t kBatchRows = 65536;
+
+  /// \brief Batches allocated up front besides the staging one.
+  public: static constexpr size_t kSpareBatches = 1;
+
+  public: ArrowExport() = default;
+  public: ~ArrowExport();
+
+  /// \throws std::runtime_error if a file cannot be written, with no
+  /// file left open.
+  public: void Open(const std::string &_prefix);
+
+  /// \brief Write the staged and handed over samples and close all files.
+  /// Neither staging nor writing may be running.
+  /// \throws std::runtime_error if the samples cannot be written, the
+  /// files are closed anyway.
+  public: void Close();
+  public: bool IsOpen() const;
+
+  /// \brief Stage one raw sample, handing the batch over once it is full.
+  public: inline void AppendSample(const RtfSample &_sample)
+  {
+    SampleBatch &batch = this->staging;
+    batch.rtf[batch.rows] = _sample.rtf;
+    batch.sim[batch.rows] = _sample.sim;
+    batch.real[batch.rows] = _sample.real;
+    if (++batch.rows == kBatchRows)
+      this->HandOffSamples();
+  }
+
+  /// \brief Write every sample of _reservoir, e.g. for a one-off export.
+  public: void AppendSamples(const Reservoir &_reservoir);
+
+  /// \brief Hand the staged samples over to be written, even if the batch
+  /// isn't full. Called from the thread staging samples, or under its lock.
+  public: void HandOffSamples();
+
+  /// \brief Write the batches handed over since the last call. Only one
+  /// thread may call this, it can run while another stages samples.
+  public: void WriteSamples();
+
+  /// \brief Write the intervals closed since the last call.
+  public: void AppendIntervals(const IntervalHeatmap &_intervals);
+
+  public: void AppendStats(const Moments &_moments, double _simTime,
+                           double _realTime);
+
+  protected: std::string prefix;
+  protected: ArrowWriter samples;
+  protected: ArrowWriter intervals;
+  protected: ArrowWriter stats;
+
+  /// \brief Columns of up to kBatchRows samples.
+  protected: struct SampleBatch
+  {
+    std::vector<double> rtf;
+    std::vector<double> sim;
+    std::vector<double> real;
+    size_t rows{0};
+  };
+
+  /// \brief Allocate the columns of _batch and empty it.
+  protected: static void Allocate(SampleBatch &_batch);
+
+  protected: SampleBatch staging;
+
+  /// \brief Batches handed over, empty ones to stage into next, and the
+  /// ones WriteSamples() is writing. Only the first two are shared between
+  /// threads, guarded by batchMutex.
+  protected: std::vector<SampleBatch> ready;
+  protected: std::vector<SampleBatch> spare;
+  protected: std::vector<SampleBatch> writing;
+  protected: std::mutex batchMutex;
+
+  /// \brief Number of the next interval to write.
+  protected: uint64_t nextInterval{0};
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__ARROW_EXPORT_HH_
@@ -0,0 +1,454 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "ArrowWriter.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// Layouts follow format/Schema.fbs, Message.fbs and File.fbs of the Arrow
+// columnar format, metadata version 5. Numbers are written in host byte
+// order, which Arrow requires to be declared in the schema; only little
+// endian hosts are supported.
+
+namespace
+{
+
+const char kMagic[8] = {'A', 'R', 'R', 'O', 'W', '1', '\0', '\0'};
+const uint32_t kContinuation = 0xFFFFFFFF;
+
+/// \brief Message.fbs and Schema.fbs enum values.
+const int16_t kMetadataV5 = 4;
+const int16_t kLittleEndian = 0;
+const uint8_t kHeaderSchema = 1;
+const uint8_t kHeaderRecordBatch = 3;
+const uint8_t kTypeInt = 2;
+const uint8_t kTypeFloatingPoint = 3;
+const uint8_t kTypeFixedSizeList = 16;
+const int16_t kPrecisionSingle = 1;
+const int16_t kPrecisionDouble = 2;
+
+/// \brief Arrow asks for buffers padded to a multiple of 8 bytes.
+const size_t kAlignment = 8;
+
+/// \brief FieldNode and Buffer structs of Message.fbs.
+struct FieldNode
+{
+  int64_t length;
+  int64_t nullCount;
+};
+
+struct BufferSpec
+{
+  int64_t offset;
+  int64_t length;
+};
+
+//////////////////////////////////////////////////
+size_t Padded(size_t _size)
+{
+  return (_size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+//////////////////////////////////////////////////
+size_t TypeSize(ign_imgui::ArrowType _type)
+{
+  return _type == ign_imgui::ArrowType::kFloat32 ? 4 : 8;
+}
+
+/// \brief Minimal flatbuffer builder, covering what the Arrow metadata
+/// needs: tables of scalars and offsets, strings and vectors.
+///
+/// Like the reference implementation the buffer is built back to front,
+/// so children are complete before the table referring to them. Objects
+/// are identified by their distance from the end of the buffer. The bytes
+/// are kept in reverse order and flipped once in Finish().
+class FlatBuilder
+{
+  public: uint32_t Size() const
+  {
+    return static_cast<uint32_t>(this->bytes.size());
+  }
+
+  public: template<typename T>
+  void Push(T _value)
+  {
+    unsigned char raw[sizeof(T)];
+    memcpy(raw, &_value, sizeof(T));
+    for (size_t ii = sizeof(T); ii > 0; --ii)
+      this->bytes.push_back(raw[ii - 1]);
+  }
+
+  /// \brief Pad so that after _length more bytes the size is a multiple
+  /// of _alignment.
+  public: void PreAlign(size_t _length, size_t _alignment)
+  {
+    this->minAlign = std::max(this->minAlign, _alignment);
+    const size_t pad = (_alignment - (this->Size() + _length) % _alignment) %
+      _alignment;
+    this->bytes.insert(this->bytes.end(), pad, 0);
+  }
+
+  /// \brief Offset from a uint32 pushed next to the object at _target.
+  public: void PushOffset(uint32_t _target)
+  {
+    this->PreAlign(4, 4);
+    const uint32_t offset = this->Size() + 4 - _target;
+    this->Push(offset);
+  }
+
+  public: uint32_t String(const std::string &_str)
+  {
+    this->PreAlign(_str.size() + 1, 4);
+    this->bytes.push_back(0);
+    this->bytes.insert(this->bytes.end(), _str.rbegin(), _str.rend());
+    this->Push(static_cast<uint32_t>(_str.size()));
+    return this->Size();
+  }
+
+  public: uint32_t OffsetVector(const std::vector<uint32_t> &_offsets)
+  {
+    this->PreAlign(_offsets.size() * 4, 4);
+    for (auto it = _offsets.rbegin(); it != _offsets.rend(); ++it)
+      this->PushOffset(*it);
+    this->Push(static_cast<uint32_t>(_offsets.size()));
+    return this->Size();
+  }
+
+  /// \brief Vector of structs with 8 byte alignment.
+  public: template<typename T>
+  uint32_t StructVector(const std::vector<T> &_items)
+  {
+    const size_t size = _items.size() * sizeof(T);
+    this->PreAlign(size, 4);
+    this->PreAlign(size, 8);
+    const auto *raw = reinterpret_cast<const unsigned char *>(_items.data());
+    for (size_t ii = size; ii > 0; --ii)
+      this->bytes.push_back(raw[ii - 1]);
+    this->Push(static_cast<uint32_t>(_items.size()));
+    return this->Size();
+  }
+
+  public: void StartTable()
+  {
+    this->fields.clear();
+    this->tableStart = this->Size();
+  }
+
+  public: template<typename T>
+  void AddField(uint16_t _id, T _value)
+  {
+    this->PreAlign(sizeof(T), sizeof(T));
+    this->Push(_value);
+    this->fields.emplace_back(_id, this->Size());
+  }
+
+  public: void AddOffsetField(uint16_t _id, uint32_t _target)
+  {
+    this->PushOffset(_target);
+    this->fields.emplace_back(_id, this->Size());
+  }
+
+  /// \brief Write the vtable in front of the table and link the two.
+  public: uint32_t EndTable()
+  {
+    this->PreAlign(4, 4);
+    this->Push(int32_t{0});
+    const uint32_t table = this->Size();
+
+    uint16_t numFields = 0;
+    for (const auto &field : this->fields)
+      numFields = std::max<uint16_t>(numFields, field.first + 1);
+    std::vector<uint16_t> vtable(2 + numFields, 0);
+    vtable[0] = static_cast<uint16_t>(vtable.size() * 2);
+    vtable[1] = static_cast<uint16_t>(table - this->tableStart);
+    for (const auto &field : this->fields)
+      vtable[2 + field.first] = static_cast<uint16_t>(table - field.second);
+    for (auto it = vtable.rbegin(); it != vtable.rend(); ++it)
+      this->Push(*it);
+
+    // The table starts with the distance back to its vtable.
+    const int32_t vtableOffset = static_cast<int32_t>(this->Size() - table);
+    unsigned char raw[4];
+    memcpy(raw, &vtableOffset, 4);
+    for (size_t ii = 0; ii < 4; ++ii)
+      this->bytes[table - 1 - ii] = raw[ii];
+    return table;
+  }
+
+  public: std::vector<char> Finish(uint32_t _root)
+  {
+    this->PreAlign(4, this->minAlign);
+    this->PushOffset(_root);
+    return std::vector<char>(this->bytes.rbegin(), this->bytes.rend());
+  }
+
+  protected: std::vector<unsigned char> bytes;
+  protected: std::vector<std::pair<uint16_t, uint32_t>> fields;
+  protected: uint32_t tableStart{0};
+  protected: size_t minAlign{4};
+};
+
+//////////////////////////////////////////////////
+uint32_t PrimitiveType(FlatBuilder &_fb, ign_imgui::ArrowType _type,
+                       uint8_t &_typeId)
+{
+  _fb.StartTable();
+  if (_type == ign_imgui::ArrowType::kUInt64)
+  {
+    _typeId = kTypeInt;
+    _fb.AddField<int32_t>(0, 64);
+    _fb.AddField<uint8_t>(1, 0);
+  }
+  else
+  {
+    _typeId = kTypeFloatingPoint;
+    _fb.AddField<int16_t>(0, _type == ign_imgui::ArrowType::kFloat32 ?
+        kPrecisionSingle : kPrecisionDouble);
+  }
+  return _fb.EndTable();
+}
+
+//////////////////////////////////////////////////
+uint32_t Field(FlatBuilder &_fb, const std::string &_name, uint8_t _typeId,
+               uint32_t _type, const std::vector<uint32_t> &_children)
+{
+  const uint32_t name = _fb.String(_name);
+  const uint32_t children = _fb.OffsetVector(_children);
+  _fb.StartTable();
+  _fb.AddOffsetField(0, name);
+  _fb.AddOffsetField(3, _type);
+  _fb.AddOffsetField(5, children);
+  _fb.AddField<uint8_t>(1, 0);
+  _fb.AddField<uint8_t>(2, _typeId);
+  return _fb.EndTable();
+}
+
+//////////////////////////////////////////////////
+uint32_t Schema(FlatBuilder &_fb,
+    const std::vector<ign_imgui::ArrowField> &_schema,
+    const std::vector<std::pair<std::string, std::string>> &_metadata)
+{
+  std::vector<uint32_t> fields;
+  for (const auto &arrowField : _schema)
+  {
+    uint8_t typeId;
+    uint32_t type = PrimitiveType(_fb, arrowField.type, typeId);
+    std::vector<uint32_t> children;
+    if (arrowField.listSize > 0)
+    {
+      children.push_back(Field(_fb, "item", typeId, type, {}));
+      _fb.StartTable();
+      _fb.AddField<int32_t>(0, arrowField.listSize);
+      type = _fb.EndTable();
+      typeId = kTypeFixedSizeList;
+    }
+    fields.push_back(Field(_fb, arrowField.name, typeId, type, children));
+  }
+
+  std::vector<uint32_t> keyValues;
+  for (const auto &entry : _metadata)
+  {
+    const uint32_t key = _fb.String(entry.first);
+    const uint32_t value = _fb.String(entry.second);
+    _fb.StartTable();
+    _fb.AddOffsetField(0, key);
+    _fb.AddOffsetField(1, value);
+    keyValues.push_back(_fb.EndTable());
+  }
+
+  const uint32_t fieldVector = _fb.OffsetVector(fields);
+  const uint32_t metadataVector = _fb.OffsetVector(keyValues);
+  _fb.StartTable();
+  _fb.AddOffsetField(1, fieldVector);
+  _fb.AddOffsetField(2, metadataVector);
+  _fb.AddField<int16_t>(0, kLittleEndian);
+  return _fb.EndTable();
+}
+
+//////////////////////////////////////////////////
+std::vector<char> Message(FlatBuilder &_fb, uint8_t _headerType,
+                          uint32_t _header, int64_t _bodyLength)
+{
+  _fb.StartTable();
+  _fb.AddField<int64_t>(3, _bodyLength);
+  _fb.AddOffsetField(2, _header);
+  _fb.AddField<int16_t>(0, kMetadataV5);
+  _fb.AddField<uint8_t>(1, _headerType);
+  return _fb.Finish(_fb.EndTable());
+}
+
+//////////////////////////////////////////////////
+/// \brief Write an encapsulated message: continuation marker, metadata
+/// length and the metadata padded to a multiple of 8 bytes.
+/// \return Bytes written.
+int32_t WriteMessage(std::ostream &_ost, const std::vector<char> &_metadata)
+{
+  const uint32_t length = static_cast<uint32_t>(Padded(_metadata.size()));
+  _ost.write(reinterpret_cast<const char *>(&kContinuation), 4);
+  _ost.write(reinterpret_cast<const char *>(&length), 4);
+  _ost.write(_metadata.data(), _metadata.size());
+  const char zeros[kAlignment] = {};
+  _ost.write(zeros, length - _metadata.size());
+  return static_cast<int32_t>(8 + length);
+}
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+ArrowWriter::~ArrowWriter()
+{
+  this->Close();
+}
+
+//////////////////////////////////////////////////
+void ArrowWriter::Open(const std::string &_path,
+    const std::vector<ArrowField> &_schema,
+    const std::vector<std::pair<std::string, std::string>> &_metadata)
+{
+  this->Close();
+  this->schema = _schema;
+  this->metadata = _metadata;
+  this->blocks.clear();
+  this->rows = 0;
+
+  this->file.open(_path, std::ios::binary | std::ios::trunc);
+  this->file.write(kMagic, sizeof(kMagic));
+  FlatBuilder fb;
+  const uint32_t header = Schema(fb, this->schema, this->metadata);
+  WriteMessage(this->file, Message(fb, kHeaderSchema, header, 0));
+  this->end = this->file.tellp();
+  this->WriteFooter();
+  if (!this->file.good())
+  {
+    this->file.close();
+    throw std::runtime_error{"failed to write arrow file " + _path};
+  }
+}
+
+//////////////////////////////////////////////////
+void ArrowWriter::Close()
+{
+  if (this->file.is_open())
+    this->file.close();
+}
+
+//////////////////////////////////////////////////
+bool ArrowWriter::IsOpen() const
+{
+  return this->file.is_open();
+}
+
+//////////////////////////////////////////////////
+void ArrowWriter::WriteBatch(const std::vector<const void *> &_columns,
+                             size_t _rows)
+{
+  if (!this->file.is_open() || _columns.size() != this->schema.size())
+    throw std::runtime_error{"failed to write arrow batch"};
+
+  // No nulls, so every validity buffer is empty.
+  std::vector<FieldNode> nodes;
+  std::vector<BufferSpec> buffers;
+  std::vector<size_t> sizes;
+  int64_t bodyLength = 0;
+  for (const auto &field : this->schema)
+  {
+    const int64_t length = static_cast<int64_t>(_rows);
+    nodes.push_back({length, 0});
+    buffers.push_back({bodyLength, 0});
+    size_t values = _rows;
+    if (field.listSize > 0)
+    {
+      values *= field.listSize;
+      nodes.push_back({static_cast<int64_t>(values), 0});
+      buffers.push_back({bodyLength, 0});
+    }
+    sizes.push_back(values * TypeSize(field.type));
+    buffers.push_back({bodyLength, static_cast<int64_t>(sizes.back())});
+    bodyLength += Padded(sizes.back());
+  }
+
+  FlatBuilder fb;
+  const uint32_t nodeVector = fb.StructVector(nodes);
+  const uint32_t bufferVector = fb.StructVector(buffers);
+  fb.StartTable();
+  fb.AddField<int64_t>(0, static_cast<int64_t>(_rows));
+  fb.AddOffsetField(1, nodeVector);
+  fb.AddOffsetField(2, bufferVector);
+  const uint32_t header = fb.EndTable();
+
+  this->file.seekp(this->end);
+  Block block{this->end, 0, 0, bodyLength};
+  block.metaDataLength = WriteMessage(this->file,
+      Message(fb, kHeaderRecordBatch, header, bodyLength));
+  const char zeros[kAlignment] = {};
+  for (size_t ii = 0; ii < _columns.size(); ++ii)
+  {
+    this->file.write(static_cast<const char *>(_columns[ii]), sizes[ii]);
+    this->file.write(zeros, Padded(sizes[ii]) - sizes[ii]);
+  }
+  this->end = this->file.tellp();
+  this->blocks.push_back(block);
+  this->rows += _rows;
+
+  this->WriteFooter();
+  if (!this->file.good())
+    throw std::runtime_error{"failed to write arrow batch"};
+}
+
+//////////////////////////////////////////////////
+uint64_t ArrowWriter::Rows() const
+{
+  return this->rows;
+}
+
+//////////////////////////////////////////////////
+size_t ArrowWriter::Batches() const
+{
+  return this->blocks.size();
+}
+
+//////////////////////////////////////////////////
+void ArrowWriter::WriteFooter()
+{
+  FlatBuilder fb;
+  const uint32_t schemaTable = Schema(fb, this->schema, this->metadata);
+  const uint32_t dictionaries = fb.StructVector(std::vector<Block>());
+  const uint32_t recordBatches = fb.StructVector(this->blocks);
+  fb.StartTable();
+  fb.AddOffsetField(1, schemaTable);
+  fb.AddOffsetField(2, dictionaries);
+  fb.AddOffsetField(3, recordBatches);
+  fb.AddField<int16_t>(0, kMetadataV5);
+  const auto footer = fb.Finish(fb.EndTable());
+
+  // End of stream marker, then the footer and its length.
+  const uint32_t endOfStream[2] = {kContinuation, 0};
+  const int32_t footerLength = static_cast<int32_t>(footer.size());
+  this->file.write(reinterpret_cast<const char *>(endOfStream),
+      sizeof(endOfStream));
+  this->file.write(footer.data(), footer.size());
+  this->file.write(reinterpret_cast<const char *>(&footerLength), 4);
+  this->file.write(kMagic, 6);
+  this->file.flush();
+}
+
+}  // namespace ign_imgui
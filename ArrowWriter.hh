@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__ARROW_WRITER_HH_
+#define IGN_IMGUI__ARROW_WRITER_HH_
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ign_imgui
+{
+
+/// \brief Column types an ArrowWriter can write.
+enum class ArrowType
+{
+  kFloat32,
+  kFloat64,
+  kUInt64
+};
+
+/// \brief Non-nullable column of a schema. With a list size of N every row
+/// holds N values, written as fixed_size_list<type>[N].
+struct ArrowField
+{
+  std::string name;
+  ArrowType type;
+  int32_t listSize{0};
+};
+
+/// \brief Writes record batches to an Arrow IPC file (Feather v2) without
+/// depending on libarrow.
+///
+/// The flatbuffer metadata is encoded by hand and the column buffers are
+/// written straight from the caller's memory, so writing a batch is a
+/// handful of writes no matter how many rows it has. The footer is
+/// rewritten after every batch, so the file can be read at any time while
+/// batches are still being appended.
+class ArrowWriter
+{
+  public: ArrowWriter() = default;
+  public: ~ArrowWriter();
+
+  public: ArrowWriter(const ArrowWriter &) = delete;
+  public: ArrowWriter &operator=(const ArrowWriter &) = delete;
+
+  /// \brief Create _path holding the schema and no batches yet.
+  /// \param[in] _metadata Key value pairs attached to the schema.
+  /// \throws std::runtime_error if the file cannot be written.
+  public: void Open(const std::string &_path,
+                    const std::vector<ArrowField> &_schema,
+                    const std::vector<std::pair<std::string, std::string>>
+                      &_metadata = {});
+
+  public: void Close();
+  public: bool IsOpen() const;
+
+  /// \brief Append a batch of _rows rows. _columns holds one pointer per
+  /// field to _rows values, or _rows * listSize for list fields.
+  /// \throws std::runtime_error if the file cannot be written.
+  public: void WriteBatch(const std::vector<const void *> &_columns,
+                          size_t _rows);
+
+  public: uint64_t Rows() const;
+  public: size_t Batches() const;
+
+  /// \brief Location of an encapsulated message in the file.
+  public: struct Block
+  {
+    int64_t offset;
+    int32_t metaDataLength;
+    int32_t padding;
+    int64_t bodyLength;
+  };
+
+  /// \brief Write the footer after the last batch.
+  protected: void WriteFooter();
+
+  protected: std::ofstream file;
+  protected: std::vector<ArrowField> schema;
+  protected: std::vector<std::pair<std::string, std::string>> metadata;
+  protected: std::vector<Block> blocks;
+
+  /// \brief Where the footer starts, the next batch overwrites it.
+  protected: int64_t end{0};
+  protected: uint64_t rows{0};
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__ARROW_WRITER_HH_
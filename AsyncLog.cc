@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "AsyncLog.hh"
+
+#include <chrono>
+#include <sstream>
+
+#include <ignition/common/Console.hh>
+
+namespace
+{
+
+const size_t kLogBufferCapacity = 1024;
+const int64_t kLogSiteWindow = 1000000000;
+const std::chrono::milliseconds kLogFlushPeriod{20};
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+AsyncLog &AsyncLog::Instance()
+{
+  static AsyncLog instance;
+  return instance;
+}
+
+//////////////////////////////////////////////////
+AsyncLog::AsyncLog()
+  : queue(kLogBufferCapacity)
+{
+  this->thread = std::thread(&AsyncLog::Run, this);
+}
+
+//////////////////////////////////////////////////
+AsyncLog::~AsyncLog()
+{
+  this->Stop();
+}
+
+//////////////////////////////////////////////////
+void AsyncLog::Stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->wakeMutex);
+    this->running = false;
+  }
+  this->wake.notify_all();
+  if (this->thread.joinable())
+    this->thread.join();
+}
+
+//////////////////////////////////////////////////
+AsyncLogStats AsyncLog::Stats() const
+{
+  AsyncLogStats stats;
+  const auto queueStats = this->queue.Stats();
+  stats.written = this->written.load(std::memory_order_relaxed);
+  stats.suppressed = this->suppressed.load(std::memory_order_relaxed);
+  stats.dropped = queueStats.dropped + queueStats.overflowed;
+  return stats;
+}
+
+//////////////////////////////////////////////////
+int64_t AsyncLog::Now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//////////////////////////////////////////////////
+bool AsyncLog::Admit(LogSite &_site, int64_t _now)
+{
+  int64_t start = _site.windowStart.load(std::memory_order_relaxed);
+  if (_now - start >= kLogSiteWindow)
+  {
+    // Whoever wins the exchange opens the new window, concurrent callers
+    // losing it just count against the window that was opened.
+    if (_site.windowStart.compare_exchange_strong(start, _now,
+          std::memory_order_relaxed))
+    {
+      _site.windowCount.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  if (_site.windowCount.fetch_add(1, std::memory_order_relaxed) <
+      kLogSiteRate)
+  {
+    return true;
+  }
+  _site.suppressed.fetch_add(1, std::memory_order_relaxed);
+  this->suppressed.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+//////////////////////////////////////////////////
+void AsyncLog::Push(const Record &_record)
+{
+  this->queue.Push(_record);
+}
+
+//////////////////////////////////////////////////
+void AsyncLog::Run()
+{
+  uint64_t reportedDropped = 0;
+  auto print = [this](const Record &_record)
+  {
+    const std::string text = this->Format(_record);
+    switch (_record.site->level)
+    {
+      case LogLevel::kError:
+        ignerr << text << std::endl;
+        break;
+      case LogLevel::kWarning:
+        ignwarn << text << std::endl;
+        break;
+      case LogLevel::kMessage:
+        ignmsg << text << std::endl;
+        break;
+      case LogLevel::kDebug:
+        igndbg << text << std::endl;
+        break;
+    }
+    this->written.fetch_add(1, std::memory_order_relaxed);
+  };
+
+  while (true)
+  {
+    const bool stopping = !this->running.load();
+    const size_t count = this->queue.Drain(print);
+
+    const auto queueStats = this->queue.Stats();
+    const uint64_t dropped = queueStats.dropped + queueStats.overflowed;
+    if (dropped > reportedDropped)
+    {
+      ignwarn << "Log buffers full, dropped " << dropped - reportedDropped <<
+        " messages" << std::endl;
+      reportedDropped = dropped;
+    }
+
+    if (stopping && count == 0)
+      break;
+    if (count == 0)
+    {
+      std::unique_lock<std::mutex> lock(this->wakeMutex);
+      this->wake.wait_for(lock, kLogFlushPeriod,
+          [this]() { return !this->running.load(); });
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+std::string AsyncLog::Format(const Record &_record) const
+{
+  std::ostringstream oss;
+  size_t next = 0;
+  for (const char *c = _record.site->format; *c; ++c)
+  {
+    if (c[0] == '{' && c[1] == '}' && next < _record.numArgs)
+    {
+      const Arg &arg = _record.args[next];
+      switch (_record.types[next])
+      {
+        case ArgType::kInt:
+          oss << arg.i;
+          break;
+        case ArgType::kUnsigned:
+          oss << arg.u;
+          break;
+        case ArgType::kDouble:
+          oss << arg.d;
+          break;
+        case ArgType::kString:
+          oss << (arg.s ? arg.s : "(null)");
+          break;
+        case ArgType::kPointer:
+          oss << arg.p;
+          break;
+      }
+      ++next;
+      ++c;
+      continue;
+    }
+    oss << *c;
+  }
+
+  // Report rate limited messages along with the next one that gets through.
+  const uint64_t suppressedHere =
+    _record.site->suppressed.exchange(0, std::memory_order_relaxed);
+  if (suppressedHere > 0)
+    oss << " (" << suppressedHere << " similar messages suppressed)";
+  return oss.str();
+}
+
+}  // namespace ign_imgui
@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__ASYNC_LOG_HH_
+#define IGN_IMGUI__ASYNC_LOG_HH_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include "IngestQueue.hh"
+
+/// \brief Log from any thread without blocking, e.g.
+///   IGN_IMGUI_LOG_WARN("dropped {} samples at {}s", count, simTime);
+///
+/// Arguments are copied as integers, floating point values or pointers to
+/// string literals and formatted later on the log thread, so only pass
+/// strings that outlive the process. Each call site is limited to
+/// kLogSiteRate messages per second, the rest are counted and reported.
+#define IGN_IMGUI_LOG(_level, _format, ...) \
+  do { \
+    static ign_imgui::LogSite ignImguiLogSite{ \
+      __FILE__, __LINE__, _level, _format}; \
+    ign_imgui::AsyncLog::Instance().Write(ignImguiLogSite, ##__VA_ARGS__); \
+  } while (false)
+
+#define IGN_IMGUI_LOG_ERR(...) \
+  IGN_IMGUI_LOG(ign_imgui::LogLevel::kError, __VA_ARGS__)
+#define IGN_IMGUI_LOG_WARN(...) \
+  IGN_IMGUI_LOG(ign_imgui::LogLevel::kWarning, __VA_ARGS__)
+#define IGN_IMGUI_LOG_MSG(...) \
+  IGN_IMGUI_LOG(ign_imgui::LogLevel::kMessage, __VA_ARGS__)
+#define IGN_IMGUI_LOG_DBG(...) \
+  IGN_IMGUI_LOG(ign_imgui::LogLevel::kDebug, __VA_ARGS__)
+
+namespace ign_imgui
+{
+
+enum class LogLevel
+{
+  kError,
+  kWarning,
+  kMessage,
+  kDebug
+};
+
+/// \brief Static state of one logging statement.
+struct LogSite
+{
+  const char *file;
+  int line;
+  LogLevel level;
+  const char *format;
+
+  /// \brief Start of the current one second rate window, in nanoseconds.
+  std::atomic<int64_t> windowStart{0};
+  std::atomic<uint32_t> windowCount{0};
+  /// \brief Messages rejected by the rate limit and not yet reported.
+  std::atomic<uint64_t> suppressed{0};
+};
+
+/// \brief Totals of messages that never made it to the console.
+struct AsyncLogStats
+{
+  uint64_t written{0};
+  /// \brief Rejected by a call site's rate limit.
+  uint64_t suppressed{0};
+  /// \brief Lost because the calling thread's buffer was full.
+  uint64_t dropped{0};
+};
+
+/// \brief Background formatter behind IGN_IMGUI_LOG.
+///
+/// Write() only copies a fixed size binary record into a per-thread ring of
+/// an IngestQueue, so it never takes a lock, allocates or touches the
+/// console. The log thread formats records and hands them to the ignition
+/// console, which still applies its verbosity level.
+class AsyncLog
+{
+  public: static constexpr size_t kMaxArgs = 6;
+  public: static constexpr uint32_t kLogSiteRate = 10;
+
+  public: static AsyncLog &Instance();
+
+  public: ~AsyncLog();
+
+  public: template<typename... Args>
+  void Write(LogSite &_site, const Args &... _args)
+  {
+    static_assert(sizeof...(Args) <= kMaxArgs, "too many log arguments");
+    const int64_t now = Now();
+    if (!this->Admit(_site, now))
+      return;
+
+    Record record;
+    record.site = &_site;
+    record.time = now;
+    record.numArgs = 0;
+    // Expand the pack in order, one Pack() per argument.
+    int expand[] = {0, (this->Pack(record, _args), 0)...};
+    static_cast<void>(expand);
+    this->Push(record);
+  }
+
+  /// \brief Format everything written so far and stop the log thread.
+  /// Later messages are buffered but not printed.
+  public: void Stop();
+
+  public: AsyncLogStats Stats() const;
+
+  protected: AsyncLog();
+
+  protected: enum class ArgType : uint8_t
+  {
+    kInt,
+    kUnsigned,
+    kDouble,
+    kString,
+    kPointer
+  };
+
+  protected: union Arg
+  {
+    int64_t i;
+    uint64_t u;
+    double d;
+    const char *s;
+    const void *p;
+  };
+
+  protected: struct Record
+  {
+    LogSite *site;
+    int64_t time;
+    uint8_t numArgs;
+    ArgType types[kMaxArgs];
+    Arg args[kMaxArgs];
+  };
+
+  protected: template<typename T>
+  static void Pack(Record &_record, const T &_value)
+  {
+    Arg &arg = _record.args[_record.numArgs];
+    ArgType &type = _record.types[_record.numArgs];
+    ++_record.numArgs;
+    if constexpr (std::is_same<T, bool>::value)
+    {
+      type = ArgType::kString;
+      arg.s = _value ? "true" : "false";
+    }
+    else if constexpr (std::is_floating_point<T>::value)
+    {
+      type = ArgType::kDouble;
+      arg.d = _value;
+    }
+    else if constexpr (std::is_signed<T>::value || std::is_enum<T>::value)
+    {
+      type = ArgType::kInt;
+      arg.i = static_cast<int64_t>(_value);
+    }
+    else if constexpr (std::is_unsigned<T>::value)
+    {
+      type = ArgType::kUnsigned;
+      arg.u = _value;
+    }
+    else if constexpr (std::is_convertible<T, const char *>::value)
+    {
+      type = ArgType::kString;
+      arg.s = _value;
+    }
+    else
+    {
+      static_assert(std::is_pointer<T>::value,
+          "log arguments must be numbers, string literals or pointers");
+      type = ArgType::kPointer;
+      arg.p = _value;
+    }
+  }
+
+  /// \brief Monotonic time in nanoseconds.
+  protected: static int64_t Now();
+
+  /// \brief Apply the call site rate limit.
+  protected: bool Admit(LogSite &_site, int64_t _now);
+
+  protected: void Push(const Record &_record);
+
+  protected: void Run();
+
+  protected: std::string Format(const Record &_record) const;
+
+  protected: IngestQueue<Record> queue;
+  protected: std::atomic<uint64_t> suppressed{0};
+  protected: std::atomic<uint64_t> written{0};
+  protected: std::atomic<bool> running{true};
+  protected: std::mutex wakeMutex;
+  protected: std::condition_variable wake;
+  protected: std::thread thread;
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__ASYNC_LOG_HH_
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__BINARY_UTILS_HH_
+#define IGN_IMGUI__BINARY_UTILS_HH_
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#define IGN_IMGUI_CHECK_BINARY(stream) \
+  if (!stream.good()) { \
+    throw std::runtime_error{"failed to parse input binary file"}; \
+  }
+
+namespace ign_imgui
+{
+
+template<typename T>
+void WriteBinary(std::ostream & ost, const T & value)
+{
+  static_assert(std::is_trivially_copyable<T>::value,
+      "only trivially copyable values can be written as binary");
+  ost.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template<typename T>
+void ReadBinary(std::istream & ist, T & value)
+{
+  static_assert(std::is_trivially_copyable<T>::value,
+      "only trivially copyable values can be read as binary");
+  ist.read(reinterpret_cast<char *>(&value), sizeof(T));
+  IGN_IMGUI_CHECK_BINARY(ist);
+}
+
+template<typename T>
+void WriteBinary(std::ostream & ost, const std::vector<T> & values)
+{
+  WriteBinary(ost, static_cast<uint64_t>(values.size()));
+  ost.write(reinterpret_cast<const char *>(values.data()),
+      values.size() * sizeof(T));
+}
+
+/// \brief Throw unless _count elements of _elementSize bytes are left
+/// after the read position, so a corrupt count fails before anything is
+/// allocated for it. Streams that can't seek are only checked by the read.
+inline void CheckBinaryCount(std::istream & ist, uint64_t _count,
+    size_t _elementSize)
+{
+  const std::istream::pos_type pos = ist.tellg();
+  if (pos == std::istream::pos_type(-1) || _elementSize == 0)
+    return;
+  ist.seekg(0, std::ios::end);
+  const std::istream::pos_type end = ist.tellg();
+  ist.seekg(pos);
+  IGN_IMGUI_CHECK_BINARY(ist);
+  if (end < pos || _count > static_cast<uint64_t>(end - pos) / _elementSize)
+    throw std::runtime_error{"failed to parse input binary file"};
+}
+
+template<typename T>
+void ReadBinary(std::istream & ist, std::vector<T> & values)
+{
+  uint64_t size;
+  ReadBinary(ist, size);
+  CheckBinaryCount(ist, size, sizeof(T));
+  values.resize(size);
+  ist.read(reinterpret_cast<char *>(values.data()), size * sizeof(T));
+  IGN_IMGUI_CHECK_BINARY(ist);
+}
+
+inline void WriteBinary(std::ostream & ost, const std::string & value)
+{
+  WriteBinary(ost, static_cast<uint64_t>(value.size()));
+  ost.write(value.data(), value.size());
+}
+
+inline void ReadBinary(std::istream & ist, std::string & value)
+{
+  uint64_t size;
+  ReadBinary(ist, size);
+  CheckBinaryCount(ist, size, 1);
+  value.resize(size);
+  ist.read(&value[0], size);
+  IGN_IMGUI_CHECK_BINARY(ist);
+}
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__BINARY_UTILS_HH_
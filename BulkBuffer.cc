@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "BulkBuffer.hh"
+
+#include <algorithm>
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+BulkBuffer::BulkBuffer(size_t _chunkSize)
+{
+  const size_t chunkSize = std::max<size_t>(_chunkSize, 1);
+  this->samples.resize(chunkSize);
+  this->rtf.resize(chunkSize);
+  this->rtfFloat.resize(chunkSize);
+  this->steady.resize(chunkSize);
+  this->x.resize(chunkSize);
+}
+
+}  // namespace ign_imgui
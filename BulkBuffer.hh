@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__BULK_BUFFER_HH_
+#define IGN_IMGUI__BULK_BUFFER_HH_
+
+#include <cstdlib>
+
+#include <vector>
+
+#include "Reservoir.hh"
+
+namespace ign_imgui
+{
+
+/// \brief Fixed-size chunk of raw RTF samples waiting to be aggregated.
+///
+/// Samples are stored column by column, so a full chunk can be handed
+/// straight to the batched InsertData() of each accumulator. Appending is a
+/// few stores and an index bump.
+class BulkBuffer
+{
+  public: static constexpr size_t kDefaultChunkSize = 4096;
+
+  public: explicit BulkBuffer(size_t _chunkSize = kDefaultChunkSize);
+
+  /// \brief Append one sample.
+  /// \param[in] _steady Local receive time, see SteadySeconds().
+  /// \param[in] _x Value plotted against the RTF in the 2D histogram.
+  /// \return True once the chunk is full and must be flushed.
+  public: inline bool Append(const RtfSample &_sample, double _steady,
+                             float _x)
+  {
+    this->samples[this->size] = _sample;
+    this->rtf[this->size] = _sample.rtf;
+    this->rtfFloat[this->size] = static_cast<float>(_sample.rtf);
+    this->steady[this->size] = _steady;
+    this->x[this->size] = _x;
+    return ++this->size == this->samples.size();
+  }
+
+  public: size_t Size() const { return this->size; }
+  public: bool Empty() const { return this->size == 0; }
+  public: void Clear() { this->size = 0; }
+
+  public: const RtfSample *Samples() const { return this->samples.data(); }
+  public: const double *Rtf() const { return this->rtf.data(); }
+  public: const float *RtfFloat() const { return this->rtfFloat.data(); }
+  public: const double *Steady() const { return this->steady.data(); }
+  public: const float *X() const { return this->x.data(); }
+
+  protected: size_t size{0};
+  protected: std::vector<RtfSample> samples;
+  protected: std::vector<double> rtf;
+  protected: std::vector<float> rtfFloat;
+  protected: std::vector<double> steady;
+  protected: std::vector<float> x;
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__BULK_BUFFER_HH_
@@ -0,0 +1,304 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "CApi.h"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Export.hh"
+#include "MappedFile.hh"
+
+/// \brief Everything an export holds, plus the views handed out to callers.
+struct ign_imgui_export
+{
+  ign_imgui::Moments moments;
+  ign_imgui::Distribution distribution;
+  ign_imgui::Reservoir reservoir;
+  ign_imgui::LaggedCorrelation correlation;
+  ign_imgui::Histogram2D hist2d;
+  ign_imgui::IntervalHeatmap intervals;
+  std::vector<ign_imgui::Gap> gaps;
+  double simTime{0.0};
+  double realTime{0.0};
+
+  /// \brief Snapshot returned by ign_imgui_export_stats().
+  ign_imgui_stats stats{};
+
+  /// \brief Dense counts, pointing into the distribution back-end.
+  const uint64_t *denseCounts{nullptr};
+  size_t denseBuckets{0};
+
+  /// \brief Dense: -inf, the bin edges, +inf, so lower and upper are the
+  /// same array offset by one. Otherwise the lower bucket edges.
+  std::vector<double> lower;
+  std::vector<double> upper;
+  std::vector<uint64_t> counts;
+};
+
+namespace
+{
+
+//////////////////////////////////////////////////
+std::string &LastError()
+{
+  static thread_local std::string error;
+  return error;
+}
+
+//////////////////////////////////////////////////
+/// \brief Refresh the views after the accumulators changed.
+void Snapshot(ign_imgui_export &_handle)
+{
+  const auto &moments = _handle.moments;
+  const uint64_t count = moments.Count();
+  _handle.stats = {count, moments.Mean(), moments.Variance(),
+                   count ? moments.Min() : 0.0, count ? moments.Max() : 0.0,
+                   moments.Skewness(), moments.Kurtosis()};
+
+  ign_imgui::HistogramAxis axis;
+  _handle.denseCounts = _handle.distribution.DenseCounts(axis);
+  if (_handle.denseCounts)
+  {
+    const double inf = std::numeric_limits<double>::infinity();
+    const size_t numBins = axis.NumBins();
+    _handle.denseBuckets = numBins + 2;
+    _handle.lower.resize(numBins + 3);
+    _handle.lower.front() = -inf;
+    for (size_t ii = 0; ii <= numBins; ++ii)
+      _handle.lower[ii + 1] = axis.Edge(ii);
+    _handle.lower.back() = inf;
+    _handle.upper.clear();
+    _handle.counts.clear();
+  }
+  else
+  {
+    _handle.denseBuckets = 0;
+    _handle.distribution.Buckets(_handle.lower, _handle.upper,
+                                 _handle.counts);
+  }
+}
+
+//////////////////////////////////////////////////
+template<typename Fn>
+auto Guard(Fn &&_fn, decltype(_fn()) _failed) -> decltype(_fn())
+{
+  try
+  {
+    LastError().clear();
+    return _fn();
+  }
+  catch (const std::exception &_e)
+  {
+    LastError() = _e.what();
+  }
+  catch (...)
+  {
+    LastError() = "unknown error";
+  }
+  return _failed;
+}
+
+}  // namespace
+
+extern "C"
+{
+
+//////////////////////////////////////////////////
+int ign_imgui_api_version(void)
+{
+  return IGN_IMGUI_API_VERSION;
+}
+
+//////////////////////////////////////////////////
+const char *ign_imgui_last_error(void)
+{
+  return LastError().c_str();
+}
+
+//////////////////////////////////////////////////
+ign_imgui_export *ign_imgui_export_load(const char *path)
+{
+  return Guard([&]() -> ign_imgui_export *
+  {
+    if (!path)
+      throw std::invalid_argument{"null path"};
+
+    auto handle = std::make_unique<ign_imgui_export>();
+    ign_imgui::MappedFile mapped;
+    mapped.Open(path);
+    ign_imgui::MemoryStreamBuf buf(mapped.Data(), mapped.Size());
+    std::istream ist(&buf);
+    if (ign_imgui::IsCheckpoint(mapped.Data(), mapped.Size()))
+    {
+      const auto checkpoint = ign_imgui::FromBinary(ist, handle->moments,
+          handle->distribution, handle->reservoir, handle->correlation,
+          handle->hist2d, handle->intervals);
+      handle->gaps = checkpoint.gaps;
+      handle->simTime = checkpoint.simTime;
+      handle->realTime = checkpoint.realTime;
+    }
+    else
+    {
+      const auto data = ign_imgui::FromCsv(ist, handle->distribution,
+          handle->reservoir, handle->correlation, handle->hist2d,
+          handle->intervals);
+      handle->moments.SetSummary(data.count, data.mean, data.var,
+          data.skewness, data.kurtosis, data.min, data.max);
+      handle->gaps = data.gaps;
+      handle->simTime = data.simTime;
+      handle->realTime = data.realTime;
+    }
+    Snapshot(*handle);
+    return handle.release();
+  }, nullptr);
+}
+
+//////////////////////////////////////////////////
+ign_imgui_export *ign_imgui_export_create(void)
+{
+  return Guard([]() -> ign_imgui_export *
+  {
+    auto handle = std::make_unique<ign_imgui_export>();
+    Snapshot(*handle);
+    return handle.release();
+  }, nullptr);
+}
+
+//////////////////////////////////////////////////
+int ign_imgui_export_merge(ign_imgui_export *dst, const ign_imgui_export *src)
+{
+  return Guard([&]()
+  {
+    if (!dst || !src)
+      throw std::invalid_argument{"null handle"};
+    if (dst == src)
+      throw std::invalid_argument{"cannot merge a handle into itself"};
+
+    dst->moments.Merge(src->moments);
+    dst->distribution.Merge(src->distribution);
+    dst->reservoir.Merge(src->reservoir);
+    dst->gaps.insert(dst->gaps.end(), src->gaps.begin(), src->gaps.end());
+    dst->simTime = std::max(dst->simTime, src->simTime);
+    dst->realTime = std::max(dst->realTime, src->realTime);
+    Snapshot(*dst);
+    return 0;
+  }, -1);
+}
+
+//////////////////////////////////////////////////
+void ign_imgui_export_free(ign_imgui_export *handle)
+{
+  delete handle;
+}
+
+//////////////////////////////////////////////////
+const ign_imgui_stats *ign_imgui_export_stats(const ign_imgui_export *handle)
+{
+  return handle ? &handle->stats : nullptr;
+}
+
+//////////////////////////////////////////////////
+int ign_imgui_export_histogram(const ign_imgui_export *handle,
+                               ign_imgui_histogram *out)
+{
+  if (!handle || !out)
+  {
+    LastError() = "null argument";
+    return -1;
+  }
+
+  if (handle->denseCounts)
+  {
+    out->num_buckets = handle->denseBuckets;
+    out->counts = handle->denseCounts;
+    out->lower = handle->lower.data();
+    out->upper = handle->lower.data() + 1;
+  }
+  else
+  {
+    out->num_buckets = handle->counts.size();
+    out->counts = handle->counts.data();
+    out->lower = handle->lower.data();
+    out->upper = handle->upper.data();
+  }
+  out->total = handle->distribution.Count();
+  return 0;
+}
+
+//////////////////////////////////////////////////
+double ign_imgui_export_quantile(const ign_imgui_export *handle, double q)
+{
+  if (!handle)
+    return std::numeric_limits<double>::quiet_NaN();
+  return handle->distribution.Quantile(q);
+}
+
+//////////////////////////////////////////////////
+double ign_imgui_export_sim_time(const ign_imgui_export *handle)
+{
+  return handle ? handle->simTime : 0.0;
+}
+
+//////////////////////////////////////////////////
+double ign_imgui_export_real_time(const ign_imgui_export *handle)
+{
+  return handle ? handle->realTime : 0.0;
+}
+
+//////////////////////////////////////////////////
+int ign_imgui_export_save(const ign_imgui_export *handle, const char *path,
+                          int format)
+{
+  return Guard([&]()
+  {
+    if (!handle || !path)
+      throw std::invalid_argument{"null argument"};
+    // Before the file is opened, so a bad call doesn't truncate it.
+    if (format != IGN_IMGUI_FORMAT_CSV && format != IGN_IMGUI_FORMAT_CHECKPOINT)
+      throw std::invalid_argument{"unknown format"};
+
+    std::ofstream fs(path, std::ios::binary | std::ios::trunc);
+    if (format == IGN_IMGUI_FORMAT_CSV)
+    {
+      ign_imgui::ToCsv(fs, handle->moments, handle->distribution,
+          handle->reservoir, handle->correlation, handle->hist2d,
+          handle->intervals, handle->gaps, handle->simTime,
+          handle->realTime);
+    }
+    else
+    {
+      ign_imgui::ToBinary(fs, handle->moments, handle->distribution,
+          handle->reservoir, handle->correlation, handle->hist2d,
+          handle->intervals, handle->gaps, handle->simTime,
+          handle->realTime);
+    }
+    fs.flush();
+    if (!fs.good())
+      throw std::runtime_error{"failed to write output file"};
+    return 0;
+  }, -1);
+}
+
+}  // extern "C"
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__C_API_H_
+#define IGN_IMGUI__C_API_H_
+
+/* C interface of libign_imgui_c, for analysis scripts (Python ctypes, Rust)
+ * that want the accumulated data without parsing CSV exports.
+ *
+ * An export handle holds everything a CSV export or binary checkpoint
+ * holds. Pointers returned for a handle are read-only views into it: they
+ * stay valid until the handle is next merged into or freed, and are never
+ * to be freed by the caller. A handle may be used from one thread at
+ * a time. Functions that fail return NULL or -1 and leave a message for
+ * ign_imgui_last_error(). */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  define IGN_IMGUI_C_EXPORT __declspec(dllexport)
+#else
+#  define IGN_IMGUI_C_EXPORT __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped whenever a struct layout or function signature changes. */
+#define IGN_IMGUI_API_VERSION 1
+
+#define IGN_IMGUI_FORMAT_CSV 0
+#define IGN_IMGUI_FORMAT_CHECKPOINT 1
+
+typedef struct ign_imgui_export ign_imgui_export;
+
+/* Summary statistics of the RTF samples. Min and max are 0 when empty. */
+typedef struct ign_imgui_stats
+{
+  uint64_t count;
+  double mean;
+  double variance;
+  double min;
+  double max;
+  double skewness;
+  double kurtosis;
+} ign_imgui_stats;
+
+/* Buckets of the RTF distribution, bucket i spans [lower[i], upper[i]).
+ * For the dense back-end counts points straight at the accumulated bins:
+ * bucket 0 is the underflow with lower -inf, the last bucket the overflow
+ * with upper +inf, and empty bins are included. Other back-ends list their
+ * non-empty buckets only. */
+typedef struct ign_imgui_histogram
+{
+  size_t num_buckets;
+  const uint64_t *counts;
+  const double *lower;
+  const double *upper;
+  uint64_t total;
+} ign_imgui_histogram;
+
+IGN_IMGUI_C_EXPORT int ign_imgui_api_version(void);
+
+/* Message of the last failure on the calling thread, empty if none. */
+IGN_IMGUI_C_EXPORT const char *ign_imgui_last_error(void);
+
+/* Load a CSV export or binary checkpoint, told apart by the file header. */
+IGN_IMGUI_C_EXPORT ign_imgui_export *ign_imgui_export_load(const char *path);
+
+/* Empty handle, e.g. to merge several exports into. */
+IGN_IMGUI_C_EXPORT ign_imgui_export *ign_imgui_export_create(void);
+
+/* Add the samples of src to dst: stats, distribution, reservoir and gaps.
+ * The windowed views (correlation, 2D histogram, intervals) of dst are
+ * kept as they are. */
+IGN_IMGUI_C_EXPORT int ign_imgui_export_merge(ign_imgui_export *dst,
+                                              const ign_imgui_export *src);
+
+IGN_IMGUI_C_EXPORT void ign_imgui_export_free(ign_imgui_export *handle);
+
+IGN_IMGUI_C_EXPORT const ign_imgui_stats *ign_imgui_export_stats(
+    const ign_imgui_export *handle);
+
+IGN_IMGUI_C_EXPORT int ign_imgui_export_histogram(
+    const ign_imgui_export *handle, ign_imgui_histogram *out);
+
+/* Value below which a fraction q of the samples fall, NaN when empty. */
+IGN_IMGUI_C_EXPORT double ign_imgui_export_quantile(
+    const ign_imgui_export *handle, double q);
+
+/* Sim and real time of the last sample, in seconds. */
+IGN_IMGUI_C_EXPORT double ign_imgui_export_sim_time(
+    const ign_imgui_export *handle);
+IGN_IMGUI_C_EXPORT double ign_imgui_export_real_time(
+    const ign_imgui_export *handle);
+
+/* Write the handle as IGN_IMGUI_FORMAT_CSV or IGN_IMGUI_FORMAT_CHECKPOINT.
+ * Stats loaded from a CSV export only keep the precision the CSV had. */
+IGN_IMGUI_C_EXPORT int ign_imgui_export_save(const ign_imgui_export *handle,
+                                             const char *path, int format);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* IGN_IMGUI__C_API_H_ */
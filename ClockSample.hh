@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__CLOCK_SAMPLE_HH_
+#define IGN_IMGUI__CLOCK_SAMPLE_HH_
+
+#include <cstdint>
+
+#include <ignition/common/Time.hh>
+#include <ignition/msgs.hh>
+
+namespace ign_imgui
+{
+
+/// \brief Clock message as handed from the transport callbacks to the
+/// ingest thread, plain data so it can live in an IngestQueue slot.
+struct ClockSample
+{
+  int64_t simSec{0};
+  int32_t simNsec{0};
+  int64_t realSec{0};
+  int32_t realNsec{0};
+  /// \brief SteadySeconds() when the message was received.
+  double steady{0.0};
+
+  ignition::common::Time Sim() const
+  {
+    return ignition::common::Time(this->simSec, this->simNsec);
+  }
+
+  ignition::common::Time Real() const
+  {
+    return ignition::common::Time(this->realSec, this->realNsec);
+  }
+
+  int64_t SimNs() const
+  {
+    return this->simSec * 1000000000 + this->simNsec;
+  }
+
+  int64_t RealNs() const
+  {
+    return this->realSec * 1000000000 + this->realNsec;
+  }
+};
+
+/// \brief Copy the times of _msg, received at _steady.
+inline ClockSample ToClockSample(const ignition::msgs::Clock &_msg,
+                                 double _steady)
+{
+  ClockSample sample;
+  sample.simSec = _msg.sim().sec();
+  sample.simNsec = _msg.sim().nsec();
+  sample.realSec = _msg.real().sec();
+  sample.realNsec = _msg.real().nsec();
+  sample.steady = _steady;
+  return sample;
+}
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__CLOCK_SAMPLE_HH_
@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "ClockSource.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+const int64_t kNsPerSecond = 1000000000;
+
+/// \brief Longest sleep of the delivery thread, so Stop() is prompt.
+const std::chrono::milliseconds kMaxSleep{100};
+
+//////////////////////////////////////////////////
+int64_t ToNs(const ignition::msgs::Time &_time)
+{
+  return static_cast<int64_t>(_time.sec()) * kNsPerSecond + _time.nsec();
+}
+
+//////////////////////////////////////////////////
+void SetNs(ignition::msgs::Time *_time, int64_t _ns)
+{
+  _time->set_sec(_ns / kNsPerSecond);
+  _time->set_nsec(static_cast<int32_t>(_ns % kNsPerSecond));
+}
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+TransportClockSource::TransportClockSource(const std::string &_topic)
+  : topic(_topic)
+{
+}
+
+//////////////////////////////////////////////////
+TransportClockSource::~TransportClockSource()
+{
+  this->Stop();
+}
+
+//////////////////////////////////////////////////
+void TransportClockSource::Start(Callback _callback)
+{
+  this->Stop();
+  this->callback = std::move(_callback);
+  if (!this->node.Subscribe(this->topic, this->callback))
+    throw std::runtime_error{"failed to subscribe to [" + this->topic + "]"};
+  this->subscribed = true;
+}
+
+//////////////////////////////////////////////////
+void TransportClockSource::Stop()
+{
+  if (this->subscribed)
+    this->node.Unsubscribe(this->topic);
+  this->subscribed = false;
+}
+
+//////////////////////////////////////////////////
+std::vector<ignition::msgs::Clock> FakeClockSource::MakeSequence(
+    size_t _count, double _step, double _rtf, double _jitter, uint32_t _seed)
+{
+  if (!(_step > 0.0) || !(_rtf > 0.0) || !(_jitter >= 0.0 && _jitter < 1.0))
+  {
+    throw std::runtime_error{"fake clock needs a positive step and RTF and "
+      "a jitter in [0, 1)"};
+  }
+
+  // mt19937 is specified exactly, unlike the standard distributions.
+  std::mt19937 random(_seed);
+  const auto simStep = static_cast<int64_t>(std::llround(_step * 1e9));
+  const double realStep = _step / _rtf * 1e9;
+
+  std::vector<ignition::msgs::Clock> sequence(_count);
+  int64_t sim = 0;
+  int64_t real = 0;
+  for (auto &msg : sequence)
+  {
+    SetNs(msg.mutable_sim(), sim);
+    SetNs(msg.mutable_real(), real);
+    const double u = random() / 4294967295.0 * 2.0 - 1.0;
+    sim += simStep;
+    real += static_cast<int64_t>(std::llround(realStep * (1.0 + _jitter * u)));
+  }
+  return sequence;
+}
+
+//////////////////////////////////////////////////
+FakeClockSource::~FakeClockSource()
+{
+  this->Stop();
+}
+
+//////////////////////////////////////////////////
+void FakeClockSource::SetMessages(
+    std::vector<ignition::msgs::Clock> _messages)
+{
+  this->messages = std::move(_messages);
+  this->simSpan = 0;
+  this->realSpan = 0;
+  const size_t count = this->messages.size();
+  if (count < 2)
+    return;
+
+  // One more average step past the last message.
+  const auto &first = this->messages.front();
+  const auto &last = this->messages.back();
+  const int64_t sim = ToNs(last.sim()) - ToNs(first.sim());
+  const int64_t real = ToNs(last.real()) - ToNs(first.real());
+  this->simSpan = sim + sim / static_cast<int64_t>(count - 1);
+  this->realSpan = real + real / static_cast<int64_t>(count - 1);
+}
+
+//////////////////////////////////////////////////
+void FakeClockSource::SetRate(double _rate)
+{
+  if (!(_rate >= 0.0))
+    throw std::runtime_error{"fake clock rate must not be negative"};
+  this->rate = _rate;
+}
+
+//////////////////////////////////////////////////
+double FakeClockSource::Rate() const
+{
+  return this->rate;
+}
+
+//////////////////////////////////////////////////
+void FakeClockSource::SetLoop(bool _loop)
+{
+  this->loop = _loop;
+}
+
+//////////////////////////////////////////////////
+void FakeClockSource::Start(Callback _callback)
+{
+  this->Stop();
+  this->callback = std::move(_callback);
+  this->position = 0;
+  this->simOffset = 0;
+  this->realOffset = 0;
+  this->delivered = 0;
+  this->done = this->messages.empty();
+  this->running = true;
+  if (this->rate > 0.0)
+    this->thread = std::thread(&FakeClockSource::Run, this);
+}
+
+//////////////////////////////////////////////////
+void FakeClockSource::Stop()
+{
+  this->running = false;
+  if (this->thread.joinable())
+    this->thread.join();
+}
+
+//////////////////////////////////////////////////
+size_t FakeClockSource::Inject(size_t _count)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  size_t count = 0;
+  while (count < _count && this->Next())
+    ++count;
+  return count;
+}
+
+//////////////////////////////////////////////////
+void FakeClockSource::Inject(const ignition::msgs::Clock &_msg)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  if (!this->running || !this->callback)
+    return;
+  this->callback(_msg);
+  ++this->delivered;
+}
+
+//////////////////////////////////////////////////
+uint64_t FakeClockSource::Delivered() const
+{
+  return this->delivered;
+}
+
+//////////////////////////////////////////////////
+bool FakeClockSource::Done() const
+{
+  return this->done;
+}
+
+//////////////////////////////////////////////////
+void FakeClockSource::Run()
+{
+  const auto start = Clock::now();
+  uint64_t sent = 0;
+  while (this->running)
+  {
+    // Everything due by now goes out back to back, so high rates don't
+    // depend on how finely the thread can sleep.
+    const double elapsed =
+      std::chrono::duration<double>(Clock::now() - start).count();
+    const auto due = static_cast<uint64_t>(elapsed * this->rate) + 1;
+    if (sent >= due)
+    {
+      const auto next = start + std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(sent / this->rate));
+      std::this_thread::sleep_until(std::min(next, Clock::now() + kMaxSleep));
+      continue;
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (; sent < due && this->running; ++sent)
+    {
+      if (!this->Next())
+        return;
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+bool FakeClockSource::Next()
+{
+  if (!this->running || !this->callback)
+    return false;
+  if (this->position == this->messages.size())
+  {
+    if (!this->loop || this->simSpan == 0)
+    {
+      this->done = true;
+      return false;
+    }
+    this->position = 0;
+    this->simOffset += this->simSpan;
+    this->realOffset += this->realSpan;
+  }
+
+  const auto &msg = this->messages[this->position++];
+  if (this->simOffset == 0 && this->realOffset == 0)
+  {
+    this->callback(msg);
+  }
+  else
+  {
+    this->current = msg;
+    SetNs(this->current.mutable_sim(), ToNs(msg.sim()) + this->simOffset);
+    SetNs(this->current.mutable_real(), ToNs(msg.real()) + this->realOffset);
+    this->callback(this->current);
+  }
+  ++this->delivered;
+  return true;
+}
+
+}  // namespace ign_imgui
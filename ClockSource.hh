@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__CLOCK_SOURCE_HH_
+#define IGN_IMGUI__CLOCK_SOURCE_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ignition/msgs.hh>
+#include <ignition/transport/Node.hh>
+
+namespace ign_imgui
+{
+
+/// \brief Where clock messages come from.
+class ClockSource
+{
+  /// \brief Called for every message, possibly on several threads.
+  public: using Callback = std::function<void(const ignition::msgs::Clock &)>;
+
+  public: virtual ~ClockSource() = default;
+
+  /// \brief Start delivering messages to _callback.
+  public: virtual void Start(Callback _callback) = 0;
+
+  /// \brief Stop delivering messages.
+  public: virtual void Stop() = 0;
+};
+
+/// \brief Messages published on an ign-transport topic.
+class TransportClockSource : public ClockSource
+{
+  public: explicit TransportClockSource(const std::string &_topic = "/clock");
+  public: ~TransportClockSource() override;
+
+  /// \throws std::runtime_error if the subscription fails.
+  public: void Start(Callback _callback) override;
+  public: void Stop() override;
+
+  protected: std::string topic;
+  protected: ignition::transport::Node node;
+  protected: Callback callback;
+  protected: bool subscribed{false};
+};
+
+/// \brief Messages from a fixed sequence, delivered in-process without any
+/// discovery or sockets, for deterministic benchmarks and runs without a
+/// simulator.
+///
+/// With a rate of 0 nothing is delivered until Inject() is called, which
+/// runs the callback on the calling thread. Otherwise a thread delivers the
+/// sequence at Rate() messages per second from Start() on, catching up
+/// without sleeping when it falls behind.
+class FakeClockSource : public ClockSource
+{
+  /// \brief _count messages _step seconds of sim time apart, starting at 0,
+  /// with real time advancing _step / _rtf per message, each step scaled by
+  /// a uniform factor in [1 - _jitter, 1 + _jitter]. The same _seed gives
+  /// the same sequence on every platform.
+  public: static std::vector<ignition::msgs::Clock> MakeSequence(
+      size_t _count, double _step, double _rtf, double _jitter,
+      uint32_t _seed);
+
+  public: FakeClockSource() = default;
+  public: ~FakeClockSource() override;
+
+  public: FakeClockSource(const FakeClockSource &) = delete;
+  public: FakeClockSource &operator=(const FakeClockSource &) = delete;
+
+  /// \brief Messages to deliver, set before Start().
+  public: void SetMessages(std::vector<ignition::msgs::Clock> _messages);
+
+  /// \brief Messages per second, 0 to only deliver on Inject().
+  public: void SetRate(double _rate);
+  public: double Rate() const;
+
+  /// \brief Start over at the end of the sequence, with sim and real time
+  /// shifted on so they keep increasing.
+  public: void SetLoop(bool _loop);
+
+  public: void Start(Callback _callback) override;
+  public: void Stop() override;
+
+  /// \brief Deliver the next _count messages on this thread.
+  /// \return Messages delivered, fewer at the end of a sequence that
+  /// doesn't loop.
+  public: size_t Inject(size_t _count = 1);
+
+  /// \brief Deliver _msg on this thread, outside the sequence.
+  public: void Inject(const ignition::msgs::Clock &_msg);
+
+  /// \brief Messages delivered since Start().
+  public: uint64_t Delivered() const;
+
+  /// \brief True once a sequence that doesn't loop is exhausted.
+  public: bool Done() const;
+
+  protected: void Run();
+
+  /// \brief Deliver the next message of the sequence, false if none.
+  protected: bool Next();
+
+  protected: std::vector<ignition::msgs::Clock> messages;
+  protected: double rate{0.0};
+  protected: bool loop{false};
+
+  protected: Callback callback;
+  protected: size_t position{0};
+
+  /// \brief Nanoseconds one pass through the sequence advances the times.
+  protected: int64_t simSpan{0};
+  protected: int64_t realSpan{0};
+
+  /// \brief Offsets of the current pass through the sequence.
+  protected: int64_t simOffset{0};
+  protected: int64_t realOffset{0};
+  protected: ignition::msgs::Clock current;
+
+  /// \brief Held while delivering, Inject() and the thread may both run.
+  protected: std::mutex mutex;
+  protected: std::atomic<uint64_t> delivered{0};
+  protected: std::atomic<bool> running{false};
+  protected: std::atomic<bool> done{false};
+  protected: std::thread thread;
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__CLOCK_SOURCE_HH_
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DatagramSource.hh"
+
+// Sends clock records over loopback UDP and a Unix datagram socket as fast
+// as one thread can with sendmmsg(), and reports what a DatagramSource
+// receives, for 1 to 64 records per datagram.
+
+namespace
+{
+
+const double kDefaultSeconds = 2.0;
+const int kDefaultPort = 47011;
+const char *kUnixPath = "/tmp/ign_imgui_datagram_benchmark.sock";
+const size_t kRecordsPerDatagram[] = {1, 8, 64};
+const size_t kSendBatch = 64;
+
+using Clock = std::chrono::steady_clock;
+
+struct Result
+{
+  uint64_t sent{0};
+  ign_imgui::DatagramSourceStats stats;
+  double seconds{0.0};
+};
+
+//////////////////////////////////////////////////
+Result Run(const std::string &_address, const sockaddr *_to,
+           socklen_t _toSize, int _family, size_t _records, double _seconds)
+{
+  std::atomic<uint64_t> received{0};
+  ign_imgui::DatagramSource source;
+  source.Start(_address,
+      [&](const ign_imgui::DatagramRecord *, size_t _count)
+      {
+        received.fetch_add(_count, std::memory_order_relaxed);
+      });
+
+  const int fd = socket(_family, SOCK_DGRAM, 0);
+  const size_t size = _records * ign_imgui::kDatagramRecordSize;
+  std::vector<uint8_t> payload(kSendBatch * size);
+  std::vector<iovec> iovecs(kSendBatch);
+  std::vector<mmsghdr> headers(kSendBatch);
+
+  Result result;
+  int64_t sim = 0;
+  const auto start = Clock::now();
+  const auto end = start + std::chrono::duration<double>(_seconds);
+  while (Clock::now() < end)
+  {
+    for (size_t ii = 0; ii < kSendBatch; ++ii)
+    {
+      for (size_t rr = 0; rr < _records; ++rr)
+      {
+        ign_imgui::DatagramRecord record;
+        record.sim = sim;
+        record.real = sim;
+        sim += 1000000;
+        ign_imgui::EncodeDatagramRecord(record,
+            &payload[ii * size + rr * ign_imgui::kDatagramRecordSize]);
+      }
+      iovecs[ii].iov_base = &payload[ii * size];
+      iovecs[ii].iov_len = size;
+      std::memset(&headers[ii], 0, sizeof(headers[ii]));
+      headers[ii].msg_hdr.msg_name = const_cast<sockaddr *>(_to);
+      headers[ii].msg_hdr.msg_namelen = _toSize;
+      headers[ii].msg_hdr.msg_iov = &iovecs[ii];
+      headers[ii].msg_hdr.msg_iovlen = 1;
+    }
+    const int sent = sendmmsg(fd, headers.data(), kSendBatch, 0);
+    if (sent > 0)
+      result.sent += sent * _records;
+  }
+
+  // Let the receiver catch up with what is still queued.
+  uint64_t before = UINT64_MAX;
+  while (before != received.load())
+  {
+    before = received.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  close(fd);
+  source.Stop();
+  result.stats = source.Stats();
+  return result;
+}
+
+//////////////////////////////////////////////////
+void Print(const char *_name, size_t _records, const Result &_result)
+{
+  std::printf("%-6s %8zu %12.2f %12.2f %12llu %12llu %10.1f\n", _name,
+      _records, _result.sent / _result.seconds / 1e6,
+      _result.stats.records / _result.seconds / 1e6,
+      static_cast<unsigned long long>(_result.sent - _result.stats.records),
+      static_cast<unsigned long long>(_result.stats.socketDrops),
+      _result.stats.batches ?
+        static_cast<double>(_result.stats.datagrams) / _result.stats.batches :
+        0.0);
+}
+
+}  // namespace
+
+//////////////////////////////////////////////////
+int main(int _argc, char **_argv)
+{
+  double seconds = kDefaultSeconds;
+  int port = kDefaultPort;
+  for (int i = 1; i < _argc; ++i)
+  {
+    if (i + 1 < _argc && 0 == strcmp(_argv[i], "--seconds"))
+    {
+      seconds = std::stod(_argv[++i]);
+      continue;
+    }
+    if (i + 1 < _argc && 0 == strcmp(_argv[i], "--port"))
+    {
+      port = std::stoi(_argv[++i]);
+      continue;
+    }
+    std::printf("%s [--seconds <SECONDS>] [--port <UDP_PORT>]\n", _argv[0]);
+    return 0;
+  }
+
+  sockaddr_in udp;
+  std::memset(&udp, 0, sizeof(udp));
+  udp.sin_family = AF_INET;
+  udp.sin_port = htons(static_cast<uint16_t>(port));
+  udp.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  sockaddr_un unixAddr;
+  std::memset(&unixAddr, 0, sizeof(unixAddr));
+  unixAddr.sun_family = AF_UNIX;
+  std::strncpy(unixAddr.sun_path, kUnixPath, sizeof(unixAddr.sun_path) - 1);
+
+  std::printf("%-6s %8s %12s %12s %12s %12s %10s\n", "socket", "records",
+      "sent M/s", "recv M/s", "lost", "sock drops", "dgram/call");
+  for (size_t records : kRecordsPerDatagram)
+  {
+    Print("udp", records, Run("udp:" + std::to_string(port),
+          reinterpret_cast<sockaddr *>(&udp), sizeof(udp), AF_INET, records,
+          seconds));
+    Print("unix", records, Run(std::string("unix:") + kUnixPath,
+          reinterpret_cast<sockaddr *>(&unixAddr), sizeof(unixAddr), AF_UNIX,
+          records, seconds));
+  }
+  return 0;
+}
@@ -0,0 +1,312 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "DatagramSource.hh"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "AllocTracker.hh"
+
+namespace
+{
+
+/// \brief Requested receive buffer, the kernel caps it at rmem_max.
+const int kReceiveBufferBytes = 16 << 20;
+
+/// \brief How long a blocked receive waits before checking for Stop().
+const int kReceiveTimeoutMs = 100;
+
+//////////////////////////////////////////////////
+void WriteLe64(int64_t _value, uint8_t *_out)
+{
+  const auto bits = static_cast<uint64_t>(_value);
+  for (int ii = 0; ii < 8; ++ii)
+    _out[ii] = static_cast<uint8_t>(bits >> (8 * ii));
+}
+
+//////////////////////////////////////////////////
+int64_t ReadLe64(const uint8_t *_in)
+{
+  uint64_t bits = 0;
+  for (int ii = 0; ii < 8; ++ii)
+    bits |= static_cast<uint64_t>(_in[ii]) << (8 * ii);
+  return static_cast<int64_t>(bits);
+}
+
+//////////////////////////////////////////////////
+std::runtime_error SocketError(const std::string &_what,
+                               const std::string &_address)
+{
+  return std::runtime_error{_what + " [" + _address + "]: " +
+    std::strerror(errno)};
+}
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+constexpr size_t DatagramSource::kBatchSize;
+constexpr size_t DatagramSource::kMaxDatagramSize;
+
+//////////////////////////////////////////////////
+void EncodeDatagramRecord(const DatagramRecord &_record, uint8_t *_out)
+{
+  WriteLe64(_record.sim, _out);
+  WriteLe64(_record.real, _out + 8);
+}
+
+//////////////////////////////////////////////////
+DatagramRecord DecodeDatagramRecord(const uint8_t *_in)
+{
+  DatagramRecord record;
+  record.sim = ReadLe64(_in);
+  record.real = ReadLe64(_in + 8);
+  return record;
+}
+
+//////////////////////////////////////////////////
+DatagramSource::~DatagramSource()
+{
+  this->Stop();
+}
+
+//////////////////////////////////////////////////
+void DatagramSource::Start(const std::string &_address, Callback _callback)
+{
+  this->Stop();
+
+  const auto colon = _address.find(':');
+  const std::string scheme = _address.substr(0, colon);
+  const std::string rest =
+    colon == std::string::npos ? "" : _address.substr(colon + 1);
+
+  if (scheme == "udp" && !rest.empty())
+  {
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    std::string host = "127.0.0.1";
+    std::string port = rest;
+    const auto portColon = rest.rfind(':');
+    if (portColon != std::string::npos)
+    {
+      host = rest.substr(0, portColon);
+      port = rest.substr(portColon + 1);
+    }
+    char *end = nullptr;
+    const unsigned long portNumber = std::strtoul(port.c_str(), &end, 10);
+    if (port.empty() || *end != '\0' || portNumber > 65535 ||
+        1 != inet_pton(AF_INET, host.c_str(), &addr.sin_addr))
+    {
+      throw std::runtime_error{"invalid UDP address [" + _address + "]"};
+    }
+    addr.sin_port = htons(static_cast<uint16_t>(portNumber));
+
+    this->fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (this->fd < 0)
+      throw SocketError("failed to create socket", _address);
+    const int one = 1;
+    setsockopt(this->fd, SOL_SOCKET, SO_RXQ_OVFL, &one, sizeof(one));
+    if (0 != bind(this->fd, reinterpret_cast<sockaddr *>(&addr),
+                  sizeof(addr)))
+    {
+      const auto error = SocketError("failed to bind", _address);
+      close(this->fd);
+      this->fd = -1;
+      throw error;
+    }
+  }
+  else if (scheme == "unix" && !rest.empty())
+  {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (rest.size() >= sizeof(addr.sun_path))
+      throw std::runtime_error{"socket path too long [" + _address + "]"};
+    std::memcpy(addr.sun_path, rest.c_str(), rest.size());
+
+    // Replace a socket left behind by an earlier run, never other files.
+    struct stat st;
+    if (0 == stat(rest.c_str(), &st) && S_ISSOCK(st.st_mode))
+      unlink(rest.c_str());
+
+    this->fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (this->fd < 0)
+      throw SocketError("failed to create socket", _address);
+    if (0 != bind(this->fd, reinterpret_cast<sockaddr *>(&addr),
+                  sizeof(addr)))
+    {
+      const auto error = SocketError("failed to bind", _address);
+      close(this->fd);
+      this->fd = -1;
+      throw error;
+    }
+    this->unixPath = rest;
+  }
+  else
+  {
+    throw std::runtime_error{"invalid datagram address [" + _address +
+      "], expected udp:[HOST:]PORT or unix:PATH"};
+  }
+
+  setsockopt(this->fd, SOL_SOCKET, SO_RCVBUF, &kReceiveBufferBytes,
+      sizeof(kReceiveBufferBytes));
+  timeval timeout;
+  timeout.tv_sec = 0;
+  timeout.tv_usec = kReceiveTimeoutMs * 1000;
+  setsockopt(this->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  this->error = 0;
+  this->callback = std::move(_callback);
+  this->buffers.resize(kBatchSize * kMaxDatagramSize);
+  this->records.resize(kBatchSize * (kMaxDatagramSize / kDatagramRecordSize));
+  this->running = true;
+  this->thread = std::thread(&DatagramSource::Run, this);
+}
+
+//////////////////////////////////////////////////
+void DatagramSource::Stop()
+{
+  this->running = false;
+  if (this->thread.joinable())
+    this->thread.join();
+  if (this->fd >= 0)
+    close(this->fd);
+  this->fd = -1;
+  if (!this->unixPath.empty())
+    unlink(this->unixPath.c_str());
+  this->unixPath.clear();
+}
+
+//////////////////////////////////////////////////
+bool DatagramSource::Running() const
+{
+  return this->running;
+}
+
+//////////////////////////////////////////////////
+DatagramSourceStats DatagramSource::Stats() const
+{
+  DatagramSourceStats stats;
+  stats.datagrams = this->datagrams.load(std::memory_order_relaxed);
+  stats.records = this->recordCount.load(std::memory_order_relaxed);
+  stats.batches = this->batches.load(std::memory_order_relaxed);
+  stats.malformed = this->malformed.load(std::memory_order_relaxed);
+  stats.truncated = this->truncated.load(std::memory_order_relaxed);
+  stats.socketDrops = this->socketDrops.load(std::memory_order_relaxed);
+  stats.error = this->error.load();
+  return stats;
+}
+
+//////////////////////////////////////////////////
+void DatagramSource::Run()
+{
+  AllocScope allocScope(AllocStage::kTransport);
+
+  // Room for the SO_RXQ_OVFL drop counter of each datagram.
+  constexpr size_t kControlSize = CMSG_SPACE(sizeof(uint32_t));
+  mmsghdr headers[kBatchSize];
+  iovec iovecs[kBatchSize];
+  alignas(cmsghdr) uint8_t control[kBatchSize][kControlSize];
+  for (size_t ii = 0; ii < kBatchSize; ++ii)
+  {
+    iovecs[ii].iov_base = &this->buffers[ii * kMaxDatagramSize];
+    iovecs[ii].iov_len = kMaxDatagramSize;
+  }
+
+  while (this->running)
+  {
+    std::memset(headers, 0, sizeof(headers));
+    for (size_t ii = 0; ii < kBatchSize; ++ii)
+    {
+      headers[ii].msg_hdr.msg_iov = &iovecs[ii];
+      headers[ii].msg_hdr.msg_iovlen = 1;
+      headers[ii].msg_hdr.msg_control = control[ii];
+      headers[ii].msg_hdr.msg_controllen = kControlSize;
+    }
+
+    // Block for the first datagram only, then take whatever is queued.
+    const int received = recvmmsg(this->fd, headers, kBatchSize,
+        MSG_WAITFORONE, nullptr);
+    if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+        errno != EINTR)
+    {
+      this->error = errno;
+      this->running = false;
+      break;
+    }
+    if (received <= 0)
+      continue;
+
+    size_t count = 0;
+    uint64_t malformedNow = 0;
+    uint64_t truncatedNow = 0;
+    for (int ii = 0; ii < received; ++ii)
+    {
+      const auto &header = headers[ii].msg_hdr;
+      for (auto cmsg = CMSG_FIRSTHDR(&header); cmsg;
+           cmsg = CMSG_NXTHDR(const_cast<msghdr *>(&header), cmsg))
+      {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL)
+        {
+          uint32_t drops;
+          std::memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+          this->socketDrops.store(drops, std::memory_order_relaxed);
+        }
+      }
+
+      if (header.msg_flags & MSG_TRUNC)
+      {
+        ++truncatedNow;
+        continue;
+      }
+      const size_t size = headers[ii].msg_len;
+      if (size % kDatagramRecordSize != 0)
+        ++malformedNow;
+      const uint8_t *data = &this->buffers[ii * kMaxDatagramSize];
+      for (size_t offset = 0; offset + kDatagramRecordSize <= size;
+           offset += kDatagramRecordSize)
+      {
+        this->records[count++] = DecodeDatagramRecord(data + offset);
+      }
+    }
+
+    this->datagrams.fetch_add(received, std::memory_order_relaxed);
+    this->recordCount.fetch_add(count, std::memory_order_relaxed);
+    this->batches.fetch_add(1, std::memory_order_relaxed);
+    if (malformedNow)
+      this->malformed.fetch_add(malformedNow, std::memory_order_relaxed);
+    if (truncatedNow)
+      this->truncated.fetch_add(truncatedNow, std::memory_order_relaxed);
+
+    if (count > 0)
+      this->callback(this->records.data(), count);
+  }
+}
+
+}  // namespace ign_imgui
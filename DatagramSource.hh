@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__DATAGRAM_SOURCE_HH_
+#define IGN_IMGUI__DATAGRAM_SOURCE_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ign_imgui
+{
+
+/// \brief One clock sample on the wire: sim and real time in nanoseconds,
+/// each a little-endian int64, kDatagramRecordSize bytes in all.
+struct DatagramRecord
+{
+  int64_t sim{0};
+  int64_t real{0};
+};
+
+const size_t kDatagramRecordSize = 16;
+
+/// \brief Write _record to _out in the wire format.
+void EncodeDatagramRecord(const DatagramRecord &_record, uint8_t *_out);
+
+/// \brief Read a record in the wire format from _in.
+DatagramRecord DecodeDatagramRecord(const uint8_t *_in);
+
+struct DatagramSourceStats
+{
+  uint64_t datagrams{0};
+  uint64_t records{0};
+
+  /// \brief recvmmsg() calls that returned datagrams.
+  uint64_t batches{0};
+
+  /// \brief Datagrams whose size is no multiple of kDatagramRecordSize,
+  /// the complete records in them are still used.
+  uint64_t malformed{0};
+
+  /// \brief Datagrams larger than DatagramSource::kMaxDatagramSize.
+  uint64_t truncated{0};
+
+  /// \brief Datagrams the kernel dropped because the socket buffer was
+  /// full, as SO_RXQ_OVFL reported with the last datagram received. Only
+  /// UDP reports this, senders on a Unix socket block instead.
+  uint64_t socketDrops{0};
+
+  /// \brief errno of the receive error that stopped the source, or 0.
+  int error{0};
+};
+
+/// \brief Receives clock samples on a local datagram socket, for load tests
+/// and simulators without ign-transport.
+///
+/// Every datagram holds one or more records. A thread receives up to
+/// kBatchSize datagrams per recvmmsg() call and hands each batch of decoded
+/// records to the callback.
+class DatagramSource
+{
+  public: static constexpr size_t kBatchSize = 64;
+  public: static constexpr size_t kMaxDatagramSize = 4096;
+
+  /// \brief Called on the receive thread with the records of one batch.
+  public: using Callback =
+    std::function<void(const DatagramRecord *_records, size_t _count)>;
+
+  public: DatagramSource() = default;
+  public: ~DatagramSource();
+
+  public: DatagramSource(const DatagramSource &) = delete;
+  public: DatagramSource &operator=(const DatagramSource &) = delete;
+
+  /// \brief Bind to _address and start receiving.
+  /// \param[in] _address "udp:PORT" and "udp:HOST:PORT" for UDP on
+  /// 127.0.0.1 or HOST, "unix:PATH" for a Unix datagram socket. An existing
+  /// socket file at PATH is replaced.
+  /// \throws std::runtime_error if the address is invalid or cannot be
+  /// bound.
+  public: void Start(const std::string &_address, Callback _callback);
+
+  /// \brief Stop receiving and close the socket.
+  public: void Stop();
+
+  /// \brief False after Stop() or a receive error.
+  public: bool Running() const;
+
+  public: DatagramSourceStats Stats() const;
+
+  protected: void Run();
+
+  protected: int fd{-1};
+  protected: std::string unixPath;
+  protected: Callback callback;
+  protected: std::vector<uint8_t> buffers;
+  protected: std::vector<DatagramRecord> records;
+  protected: std::atomic<bool> running{false};
+  protected: std::thread thread;
+
+  protected: std::atomic<uint64_t> datagrams{0};
+  protected: std::atomic<uint64_t> recordCount{0};
+  protected: std::atomic<uint64_t> batches{0};
+  protected: std::atomic<uint64_t> malformed{0};
+  protected: std::atomic<uint64_t> truncated{0};
+  protected: std::atomic<uint64_t> socketDrops{0};
+  protected: std::atomic<int> error{0};
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__DATAGRAM_SOURCE_HH_
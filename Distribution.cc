@@ -0,0 +1,587 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "BinaryUtils.hh"
+#include "CsvUtils.hh"
+#include "Distribution.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace
+{
+
+const char *kKindNames[] = {"dense", "loglinear", "sparse", "ddsketch"};
+
+/// \brief Bisection steps in MedianAbsDeviation(), enough to resolve any
+/// double range to well below a bucket.
+const int kMadIterations = 64;
+
+//////////////////////////////////////////////////
+/// \brief Value that falls back into the bucket [_lower, _upper), also for
+/// the open ended under and overflow buckets.
+double Representative(double _lower, double _upper)
+{
+  if (std::isinf(_lower))
+    return std::nextafter(_upper, _lower);
+  if (std::isinf(_upper))
+    return _lower;
+  return 0.5 * (_lower + _upper);
+}
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+Distribution::Distribution(const Distribution &_other)
+{
+  std::lock_guard<std::mutex> lock(_other.dataMutex);
+  this->backend = _other.backend;
+  this->displayAxis = _other.displayAxis;
+}
+
+//////////////////////////////////////////////////
+Distribution &Distribution::operator=(const Distribution &_other)
+{
+  if (&_other == this)
+    return *this;
+
+  std::scoped_lock lock(this->dataMutex, _other.dataMutex);
+  this->backend = _other.backend;
+  this->displayAxis = _other.displayAxis;
+  ++this->generation;
+  return *this;
+}
+
+//////////////////////////////////////////////////
+void Distribution::SetBackend(const Backend &_backend)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->backend = _backend;
+  ++this->generation;
+}
+
+//////////////////////////////////////////////////
+Distribution::Backend Distribution::MakeBackend(Kind _kind)
+{
+  switch (_kind)
+  {
+    case Kind::kLogLinear:
+      return LogLinearBackend();
+    case Kind::kSparse:
+      return SparseBackend();
+    case Kind::kDDSketch:
+      return DDSketchBackend();
+    case Kind::kDense:
+    default:
+      return DenseBackend();
+  }
+}
+
+//////////////////////////////////////////////////
+bool Distribution::ParseKind(const std::string &_name, Kind &_kind)
+{
+  for (size_t ii = 0; ii < std::size(kKindNames); ++ii)
+  {
+    if (_name == kKindNames[ii])
+    {
+      _kind = static_cast<Kind>(ii);
+      return true;
+    }
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////
+const char *Distribution::KindName(Kind _kind)
+{
+  return kKindNames[static_cast<size_t>(_kind)];
+}
+
+//////////////////////////////////////////////////
+Distribution::Kind Distribution::GetKind() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return static_cast<Kind>(this->backend.index());
+}
+
+//////////////////////////////////////////////////
+bool Distribution::AttachDenseStorage(uint64_t *_counts,
+    const HistogramAxis &_axis, bool _adopt)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  auto *dense = std::get_if<DenseBackend>(&this->backend);
+  if (!dense || dense->Axis().NumBins() != _axis.NumBins() ||
+      dense->Axis().Min() != _axis.Min() || dense->Axis().Max() != _axis.Max())
+  {
+    return false;
+  }
+  dense->AttachStorage(_counts, _adopt);
+  ++this->generation;
+  return true;
+}
+
+//////////////////////////////////////////////////
+void Distribution::DetachStorage()
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  if (auto *dense = std::get_if<DenseBackend>(&this->backend))
+    dense->DetachStorage();
+}
+
+//////////////////////////////////////////////////
+void Distribution::SetDisplayAxis(const HistogramAxis &_axis)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->displayAxis = _axis;
+  ++this->generation;
+}
+
+//////////////////////////////////////////////////
+void Distribution::InsertData(double _data)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  std::visit([_data](auto &_backend) { _backend.InsertData(_data); },
+      this->backend);
+  ++this->generation;
+}
+
+//////////////////////////////////////////////////
+void Distribution::InsertData(const double *_data, size_t _count)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  std::visit([_data, _count](auto &_backend)
+  {
+    using T = std::decay_t<decltype(_backend)>;
+    if constexpr (std::is_same<T, DenseBackend>::value)
+    {
+      _backend.InsertData(_data, _count);
+    }
+    else
+    {
+      for (size_t ii = 0; ii < _count; ++ii)
+        _backend.InsertData(_data[ii]);
+    }
+  }, this->backend);
+  ++this->generation;
+}
+
+//////////////////////////////////////////////////
+void Distribution::Merge(const Distribution &_other)
+{
+  if (&_other == this)
+    return;
+
+  Backend otherBackend;
+  {
+    std::lock_guard<std::mutex> lock(_other.dataMutex);
+    otherBackend = _other.backend;
+  }
+
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  std::visit([&](auto &_backend)
+  {
+    using T = std::decay_t<decltype(_backend)>;
+    const T *same = std::get_if<T>(&otherBackend);
+    if (same && _backend.Compatible(*same))
+    {
+      _backend.Merge(*same);
+      return;
+    }
+    std::visit([&](const auto &_otherBackend)
+    {
+      _otherBackend.ForEachBucket(
+          [&](double _lower, double _upper, uint64_t _count)
+          {
+            _backend.InsertData(Representative(_lower, _upper), _count);
+          });
+    }, otherBackend);
+  }, this->backend);
+  ++this->generation;
+}
+
+//////////////////////////////////////////////////
+void Distribution::Reset()
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  std::visit([](auto &_backend) { _backend.Reset(); }, this->backend);
+  ++this->generation;
+}
+
+//////////////////////////////////////////////////
+uint64_t Distribution::Count() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return std::visit([](const auto &_backend) { return _backend.Count(); },
+      this->backend);
+}
+
+//////////////////////////////////////////////////
+double Distribution::Quantile(double _q) const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  const uint64_t total = std::visit(
+      [](const auto &_backend) { return _backend.Count(); }, this->backend);
+  if (total == 0)
+    return std::numeric_limits<double>::quiet_NaN();
+
+  const double target = std::min(std::max(_q, 0.0), 1.0) * total;
+  double cumulative = 0.0;
+  double result = std::numeric_limits<double>::quiet_NaN();
+  bool found = false;
+  this->ForEachBucket([&](double _lower, double _upper, uint64_t _count)
+  {
+    if (found)
+      return;
+    if (cumulative + _count < target)
+    {
+      cumulative += _count;
+      result = _upper;
+      return;
+    }
+    found = true;
+    // Open ended buckets only know one edge.
+    if (std::isinf(_lower))
+      result = _upper;
+    else if (std::isinf(_upper))
+      result = _lower;
+    else
+      result = _lower + (_upper - _lower) * (target - cumulative) / _count;
+  });
+  return result;
+}
+
+//////////////////////////////////////////////////
+double Distribution::Mean() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  double sum = 0.0;
+  uint64_t total = 0;
+  this->ForEachBucket([&](double _lower, double _upper, uint64_t _count)
+  {
+    sum += Representative(_lower, _upper) * _count;
+    total += _count;
+  });
+  return total ? sum / total : 0.0;
+}
+
+//////////////////////////////////////////////////
+double Distribution::MedianAbsDeviation(double _center) const
+{
+  // Buckets are collected into a kept buffer and bisected under the lock,
+  // so periodic re-estimates do not allocate once the range is settled.
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  auto &buckets = this->madBuckets;
+  buckets.clear();
+  double total = 0.0;
+  double maxDeviation = 0.0;
+  this->ForEachBucket([&](double _lower, double _upper, uint64_t _count)
+  {
+    // Open ended buckets only know one edge, treat them as a point there.
+    if (std::isinf(_lower))
+      _lower = _upper;
+    if (std::isinf(_upper))
+      _upper = _lower;
+    buckets.push_back({_lower, _upper, _count});
+    total += _count;
+    maxDeviation = std::max(maxDeviation, std::max(
+        std::abs(_lower - _center), std::abs(_upper - _center)));
+  });
+  if (total == 0.0)
+    return std::numeric_limits<double>::quiet_NaN();
+
+  // Bisect for the deviation that covers half the samples.
+  double low = 0.0;
+  double high = maxDeviation;
+  for (int ii = 0; ii < kMadIterations; ++ii)
+  {
+    const double deviation = 0.5 * (low + high);
+    const double from = _center - deviation;
+    const double to = _center + deviation;
+    double covered = 0.0;
+    for (const auto &bucket : buckets)
+    {
+      if (bucket.upper <= bucket.lower)
+      {
+        if (bucket.lower >= from && bucket.lower <= to)
+          covered += bucket.count;
+        continue;
+      }
+      const double overlap = std::min(to, bucket.upper) -
+        std::max(from, bucket.lower);
+      if (overlap > 0.0)
+        covered += bucket.count * overlap / (bucket.upper - bucket.lower);
+    }
+    if (covered < 0.5 * total)
+      low = deviation;
+    else
+      high = deviation;
+  }
+  return high;
+}
+
+//////////////////////////////////////////////////
+size_t Distribution::MemoryUsage() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return std::visit(
+      [](const auto &_backend) { return _backend.MemoryUsage(); },
+      this->backend);
+}
+
+//////////////////////////////////////////////////
+std::vector<float> Distribution::Counts(const HistogramAxis &_axis) const
+{
+  std::vector<float> counts(_axis.NumBins(), 0.0f);
+  if (counts.empty())
+    return counts;
+
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->ForEachBucket([&](double _lower, double _upper, uint64_t _count)
+  {
+    if (std::isinf(_lower) || std::isinf(_upper))
+      return;
+
+    if (!(_upper > _lower))
+    {
+      const int32_t index = _axis.Index(static_cast<float>(_lower));
+      if (index != HistogramAxis::kOutOfRange)
+        counts[index] += _count;
+      return;
+    }
+
+    int32_t first = _axis.Index(static_cast<float>(_lower));
+    if (first == HistogramAxis::kOutOfRange)
+    {
+      if (_lower >= _axis.Max())
+        return;
+      first = 0;
+    }
+    const double scale = _count / (_upper - _lower);
+    for (size_t ii = first; ii < counts.size(); ++ii)
+    {
+      const double binLower = _axis.Edge(ii);
+      if (binLower >= _upper)
+        break;
+      const double overlap = std::min<double>(_upper, _axis.Edge(ii + 1)) -
+        std::max<double>(_lower, binLower);
+      if (overlap > 0.0)
+        counts[ii] += static_cast<float>(overlap * scale);
+    }
+  });
+  return counts;
+}
+
+//////////////////////////////////////////////////
+const uint64_t *Distribution::DenseCounts(HistogramAxis &_axis) const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  const DenseBackend *dense = std::get_if<DenseBackend>(&this->backend);
+  if (!dense)
+    return nullptr;
+  _axis = dense->Axis();
+  return dense->Data();
+}
+
+//////////////////////////////////////////////////
+void Distribution::Buckets(std::vector<double> &_lower,
+                           std::vector<double> &_upper,
+                           std::vector<uint64_t> &_counts) const
+{
+  _lower.clear();
+  _upper.clear();
+  _counts.clear();
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->ForEachBucket([&](double _l, double _u, uint64_t _count)
+  {
+    _lower.push_back(_l);
+    _upper.push_back(_u);
+    _counts.push_back(_count);
+  });
+}
+
+//////////////////////////////////////////////////
+void Distribution::PlotHistogram(const std::string &_label, ImVec2 _graphSize)
+{
+  HistogramAxis axis;
+  uint64_t current;
+  {
+    std::lock_guard<std::mutex> lock(this->dataMutex);
+    axis = this->displayAxis;
+    current = this->generation;
+  }
+
+  // Re-binning walks every bucket, only do it when something changed. An
+  // insert racing with it just makes the next frame re-bin again.
+  const ImVec2 graphSize = HistogramPlot::GraphSize(_graphSize);
+  if (this->plot.Stale(current, graphSize.x))
+  {
+    this->plotCounts = this->Counts(axis);
+    this->plot.Update(this->plotCounts.data(), this->plotCounts.size(), axis,
+        current, graphSize.x);
+  }
+  if (this->plotCounts.empty())
+    return;
+  this->plot.Draw(_label, graphSize);
+}
+
+//////////////////////////////////////////////////
+void Distribution::ToCsv(std::ostream & ost) const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  const auto precision = ost.precision(
+      std::numeric_limits<double>::max_digits10);
+
+  ost << kKindNames[this->backend.index()] << ",";
+  std::visit([&](const auto &_backend)
+  {
+    using T = std::decay_t<decltype(_backend)>;
+    if constexpr (std::is_same<T, DenseBackend>::value)
+    {
+      ost << _backend.Axis().NumBins() << "," << _backend.Axis().Min() <<
+        "," << _backend.Axis().Max() << ",";
+    }
+    else if constexpr (std::is_same<T, LogLinearBackend>::value)
+    {
+      ost << _backend.SubBuckets() << ",";
+    }
+    else if constexpr (std::is_same<T, SparseBackend>::value)
+    {
+      ost << _backend.Width() << ",";
+    }
+    else
+    {
+      ost << _backend.Alpha() << "," << _backend.MaxBuckets() << ",";
+    }
+  }, this->backend);
+  ost << std::endl;
+
+  // One representative value per bucket, enough to rebuild it exactly.
+  size_t numBuckets = 0;
+  this->ForEachBucket([&](double, double, uint64_t) { ++numBuckets; });
+  ost << numBuckets << "," << std::endl;
+  this->ForEachBucket([&](double _lower, double _upper, uint64_t _count)
+  {
+    ost << Representative(_lower, _upper) << "," << _count << "," <<
+      std::endl;
+  });
+  ost.precision(precision);
+}
+
+//////////////////////////////////////////////////
+void Distribution::FromCsv(std::istream & ist)
+{
+  std::string name;
+  GetNextCsv(ist, name);
+  Kind kind;
+  if (!ParseKind(name, kind))
+    throw std::runtime_error{"failed to parse input csv file"};
+
+  Backend newBackend;
+  switch (kind)
+  {
+    case Kind::kDense:
+    {
+      size_t numBins;
+      float min;
+      float max;
+      GetNextCsv(ist, numBins);
+      GetNextCsv(ist, min);
+      GetNextCsv(ist, max);
+      if (numBins == 0 || !(min < max))
+        throw std::runtime_error{"failed to parse input csv file"};
+      newBackend = DenseBackend(numBins, min, max);
+      break;
+    }
+    case Kind::kLogLinear:
+    {
+      uint32_t subBuckets;
+      GetNextCsv(ist, subBuckets);
+      newBackend = LogLinearBackend(subBuckets);
+      break;
+    }
+    case Kind::kSparse:
+    {
+      double width;
+      GetNextCsv(ist, width);
+      newBackend = SparseBackend(width);
+      break;
+    }
+    case Kind::kDDSketch:
+    {
+      double alpha;
+      uint32_t maxBuckets;
+      GetNextCsv(ist, alpha);
+      GetNextCsv(ist, maxBuckets);
+      newBackend = DDSketchBackend(alpha, maxBuckets);
+      break;
+    }
+  }
+  GetNewLine(ist);
+
+  size_t numBuckets;
+  GetNextCsv(ist, numBuckets);
+  GetNewLine(ist);
+  std::visit([&](auto &_backend)
+  {
+    for (size_t ii = 0; ii < numBuckets; ++ii)
+    {
+      double value;
+      uint64_t count;
+      GetNextCsv(ist, value);
+      GetNextCsv(ist, count);
+      _backend.InsertData(value, count);
+    }
+  }, newBackend);
+  ist >> std::ws;
+
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->backend = std::move(newBackend);
+  ++this->generation;
+}
+
+//////////////////////////////////////////////////
+void Distribution::ToBinary(std::ostream & ost) const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  WriteBinary(ost, static_cast<uint8_t>(this->backend.index()));
+  std::visit([&](const auto &_backend) { _backend.ToBinary(ost); },
+      this->backend);
+}
+
+//////////////////////////////////////////////////
+void Distribution::FromBinary(std::istream & ist)
+{
+  uint8_t index;
+  ReadBinary(ist, index);
+  if (index >= std::variant_size<Backend>::value)
+    throw std::runtime_error{"failed to parse input binary file"};
+
+  Backend newBackend = MakeBackend(static_cast<Kind>(index));
+  std::visit([&](auto &_backend) { _backend.FromBinary(ist); }, newBackend);
+
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->backend = std::move(newBackend);
+  ++this->generation;
+}
+
+}  // namespace ign_imgui
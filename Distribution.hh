@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__DISTRIBUTION_HH_
+#define IGN_IMGUI__DISTRIBUTION_HH_
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include <imgui/imgui.h>
+
+#include "DistributionBackends.hh"
+#include "HistogramAxis.hh"
+#include "HistogramPlot.hh"
+
+namespace ign_imgui
+{
+
+/// \brief Distribution of RTF samples with a storage back-end chosen at
+/// runtime.
+///
+/// The back-end lives in a std::variant, so inserts dispatch on the variant
+/// index instead of going through a virtual call. Everything else, plotting,
+/// quantiles, export and merging, is written once on top of the buckets each
+/// back-end exposes.
+class Distribution
+{
+  public: enum class Kind
+  {
+    kDense,
+    kLogLinear,
+    kSparse,
+    kDDSketch
+  };
+
+  public: using Backend = std::variant<DenseBackend, LogLinearBackend,
+                                       SparseBackend, DDSketchBackend>;
+
+  public: Distribution() = default;
+  public: Distribution(const Distribution &_other);
+  public: Distribution &operator=(const Distribution &_other);
+
+  /// \brief Replace the back-end, dropping all data.
+  public: void SetBackend(const Backend &_backend);
+
+  /// \brief Default configured back-end of the given kind.
+  public: static Backend MakeBackend(Kind _kind);
+
+  /// \brief Parse a back-end name as used on the command line.
+  /// \return False if _name is not one of KindName().
+  public: static bool ParseKind(const std::string &_name, Kind &_kind);
+  public: static const char *KindName(Kind _kind);
+
+  public: Kind GetKind() const;
+
+  /// \brief Keep the dense back-end counts in _counts, see
+  /// DenseBackend::AttachStorage(). Replacing the back-end, by SetBackend(),
+  /// FromBinary() or assignment, moves the counts back to the heap.
+  /// \return False unless the back-end is dense with the bins of _axis.
+  public: bool AttachDenseStorage(uint64_t *_counts,
+                                  const HistogramAxis &_axis, bool _adopt);
+
+  /// \brief Move attached counts back to the heap.
+  public: void DetachStorage();
+
+  /// \brief Bins used by PlotHistogram().
+  public: void SetDisplayAxis(const HistogramAxis &_axis);
+
+  public: void InsertData(double _data);
+  public: void InsertData(const double *_data, size_t _count);
+
+  /// \brief Add the samples of _other. Back-ends of the same kind and
+  /// configuration merge exactly, otherwise each bucket of _other is
+  /// re-inserted at its midpoint.
+  public: void Merge(const Distribution &_other);
+  public: void Reset();
+
+  public: uint64_t Count() const;
+
+  /// \brief Value below which a fraction _q of the samples fall,
+  /// interpolated linearly within a bucket. NaN when empty.
+  public: double Quantile(double _q) const;
+
+  /// \brief Approximate mean from bucket midpoints.
+  public: double Mean() const;
+
+  /// \brief Median absolute deviation from _center, assuming samples are
+  /// spread uniformly within each bucket. NaN when empty.
+  public: double MedianAbsDeviation(double _center) const;
+
+  /// \brief Bytes used by the back-end.
+  public: size_t MemoryUsage() const;
+
+  /// \brief Counts re-binned onto _axis, buckets spread proportionally
+  /// over the bins they overlap.
+  public: std::vector<float> Counts(const HistogramAxis &_axis) const;
+
+  /// \brief Counts of the dense back-end, without copying, see
+  /// DenseBackend::Data(). Valid until the back-end is next modified.
+  /// \return Null unless the back-end is dense.
+  public: const uint64_t *DenseCounts(HistogramAxis &_axis) const;
+
+  /// \brief Copy out every non-empty bucket in increasing order.
+  public: void Buckets(std::vector<double> &_lower,
+                       std::vector<double> &_upper,
+                       std::vector<uint64_t> &_counts) const;
+
+  public: void PlotHistogram(const std::string &_label,
+                             ImVec2 _graphSize=ImVec2(0,0));
+
+  public: void ToCsv(std::ostream & ost) const;
+
+  public: void FromCsv(std::istream & ist);
+
+  public: void ToBinary(std::ostream & ost) const;
+
+  public: void FromBinary(std::istream & ist);
+
+  /// \brief Call _fn(lower, upper, count) for every non-empty bucket in
+  /// increasing order, with the lock held.
+  protected: template<typename Fn>
+  void ForEachBucket(Fn &&_fn) const
+  {
+    std::visit([&](const auto &_backend) { _backend.ForEachBucket(_fn); },
+        this->backend);
+  }
+
+  protected: Backend backend;
+  protected: HistogramAxis displayAxis;
+  protected: std::vector<float> plotCounts;
+
+  /// \brief Bumped whenever the buckets or the display axis change, so
+  /// the plot only re-bins when it has to.
+  protected: uint64_t generation{0};
+  protected: HistogramPlot plot;
+
+  /// \brief Scratch space of MedianAbsDeviation().
+  protected: struct MadBucket
+  {
+    double lower;
+    double upper;
+    uint64_t count;
+  };
+  protected: mutable std::vector<MadBucket> madBuckets;
+  protected: mutable std::mutex dataMutex;
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__DISTRIBUTION_HH_
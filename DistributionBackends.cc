@@ -0,0 +1,539 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "BinaryUtils.hh"
+#include "DistributionBackends.hh"
+
+#include <stdexcept>
+
+namespace
+{
+
+const size_t kDenseBatch = 256;
+
+//////////////////////////////////////////////////
+/// \brief Floor division, rounding towards negative infinity.
+int64_t FloorDiv(int64_t _a, int64_t _b)
+{
+  const int64_t quotient = _a / _b;
+  return (_a % _b != 0 && (_a < 0) != (_b < 0)) ? quotient - 1 : quotient;
+}
+
+/// \brief Lowest and highest exponent std::frexp() gives a positive finite
+/// double, subnormals included.
+const int64_t kMinExponent = std::numeric_limits<double>::min_exponent -
+    std::numeric_limits<double>::digits + 1;
+const int64_t kMaxExponent = std::numeric_limits<double>::max_exponent;
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+constexpr uint32_t LogLinearBackend::kMaxSubBuckets;
+constexpr uint32_t DDSketchBackend::kMaxBuckets;
+
+//////////////////////////////////////////////////
+DenseBackend::DenseBackend(size_t _numBins, float _min, float _max)
+{
+  this->axis.Set(_numBins, _min, _max, HistogramAxis::Scale::kUniform);
+  this->storage.assign(this->axis.NumBins() + 2, 0);
+  this->counts = this->storage.data();
+}
+
+//////////////////////////////////////////////////
+DenseBackend::DenseBackend(const DenseBackend &_other)
+  : axis(_other.axis),
+    storage(_other.counts, _other.counts + _other.axis.NumBins() + 2),
+    counts(storage.data()),
+    total(_other.total)
+{
+}
+
+//////////////////////////////////////////////////
+DenseBackend &DenseBackend::operator=(const DenseBackend &_other)
+{
+  if (this == &_other)
+    return *this;
+  this->axis = _other.axis;
+  this->storage.assign(_other.counts,
+      _other.counts + _other.axis.NumBins() + 2);
+  this->counts = this->storage.data();
+  this->total = _other.total;
+  return *this;
+}
+
+//////////////////////////////////////////////////
+void DenseBackend::InsertData(const double *_values, size_t _count)
+{
+  float values[kDenseBatch];
+  int32_t indices[kDenseBatch];
+  for (size_t start = 0; start < _count; start += kDenseBatch)
+  {
+    const size_t n = std::min(kDenseBatch, _count - start);
+    for (size_t ii = 0; ii < n; ++ii)
+      values[ii] = static_cast<float>(_values[start + ii]);
+    this->axis.Indices(values, indices, n);
+    for (size_t ii = 0; ii < n; ++ii)
+    {
+      if (indices[ii] != HistogramAxis::kOutOfRange)
+      {
+        ++this->counts[indices[ii] + 1];
+        ++this->total;
+      }
+      else
+      {
+        this->InsertData(_values[start + ii]);
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+bool DenseBackend::Compatible(const DenseBackend &_other) const
+{
+  return this->axis.NumBins() == _other.axis.NumBins() &&
+    this->axis.Min() == _other.axis.Min() &&
+    this->axis.Max() == _other.axis.Max();
+}
+
+//////////////////////////////////////////////////
+void DenseBackend::Merge(const DenseBackend &_other)
+{
+  const size_t size = this->axis.NumBins() + 2;
+  for (size_t ii = 0; ii < size; ++ii)
+    this->counts[ii] += _other.counts[ii];
+  this->total += _other.total;
+}
+
+//////////////////////////////////////////////////
+void DenseBackend::Reset()
+{
+  std::fill(this->counts, this->counts + this->axis.NumBins() + 2, 0);
+  this->total = 0;
+}
+
+//////////////////////////////////////////////////
+size_t DenseBackend::MemoryUsage() const
+{
+  return sizeof(*this) + (this->axis.NumBins() + 2) * sizeof(uint64_t);
+}
+
+//////////////////////////////////////////////////
+void DenseBackend::AttachStorage(uint64_t *_counts, bool _adopt)
+{
+  const size_t size = this->axis.NumBins() + 2;
+  if (_adopt)
+  {
+    this->total = 0;
+    for (size_t ii = 0; ii < size; ++ii)
+      this->total += _counts[ii];
+  }
+  else
+  {
+    std::copy(this->counts, this->counts + size, _counts);
+  }
+  this->counts = _counts;
+  this->storage.clear();
+  this->storage.shrink_to_fit();
+}
+
+//////////////////////////////////////////////////
+void DenseBackend::DetachStorage()
+{
+  if (this->counts == this->storage.data())
+    return;
+  this->storage.assign(this->counts, this->counts + this->axis.NumBins() + 2);
+  this->counts = this->storage.data();
+}
+
+//////////////////////////////////////////////////
+void DenseBackend::ToBinary(std::ostream & ost) const
+{
+  const size_t numBins = this->axis.NumBins();
+  WriteBinary(ost, this->axis.Min());
+  WriteBinary(ost, this->axis.Max());
+  WriteBinary(ost, std::vector<uint64_t>(this->counts + 1,
+      this->counts + numBins + 1));
+  WriteBinary(ost, this->counts[0]);
+  WriteBinary(ost, this->counts[numBins + 1]);
+}
+
+//////////////////////////////////////////////////
+void DenseBackend::FromBinary(std::istream & ist)
+{
+  float min;
+  float max;
+  std::vector<uint64_t> bins;
+  uint64_t underflow;
+  uint64_t overflow;
+  ReadBinary(ist, min);
+  ReadBinary(ist, max);
+  ReadBinary(ist, bins);
+  ReadBinary(ist, underflow);
+  ReadBinary(ist, overflow);
+  if (!(min < max) || bins.empty())
+    throw std::runtime_error{"failed to parse input binary file"};
+
+  this->axis.Set(bins.size(), min, max, HistogramAxis::Scale::kUniform);
+  this->storage.assign(bins.size() + 2, 0);
+  std::copy(bins.begin(), bins.end(), this->storage.begin() + 1);
+  this->storage.front() = underflow;
+  this->storage.back() = overflow;
+  this->counts = this->storage.data();
+  this->total = 0;
+  for (auto count : this->storage)
+    this->total += count;
+}
+
+//////////////////////////////////////////////////
+LogLinearBackend::LogLinearBackend(uint32_t _subBuckets)
+  : subBuckets(std::clamp<uint32_t>(_subBuckets, 1, kMaxSubBuckets))
+{
+}
+
+//////////////////////////////////////////////////
+bool LogLinearBackend::Compatible(const LogLinearBackend &_other) const
+{
+  return this->subBuckets == _other.subBuckets;
+}
+
+//////////////////////////////////////////////////
+void LogLinearBackend::Merge(const LogLinearBackend &_other)
+{
+  if (!_other.counts.empty())
+  {
+    this->Grow(_other.offset);
+    this->Grow(_other.offset + _other.counts.size() - 1);
+    for (size_t ii = 0; ii < _other.counts.size(); ++ii)
+      this->counts[_other.offset - this->offset + ii] += _other.counts[ii];
+  }
+  this->zeroCount += _other.zeroCount;
+  this->total += _other.total;
+}
+
+//////////////////////////////////////////////////
+void LogLinearBackend::Reset()
+{
+  this->offset = 0;
+  this->counts.clear();
+  this->zeroCount = 0;
+  this->total = 0;
+}
+
+//////////////////////////////////////////////////
+size_t LogLinearBackend::MemoryUsage() const
+{
+  return sizeof(*this) + this->counts.capacity() * sizeof(uint64_t);
+}
+
+//////////////////////////////////////////////////
+double LogLinearBackend::Lower(int64_t _index) const
+{
+  const int64_t exponent = FloorDiv(_index, this->subBuckets);
+  const int64_t sub = _index - exponent * this->subBuckets;
+  return std::ldexp(0.5 + 0.5 * sub / this->subBuckets,
+      static_cast<int>(exponent));
+}
+
+//////////////////////////////////////////////////
+void LogLinearBackend::Grow(int64_t _index)
+{
+  if (this->counts.empty())
+  {
+    this->offset = _index;
+    this->counts.assign(1, 0);
+    return;
+  }
+  if (_index < this->offset)
+  {
+    this->counts.insert(this->counts.begin(), this->offset - _index, 0);
+    this->offset = _index;
+  }
+  else if (_index >= this->offset + static_cast<int64_t>(this->counts.size()))
+  {
+    this->counts.resize(_index - this->offset + 1, 0);
+  }
+}
+
+//////////////////////////////////////////////////
+void LogLinearBackend::ToBinary(std::ostream & ost) const
+{
+  WriteBinary(ost, this->subBuckets);
+  WriteBinary(ost, this->offset);
+  WriteBinary(ost, this->counts);
+  WriteBinary(ost, this->zeroCount);
+}
+
+//////////////////////////////////////////////////
+void LogLinearBackend::FromBinary(std::istream & ist)
+{
+  uint32_t newSubBuckets;
+  int64_t newOffset;
+  std::vector<uint64_t> newCounts;
+  uint64_t newZeroCount;
+  ReadBinary(ist, newSubBuckets);
+  ReadBinary(ist, newOffset);
+  ReadBinary(ist, newCounts);
+  ReadBinary(ist, newZeroCount);
+  if (newSubBuckets == 0 || newSubBuckets > kMaxSubBuckets)
+    throw std::runtime_error{"failed to parse input binary file"};
+
+  // Buckets no finite value maps to would make the next insert grow the
+  // store all the way out to them.
+  const int64_t lowest = kMinExponent * newSubBuckets;
+  const int64_t highest = (kMaxExponent + 1) * newSubBuckets - 1;
+  if (!newCounts.empty() && (newOffset < lowest ||
+      newOffset > highest - static_cast<int64_t>(newCounts.size()) + 1))
+  {
+    throw std::runtime_error{"failed to parse input binary file"};
+  }
+
+  this->subBuckets = newSubBuckets;
+  this->offset = newOffset;
+  this->counts = std::move(newCounts);
+  this->zeroCount = newZeroCount;
+  this->total = this->zeroCount;
+  for (auto count : this->counts)
+    this->total += count;
+}
+
+//////////////////////////////////////////////////
+SparseBackend::SparseBackend(double _width)
+  : width(_width > 0.0 ? _width : 0.01)
+{
+}
+
+//////////////////////////////////////////////////
+bool SparseBackend::Compatible(const SparseBackend &_other) const
+{
+  return this->width == _other.width;
+}
+
+//////////////////////////////////////////////////
+void SparseBackend::Merge(const SparseBackend &_other)
+{
+  for (const auto &bucket : _other.counts)
+    this->counts[bucket.first] += bucket.second;
+  this->total += _other.total;
+}
+
+//////////////////////////////////////////////////
+void SparseBackend::Reset()
+{
+  this->counts.clear();
+  this->total = 0;
+}
+
+//////////////////////////////////////////////////
+size_t SparseBackend::MemoryUsage() const
+{
+  // Node based map: one allocation per bucket plus the bucket array.
+  return sizeof(*this) +
+    this->counts.size() * (sizeof(std::pair<int64_t, uint64_t>) +
+        2 * sizeof(void *)) +
+    this->counts.bucket_count() * sizeof(void *);
+}
+
+//////////////////////////////////////////////////
+std::vector<std::pair<int64_t, uint64_t>> SparseBackend::SortedBuckets() const
+{
+  std::vector<std::pair<int64_t, uint64_t>> buckets(
+      this->counts.begin(), this->counts.end());
+  std::sort(buckets.begin(), buckets.end());
+  return buckets;
+}
+
+//////////////////////////////////////////////////
+void SparseBackend::ToBinary(std::ostream & ost) const
+{
+  WriteBinary(ost, this->width);
+  WriteBinary(ost, this->SortedBuckets());
+}
+
+//////////////////////////////////////////////////
+void SparseBackend::FromBinary(std::istream & ist)
+{
+  std::vector<std::pair<int64_t, uint64_t>> buckets;
+  ReadBinary(ist, this->width);
+  ReadBinary(ist, buckets);
+  if (!(this->width > 0.0))
+    throw std::runtime_error{"failed to parse input binary file"};
+
+  this->counts.clear();
+  this->total = 0;
+  for (const auto &bucket : buckets)
+  {
+    this->counts[bucket.first] += bucket.second;
+    this->total += bucket.second;
+  }
+}
+
+//////////////////////////////////////////////////
+DDSketchBackend::DDSketchBackend(double _alpha, uint32_t _maxBuckets)
+  : maxBuckets(std::clamp<uint32_t>(_maxBuckets, 1, kMaxBuckets))
+{
+  this->SetAlpha(_alpha);
+}
+
+//////////////////////////////////////////////////
+void DDSketchBackend::SetAlpha(double _alpha)
+{
+  this->alpha = (_alpha > 0.0 && _alpha < 1.0) ? _alpha : 0.01;
+  this->logGamma = std::log((1.0 + this->alpha) / (1.0 - this->alpha));
+  this->inverseLogGamma = 1.0 / this->logGamma;
+}
+
+//////////////////////////////////////////////////
+bool DDSketchBackend::Compatible(const DDSketchBackend &_other) const
+{
+  return this->alpha == _other.alpha &&
+    this->maxBuckets == _other.maxBuckets;
+}
+
+//////////////////////////////////////////////////
+void DDSketchBackend::Merge(const DDSketchBackend &_other)
+{
+  for (size_t ii = 0; ii < _other.counts.size(); ++ii)
+  {
+    if (_other.counts[ii])
+    {
+      const int64_t index = _other.offset + static_cast<int64_t>(ii);
+      this->counts[this->Slot(index)] += _other.counts[ii];
+    }
+  }
+  this->zeroCount += _other.zeroCount;
+  this->total += _other.total;
+}
+
+//////////////////////////////////////////////////
+void DDSketchBackend::Reset()
+{
+  this->offset = 0;
+  this->counts.clear();
+  this->zeroCount = 0;
+  this->total = 0;
+}
+
+//////////////////////////////////////////////////
+size_t DDSketchBackend::MemoryUsage() const
+{
+  return sizeof(*this) + this->counts.capacity() * sizeof(uint64_t);
+}
+
+//////////////////////////////////////////////////
+size_t DDSketchBackend::Slot(int64_t _index)
+{
+  if (this->counts.empty())
+  {
+    this->offset = _index;
+    this->counts.assign(1, 0);
+    return 0;
+  }
+
+  const int64_t size = static_cast<int64_t>(this->counts.size());
+  if (_index < this->offset)
+  {
+    // Below everything stored: grow downwards while allowed, otherwise it
+    // belongs to the lowest, collapsed, bucket.
+    const int64_t grow = std::min<int64_t>(this->offset - _index,
+        static_cast<int64_t>(this->maxBuckets) - size);
+    if (grow > 0)
+    {
+      this->counts.insert(this->counts.begin(), grow, 0);
+      this->offset -= grow;
+    }
+    return _index < this->offset ? 0 : _index - this->offset;
+  }
+
+  if (_index >= this->offset + size)
+  {
+    const int64_t newSize = _index - this->offset + 1;
+    const int64_t collapse = newSize - static_cast<int64_t>(this->maxBuckets);
+    if (collapse > 0)
+    {
+      // Fold the lowest buckets into the first one that is kept.
+      const int64_t folded = std::min(collapse, size);
+      uint64_t sum = 0;
+      for (int64_t ii = 0; ii < folded; ++ii)
+        sum += this->counts[ii];
+      this->counts.erase(this->counts.begin(), this->counts.begin() + folded);
+      this->offset += collapse;
+      this->counts.resize(this->maxBuckets, 0);
+      this->counts[0] += sum;
+    }
+    else
+    {
+      this->counts.resize(newSize, 0);
+    }
+  }
+  return _index - this->offset;
+}
+
+//////////////////////////////////////////////////
+void DDSketchBackend::ToBinary(std::ostream & ost) const
+{
+  WriteBinary(ost, this->alpha);
+  WriteBinary(ost, this->maxBuckets);
+  WriteBinary(ost, this->offset);
+  WriteBinary(ost, this->counts);
+  WriteBinary(ost, this->zeroCount);
+}
+
+//////////////////////////////////////////////////
+void DDSketchBackend::FromBinary(std::istream & ist)
+{
+  double newAlpha;
+  uint32_t newMaxBuckets;
+  int64_t newOffset;
+  std::vector<uint64_t> newCounts;
+  uint64_t newZeroCount;
+  ReadBinary(ist, newAlpha);
+  ReadBinary(ist, newMaxBuckets);
+  ReadBinary(ist, newOffset);
+  ReadBinary(ist, newCounts);
+  ReadBinary(ist, newZeroCount);
+  if (!(newAlpha > 0.0 && newAlpha < 1.0) || newMaxBuckets == 0 ||
+      newMaxBuckets > kMaxBuckets || newCounts.size() > newMaxBuckets)
+  {
+    throw std::runtime_error{"failed to parse input binary file"};
+  }
+
+  // Buckets past the range of indexable values would make Slot() overflow
+  // working out the distance to them.
+  const double inverseLogGamma =
+      1.0 / std::log((1.0 + newAlpha) / (1.0 - newAlpha));
+  const double lowest = std::ceil(std::log(kMinIndexable) * inverseLogGamma);
+  const double highest = std::ceil(
+      std::log(std::numeric_limits<double>::max()) * inverseLogGamma);
+  if (!newCounts.empty() && (static_cast<double>(newOffset) < lowest ||
+      static_cast<double>(newOffset) + newCounts.size() - 1 > highest))
+  {
+    throw std::runtime_error{"failed to parse input binary file"};
+  }
+
+  this->SetAlpha(newAlpha);
+  this->maxBuckets = newMaxBuckets;
+  this->offset = newOffset;
+  this->counts = std::move(newCounts);
+  this->zeroCount = newZeroCount;
+  this->total = this->zeroCount;
+  for (auto count : this->counts)
+    this->total += count;
+}
+
+}  // namespace ign_imgui
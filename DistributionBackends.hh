@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__DISTRIBUTION_BACKENDS_HH_
+#define IGN_IMGUI__DISTRIBUTION_BACKENDS_HH_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "HistogramAxis.hh"
+
+// Storage strategies behind Distribution. They are not thread safe on their
+// own and all share the same informal interface:
+//   InsertData(value, count), Merge(other), Compatible(other), Reset(),
+//   Count(), MemoryUsage(), ForEachBucket(fn(lower, upper, count)) in
+//   increasing value order, and ToBinary()/FromBinary().
+// Inserting count copies of the middle of any bucket lands in that same
+// bucket, which is how Distribution converts between back-ends.
+
+namespace ign_imgui
+{
+
+/// \brief Uniform bins over a fixed range, the classic Histogram layout.
+/// Values outside the range are only counted.
+class DenseBackend
+{
+  public: explicit DenseBackend(size_t _numBins = 200, float _min = 0.0f,
+                                float _max = 2.0f);
+  public: DenseBackend(const DenseBackend &_other);
+  public: DenseBackend &operator=(const DenseBackend &_other);
+
+  public: inline void InsertData(double _value, uint64_t _count = 1)
+  {
+    const int32_t index = this->axis.Index(static_cast<float>(_value));
+    if (index != HistogramAxis::kOutOfRange)
+      this->counts[index + 1] += _count;
+    else if (_value < this->axis.Min())
+      this->counts[0] += _count;
+    else if (_value >= this->axis.Max())
+      this->counts[this->axis.NumBins() + 1] += _count;
+    else
+      return;
+    this->total += _count;
+  }
+
+  /// \brief Batched insert using the SIMD bin index kernel.
+  public: void InsertData(const double *_values, size_t _count);
+
+  public: bool Compatible(const DenseBackend &_other) const;
+  public: void Merge(const DenseBackend &_other);
+  public: void Reset();
+  public: uint64_t Count() const { return this->total; }
+  public: size_t MemoryUsage() const;
+  public: const HistogramAxis &Axis() const { return this->axis; }
+
+  /// \brief Underflow, bins and overflow, NumBins() + 2 entries.
+  public: const uint64_t *Data() const { return this->counts; }
+
+  /// \brief Keep the counts in caller owned memory of NumBins() + 2
+  /// entries, laid out as underflow, bins, overflow. With _adopt the counts
+  /// already in _counts are kept, otherwise the current counts are copied
+  /// into it. _counts must outlive the attachment.
+  public: void AttachStorage(uint64_t *_counts, bool _adopt);
+
+  /// \brief Copy the counts back to heap memory and release the storage.
+  public: void DetachStorage();
+
+  public: template<typename Fn>
+  void ForEachBucket(Fn &&_fn) const
+  {
+    const double inf = std::numeric_limits<double>::infinity();
+    const size_t numBins = this->axis.NumBins();
+    if (this->counts[0])
+      _fn(-inf, this->axis.Min(), this->counts[0]);
+    for (size_t ii = 0; ii < numBins; ++ii)
+    {
+      if (this->counts[ii + 1])
+      {
+        _fn(this->axis.Edge(ii), this->axis.Edge(ii + 1),
+            this->counts[ii + 1]);
+      }
+    }
+    if (this->counts[numBins + 1])
+      _fn(this->axis.Max(), inf, this->counts[numBins + 1]);
+  }
+
+  public: void ToBinary(std::ostream & ost) const;
+  public: void FromBinary(std::istream & ist);
+
+  protected: HistogramAxis axis;
+
+  /// \brief Heap storage, unused while attached.
+  protected: std::vector<uint64_t> storage;
+
+  /// \brief Underflow, bins and overflow, in storage or attached memory.
+  protected: uint64_t *counts{nullptr};
+  protected: uint64_t total{0};
+};
+
+/// \brief HDR style buckets: every power of two is split into a fixed number
+/// of linear sub-buckets, so the relative error is bounded over any range.
+class LogLinearBackend
+{
+  /// \brief Most sub-buckets per power of two, larger values are clamped.
+  /// Bounds the buckets a run of finite values can need.
+  public: static constexpr uint32_t kMaxSubBuckets = 4096;
+
+  public: explicit LogLinearBackend(uint32_t _subBuckets = 64);
+
+  public: inline void InsertData(double _value, uint64_t _count = 1)
+  {
+    if (!(_value > 0.0))
+    {
+      if (_value <= 0.0)
+      {
+        this->zeroCount += _count;
+        this->total += _count;
+      }
+      return;
+    }
+    if (!std::isfinite(_value))
+      return;
+
+    int exponent;
+    const double mantissa = std::frexp(_value, &exponent);
+    const int64_t index = static_cast<int64_t>(exponent) * this->subBuckets +
+      static_cast<int64_t>((mantissa - 0.5) * 2.0 * this->subBuckets);
+    this->Grow(index);
+    this->counts[index - this->offset] += _count;
+    this->total += _count;
+  }
+
+  public: bool Compatible(const LogLinearBackend &_other) const;
+  public: void Merge(const LogLinearBackend &_other);
+  public: void Reset();
+  public: uint64_t Count() const { return this->total; }
+  public: size_t MemoryUsage() const;
+  public: uint32_t SubBuckets() const { return this->subBuckets; }
+
+  public: template<typename Fn>
+  void ForEachBucket(Fn &&_fn) const
+  {
+    if (this->zeroCount)
+      _fn(0.0, 0.0, this->zeroCount);
+    for (size_t ii = 0; ii < this->counts.size(); ++ii)
+    {
+      if (this->counts[ii])
+      {
+        const int64_t index = this->offset + static_cast<int64_t>(ii);
+        _fn(this->Lower(index), this->Lower(index + 1), this->counts[ii]);
+      }
+    }
+  }
+
+  public: void ToBinary(std::ostream & ost) const;
+  public: void FromBinary(std::istream & ist);
+
+  protected: double Lower(int64_t _index) const;
+
+  /// \brief Make room for bucket _index.
+  protected: void Grow(int64_t _index);
+
+  protected: uint32_t subBuckets;
+  protected: int64_t offset{0};
+  protected: std::vector<uint64_t> counts;
+  protected: uint64_t zeroCount{0};
+  protected: uint64_t total{0};
+};
+
+/// \brief Uniform bins of a fixed width with no range limit, only the bins
+/// that were hit are stored.
+class SparseBackend
+{
+  public: explicit SparseBackend(double _width = 0.01);
+
+  public: inline void InsertData(double _value, uint64_t _count = 1)
+  {
+    if (!std::isfinite(_value))
+      return;
+    const int64_t key = static_cast<int64_t>(std::floor(_value / this->width));
+    this->counts[key] += _count;
+    this->total += _count;
+  }
+
+  public: bool Compatible(const SparseBackend &_other) const;
+  public: void Merge(const SparseBackend &_other);
+  public: void Reset();
+  public: uint64_t Count() const { return this->total; }
+  public: size_t MemoryUsage() const;
+  public: double Width() const { return this->width; }
+
+  public: template<typename Fn>
+  void ForEachBucket(Fn &&_fn) const
+  {
+    for (const auto &bucket : this->SortedBuckets())
+    {
+      _fn(bucket.first * this->width, (bucket.first + 1) * this->width,
+          bucket.second);
+    }
+  }
+
+  public: void ToBinary(std::ostream & ost) const;
+  public: void FromBinary(std::istream & ist);
+
+  protected: std::vector<std::pair<int64_t, uint64_t>> SortedBuckets() const;
+
+  protected: double width;
+  protected: std::unordered_map<int64_t, uint64_t> counts;
+  protected: uint64_t total{0};
+};
+
+/// \brief DDSketch: bucket i holds (gamma^(i-1), gamma^i], which keeps every
+/// quantile within a relative error alpha. When more than maxBuckets would
+/// be needed the lowest buckets are collapsed, trading accuracy of the
+/// smallest values for bounded memory.
+class DDSketchBackend
+{
+  /// \brief Largest bucket limit, larger values are clamped.
+  public: static constexpr uint32_t kMaxBuckets = uint32_t{1} << 20;
+
+  public: explicit DDSketchBackend(double _alpha = 0.01,
+                                   uint32_t _maxBuckets = 2048);
+
+  public: inline void InsertData(double _value, uint64_t _count = 1)
+  {
+    if (!(_value > kMinIndexable))
+    {
+      if (_value <= kMinIndexable)
+      {
+        this->zeroCount += _count;
+        this->total += _count;
+      }
+      return;
+    }
+    if (!std::isfinite(_value))
+      return;
+
+    const int64_t index = static_cast<int64_t>(
+        std::ceil(std::log(_value) * this->inverseLogGamma));
+    this->counts[this->Slot(index)] += _count;
+    this->total += _count;
+  }
+
+  public: bool Compatible(const DDSketchBackend &_other) const;
+  public: void Merge(const DDSketchBackend &_other);
+  public: void Reset();
+  public: uint64_t Count() const { return this->total; }
+  public: size_t MemoryUsage() const;
+  public: double Alpha() const { return this->alpha; }
+  public: uint32_t MaxBuckets() const { return this->maxBuckets; }
+
+  public: template<typename Fn>
+  void ForEachBucket(Fn &&_fn) const
+  {
+    if (this->zeroCount)
+      _fn(0.0, 0.0, this->zeroCount);
+    for (size_t ii = 0; ii < this->counts.size(); ++ii)
+    {
+      if (this->counts[ii])
+      {
+        const int64_t index = this->offset + static_cast<int64_t>(ii);
+        _fn(std::exp((index - 1) * this->logGamma),
+            std::exp(index * this->logGamma), this->counts[ii]);
+      }
+    }
+  }
+
+  public: void ToBinary(std::ostream & ost) const;
+  public: void FromBinary(std::istream & ist);
+
+  /// \brief Values at or below this go in the zero bucket.
+  protected: static constexpr double kMinIndexable = 1e-9;
+
+  protected: void SetAlpha(double _alpha);
+
+  /// \brief Position of bucket _index in counts, growing or collapsing the
+  /// store as needed.
+  protected: size_t Slot(int64_t _index);
+
+  protected: double alpha;
+  protected: double logGamma;
+  protected: double inverseLogGamma;
+  protected: uint32_t maxBuckets;
+  protected: int64_t offset{0};
+  protected: std::vector<uint64_t> counts;
+  protected: uint64_t zeroCount{0};
+  protected: uint64_t total{0};
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__DISTRIBUTION_BACKENDS_HH_
@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Distribution.hh"
+#include "RingFile.hh"
+
+// Runs every Distribution back-end over the same data and reports insert
+// cost, memory and quantile error against the exact sorted data. The data is
+// synthetic unless a --history ring file recorded from real traffic is given.
+
+namespace
+{
+
+const size_t kDefaultSamples = 1000000;
+const double kQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+const ign_imgui::Distribution::Kind kKinds[] = {
+  ign_imgui::Distribution::Kind::kDense,
+  ign_imgui::Distribution::Kind::kLogLinear,
+  ign_imgui::Distribution::Kind::kSparse,
+  ign_imgui::Distribution::Kind::kDDSketch
+};
+
+using Clock = std::chrono::steady_clock;
+
+//////////////////////////////////////////////////
+std::vector<std::pair<std::string, std::vector<double>>> SyntheticData(
+    size_t _count)
+{
+  std::mt19937_64 rng(42);
+  std::vector<std::pair<std::string, std::vector<double>>> sets;
+
+  // Healthy run: tight around real time.
+  {
+    std::normal_distribution<double> dist(1.0, 0.02);
+    std::vector<double> values(_count);
+    for (auto &value : values)
+      value = dist(rng);
+    sets.emplace_back("normal", std::move(values));
+  }
+
+  // Occasional long stalls give a heavy low tail.
+  {
+    std::lognormal_distribution<double> dist(0.0, 0.5);
+    std::vector<double> values(_count);
+    for (auto &value : values)
+      value = 1.0 / dist(rng);
+    sets.emplace_back("stalls", std::move(values));
+  }
+
+  // Two regimes, e.g. a scene that gets expensive halfway through.
+  {
+    std::normal_distribution<double> fast(1.0, 0.01);
+    std::normal_distribution<double> slow(0.4, 0.05);
+    std::vector<double> values(_count);
+    for (size_t ii = 0; ii < _count; ++ii)
+      values[ii] = ii < _count / 2 ? fast(rng) : slow(rng);
+    sets.emplace_back("bimodal", std::move(values));
+  }
+  return sets;
+}
+
+//////////////////////////////////////////////////
+std::vector<double> HistoryData(const std::string &_path)
+{
+  ign_imgui::RingFileReader reader;
+  reader.Open(_path);
+  std::vector<double> values;
+  values.reserve(reader.Size());
+  const uint64_t written = reader.Written();
+  const uint64_t first = written - reader.Size();
+  for (uint64_t ii = first; ii < written; ++ii)
+  {
+    ign_imgui::RtfSample sample;
+    if (reader.At(ii, sample) && std::isfinite(sample.rtf))
+      values.push_back(sample.rtf);
+  }
+  return values;
+}
+
+//////////////////////////////////////////////////
+double Exact(const std::vector<double> &_sorted, double _q)
+{
+  const size_t index = std::min(_sorted.size() - 1,
+      static_cast<size_t>(_q * _sorted.size()));
+  return _sorted[index];
+}
+
+//////////////////////////////////////////////////
+void Run(const std::string &_name, const std::vector<double> &_values)
+{
+  if (_values.empty())
+    return;
+
+  std::vector<double> sorted = _values;
+  std::sort(sorted.begin(), sorted.end());
+
+  std::printf("\n%s: %zu samples\n", _name.c_str(), _values.size());
+  std::printf("%-10s %9s %9s %9s %9s", "backend", "ns/insert", "ns/batch",
+      "ns/merge", "bytes");
+  for (double q : kQuantiles)
+    std::printf("   err p%-5g", q * 100.0);
+  std::printf("\n");
+
+  for (auto kind : kKinds)
+  {
+    ign_imgui::Distribution scalar;
+    scalar.SetBackend(ign_imgui::Distribution::MakeBackend(kind));
+    auto start = Clock::now();
+    for (double value : _values)
+      scalar.InsertData(value);
+    const double scalarNs = std::chrono::duration<double, std::nano>(
+        Clock::now() - start).count() / _values.size();
+
+    ign_imgui::Distribution batch;
+    batch.SetBackend(ign_imgui::Distribution::MakeBackend(kind));
+    start = Clock::now();
+    batch.InsertData(_values.data(), _values.size());
+    const double batchNs = std::chrono::duration<double, std::nano>(
+        Clock::now() - start).count() / _values.size();
+
+    // Merge two halves, as when combining runs.
+    const size_t half = _values.size() / 2;
+    ign_imgui::Distribution left;
+    ign_imgui::Distribution right;
+    left.SetBackend(ign_imgui::Distribution::MakeBackend(kind));
+    right.SetBackend(ign_imgui::Distribution::MakeBackend(kind));
+    left.InsertData(_values.data(), half);
+    right.InsertData(_values.data() + half, _values.size() - half);
+    start = Clock::now();
+    left.Merge(right);
+    const double mergeNs = std::chrono::duration<double, std::nano>(
+        Clock::now() - start).count();
+
+    std::printf("%-10s %9.1f %9.1f %9.0f %9zu",
+        ign_imgui::Distribution::KindName(kind), scalarNs, batchNs, mergeNs,
+        scalar.MemoryUsage());
+    for (double q : kQuantiles)
+    {
+      const double exact = Exact(sorted, q);
+      const double estimate = scalar.Quantile(q);
+      std::printf("   %10.2e", std::abs(estimate - exact) /
+          std::max(std::abs(exact), 1e-12));
+    }
+    if (left.Count() != scalar.Count())
+      std::printf("   merge count mismatch");
+    std::printf("\n");
+  }
+}
+
+}  // namespace
+
+//////////////////////////////////////////////////
+int main(int _argc, char **_argv)
+{
+  size_t samples = kDefaultSamples;
+  std::string historyFile;
+  for (int i = 1; i < _argc; ++i)
+  {
+    if (i + 1 < _argc && 0 == strcmp(_argv[i], "--samples"))
+    {
+      samples = std::stoull(_argv[++i]);
+      continue;
+    }
+    if (i + 1 < _argc && 0 == strcmp(_argv[i], "--history"))
+    {
+      historyFile = _argv[++i];
+      continue;
+    }
+    std::printf("%s [--samples <NUM_SAMPLES>] [--history <RING_FILE_PATH>]\n",
+        _argv[0]);
+    return 0;
+  }
+
+  if (historyFile.size())
+  {
+    Run(historyFile, HistoryData(historyFile));
+    return 0;
+  }
+
+  for (const auto &set : SyntheticData(samples))
+    Run(set.first, set.second);
+  return 0;
+}
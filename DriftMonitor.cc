@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "DriftMonitor.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <imgui/imgui.h>
+
+namespace
+{
+
+const size_t kDefaultBins = 200;
+const float kDefaultMin = 0.0f;
+const float kDefaultMax = 2.0f;
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+DriftMonitor::DriftMonitor()
+{
+  HistogramAxis defaultAxis;
+  defaultAxis.Set(kDefaultBins, kDefaultMin, kDefaultMax,
+      HistogramAxis::Scale::kUniform);
+  this->SetAxis(defaultAxis);
+}
+
+//////////////////////////////////////////////////
+void DriftMonitor::SetAxis(const HistogramAxis &_axis)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->axis = _axis;
+
+  // Cells sit at the axis minimum, the bin centres and the axis maximum.
+  const size_t numBins = this->axis.NumBins();
+  this->spacing.resize(numBins + 1);
+  double previous = this->axis.Min();
+  for (size_t i = 0; i < numBins; ++i)
+  {
+    const double center =
+      0.5 * (this->axis.Edge(i) + static_cast<double>(this->axis.Edge(i + 1)));
+    this->spacing[i] = center - previous;
+    previous = center;
+  }
+  this->spacing[numBins] = this->axis.Max() - previous;
+
+  this->baselineCdf.clear();
+  this->targets.clear();
+  this->baselineSamples = 0;
+  this->ResetWindow();
+}
+
+//////////////////////////////////////////////////
+void DriftMonitor::SetWindow(size_t _samples)
+{
+  if (_samples == 0)
+    throw std::runtime_error{"drift window must hold at least one sample"};
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->window = _samples;
+  this->ResetWindow();
+}
+
+//////////////////////////////////////////////////
+size_t DriftMonitor::Window() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->window;
+}
+
+//////////////////////////////////////////////////
+void DriftMonitor::SetThreshold(double _threshold)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->threshold = _threshold;
+}
+
+//////////////////////////////////////////////////
+void DriftMonitor::SetBaseline(const Distribution &_distribution)
+{
+  // Counts() leaves out what falls outside the axis, the buckets give the
+  // mass below and above it.
+  std::vector<double> lower;
+  std::vector<double> upper;
+  std::vector<uint64_t> bucketCounts;
+  _distribution.Buckets(lower, upper, bucketCounts);
+
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  const std::vector<float> counts = _distribution.Counts(this->axis);
+  double below = 0.0;
+  double above = 0.0;
+  for (size_t i = 0; i < bucketCounts.size(); ++i)
+  {
+    const bool point = !(lower[i] < upper[i]);
+    if (point ? lower[i] < this->axis.Min() : upper[i] <= this->axis.Min())
+      below += bucketCounts[i];
+    else if (lower[i] >= this->axis.Max())
+      above += bucketCounts[i];
+  }
+
+  double total = below + above;
+  for (const float count : counts)
+    total += count;
+  if (!(total > 0.0))
+    throw std::runtime_error{"baseline distribution has no samples"};
+
+  this->baselineCdf.resize(counts.size() + 1);
+  double cumulative = below;
+  this->baselineCdf[0] = cumulative / total;
+  for (size_t i = 0; i < counts.size(); ++i)
+  {
+    cumulative += counts[i];
+    this->baselineCdf[i + 1] = cumulative / total;
+  }
+  this->baselineSamples = _distribution.Count();
+  this->ResetWindow();
+}
+
+//////////////////////////////////////////////////
+bool DriftMonitor::HasBaseline() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return !this->baselineCdf.empty();
+}
+
+//////////////////////////////////////////////////
+void DriftMonitor::InsertData(double _data)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->Insert(_data);
+}
+
+//////////////////////////////////////////////////
+void DriftMonitor::InsertData(const double *_data, size_t _count)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  for (size_t i = 0; i < _count; ++i)
+    this->Insert(_data[i]);
+}
+
+//////////////////////////////////////////////////
+DriftStats DriftMonitor::Stats() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  DriftStats stats;
+  stats.samples = this->samples;
+  stats.baselineSamples = this->baselineSamples;
+  stats.alarm = this->alarm;
+  stats.alarms = this->alarms;
+  if (this->samples == 0 || this->baselineCdf.empty())
+    return stats;
+
+  const double n = static_cast<double>(this->samples);
+  stats.wasserstein = (this->samples == this->window ? this->sum :
+      this->Sum(this->samples)) / n;
+  for (size_t k = 0; k < this->cumulative.size(); ++k)
+  {
+    stats.ks = std::max(stats.ks,
+        std::abs(this->cumulative[k] / n - this->baselineCdf[k]));
+  }
+  return stats;
+}
+
+//////////////////////////////////////////////////
+void DriftMonitor::Draw()
+{
+  if (!this->HasBaseline())
+    return;
+
+  const DriftStats stats = this->Stats();
+  ImGui::Text("drift over %llu of %zu samples: Wasserstein %.4f, KS %.4f, "
+      "%s (raised %llu times)",
+      static_cast<unsigned long long>(stats.samples), this->Window(),
+      stats.wasserstein, stats.ks, stats.alarm ? "ALARM" : "ok",
+      static_cast<unsigned long long>(stats.alarms));
+
+  std::vector<float> difference;
+  {
+    std::lock_guard<std::mutex> lock(this->dataMutex);
+    if (this->samples == 0)
+      return;
+    difference.resize(this->cumulative.size());
+    for (size_t k = 0; k < difference.size(); ++k)
+    {
+      difference[k] = static_cast<float>(this->cumulative[k] /
+          static_cast<double>(this->samples) - this->baselineCdf[k]);
+    }
+  }
+  ImGui::PlotLines("live - baseline CDF", difference.data(),
+      static_cast<int>(difference.size()), 0, nullptr, -1.0f, 1.0f,
+      ImVec2(0, 60));
+}
+
+//////////////////////////////////////////////////
+size_t DriftMonitor::Cell(double _data) const
+{
+  const float value = static_cast<float>(_data);
+  const int32_t index = this->axis.Index(value);
+  if (index != HistogramAxis::kOutOfRange)
+    return static_cast<size_t>(index) + 1;
+  return value < this->axis.Min() ? 0 : this->axis.NumBins() + 1;
+}
+
+//////////////////////////////////////////////////
+void DriftMonitor::Insert(double _data)
+{
+  if (this->baselineCdf.empty())
+    return;
+
+  const size_t cell = this->Cell(_data);
+  if (this->samples < this->window)
+  {
+    this->ring[this->head] = static_cast<uint32_t>(cell);
+    this->head = (this->head + 1) % this->window;
+    for (size_t k = cell; k < this->cumulative.size(); ++k)
+      ++this->cumulative[k];
+    if (++this->samples < this->window)
+      return;
+    this->sum = this->Sum(this->window);
+    this->sinceRecompute = 0;
+  }
+  else
+  {
+    const size_t evicted = this->ring[this->head];
+    this->ring[this->head] = static_cast<uint32_t>(cell);
+    this->head = (this->head + 1) % this->window;
+    if (cell < evicted)
+      this->Update(cell, evicted, 1);
+    else if (evicted < cell)
+      this->Update(evicted, cell, -1);
+
+    if (++this->sinceRecompute >= this->window)
+    {
+      this->sum = this->Sum(this->window);
+      this->sinceRecompute = 0;
+    }
+  }
+
+  const double distance = this->sum / static_cast<double>(this->window);
+  if (!this->alarm && distance > this->threshold)
+  {
+    this->alarm = true;
+    ++this->alarms;
+  }
+  else if (this->alarm && distance < this->threshold * kClearFraction)
+  {
+    this->alarm = false;
+  }
+}
+
+//////////////////////////////////////////////////
+void DriftMonitor::ResetWindow()
+{
+  this->ring.assign(this->window, 0);
+  this->head = 0;
+  this->samples = 0;
+  this->cumulative.assign(this->spacing.size(), 0);
+  this->targets.resize(this->baselineCdf.size());
+  for (size_t k = 0; k < this->targets.size(); ++k)
+    this->targets[k] = this->baselineCdf[k] * this->window;
+  this->sum = 0.0;
+  this->sinceRecompute = 0;
+  this->alarm = false;
+}
+
+//////////////////////////////////////////////////
+void DriftMonitor::Update(size_t _first, size_t _last, int64_t _delta)
+{
+  for (size_t k = _first; k < _last; ++k)
+  {
+    const double before = std::abs(this->cumulative[k] - this->targets[k]);
+    this->cumulative[k] += _delta;
+    const double after = std::abs(this->cumulative[k] - this->targets[k]);
+    this->sum += this->spacing[k] * (after - before);
+  }
+}
+
+//////////////////////////////////////////////////
+double DriftMonitor::Sum(uint64_t _samples) const
+{
+  const double n = static_cast<double>(_samples);
+  double total = 0.0;
+  for (size_t k = 0; k < this->cumulative.size(); ++k)
+  {
+    total += this->spacing[k] *
+      std::abs(this->cumulative[k] - n * this->baselineCdf[k]);
+  }
+  return total;
+}
+
+}  // namespace ign_imgui
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__DRIFT_MONITOR_HH_
+#define IGN_IMGUI__DRIFT_MONITOR_HH_
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <mutex>
+#include <vector>
+
+#include "Distribution.hh"
+#include "HistogramAxis.hh"
+
+namespace ign_imgui
+{
+
+/// \brief Distance of the recent RTF distribution from the baseline.
+struct DriftStats
+{
+  /// \brief Samples in the window, at most DriftMonitor::Window().
+  uint64_t samples{0};
+  uint64_t baselineSamples{0};
+  /// \brief Wasserstein-1 distance, in units of RTF.
+  double wasserstein{0.0};
+  /// \brief Kolmogorov-Smirnov distance, the largest CDF difference.
+  double ks{0.0};
+  bool alarm{false};
+  /// \brief Times the alarm was raised.
+  uint64_t alarms{0};
+};
+
+/// \brief Compares a sliding window of live RTF samples against a baseline
+/// distribution, e.g. of a known-good run.
+///
+/// Both are binned on one axis, with samples outside it as point masses at
+/// its ends. The Wasserstein distance is the sum over bins of the CDF
+/// difference times the bin spacing. With a full window every sample adds
+/// one count and evicts one, which only changes the CDF between the two
+/// bins, so only those terms of the sum are updated.
+///
+/// The alarm is raised when the distance exceeds the threshold and cleared
+/// when it falls below kClearFraction of it, so a distance hovering at the
+/// threshold doesn't toggle it on every sample.
+class DriftMonitor
+{
+  public: static constexpr size_t kDefaultWindow = 10000;
+  public: static constexpr double kDefaultThreshold = 0.05;
+  public: static constexpr double kClearFraction = 0.8;
+
+  public: DriftMonitor();
+
+  /// \brief Set the axis, dropping the baseline and the window.
+  public: void SetAxis(const HistogramAxis &_axis);
+
+  /// \brief Set the window length in samples, dropping the window.
+  public: void SetWindow(size_t _samples);
+  public: size_t Window() const;
+
+  public: void SetThreshold(double _threshold);
+
+  /// \brief Re-bin _distribution onto the axis as the baseline.
+  /// \throws std::runtime_error if _distribution is empty.
+  public: void SetBaseline(const Distribution &_distribution);
+
+  /// \brief True once SetBaseline() was called.
+  public: bool HasBaseline() const;
+
+  /// \brief Add a finite sample to the window, evicting the oldest once
+  /// the window is full.
+  public: void InsertData(double _data);
+  public: void InsertData(const double *_data, size_t _count);
+
+  /// \brief Distances of the current window, zero while it is empty.
+  public: DriftStats Stats() const;
+
+  public: void Draw();
+
+  /// \brief Cell of _data: 0 below the axis, then the bins, then above.
+  protected: size_t Cell(double _data) const;
+
+  protected: void Insert(double _data);
+
+  /// \brief Empty the window and clear the alarm.
+  protected: void ResetWindow();
+
+  /// \brief Add _delta to the live CDF at cells [_first, _last).
+  protected: void Update(size_t _first, size_t _last, int64_t _delta);
+
+  /// \brief Sum of the weighted CDF differences from scratch.
+  protected: double Sum(uint64_t _samples) const;
+
+  protected: HistogramAxis axis;
+  protected: size_t window{kDefaultWindow};
+  protected: double threshold{kDefaultThreshold};
+
+  /// \brief Distance between the positions of consecutive cells, one per
+  /// point the CDFs are compared at.
+  protected: std::vector<double> spacing;
+
+  /// \brief Baseline CDF at every comparison point, and the same times
+  /// the window length.
+  protected: std::vector<double> baselineCdf;
+  protected: std::vector<double> targets;
+  protected: uint64_t baselineSamples{0};
+
+  /// \brief Cells of the samples in the window, oldest at head once full.
+  protected: std::vector<uint32_t> ring;
+  protected: size_t head{0};
+  protected: uint64_t samples{0};
+
+  /// \brief Live samples at or below every comparison point.
+  protected: std::vector<int64_t> cumulative;
+
+  /// \brief Sum of spacing * |cumulative - targets|, maintained once the
+  /// window is full and recomputed every window to drop rounding error.
+  protected: double sum{0.0};
+  protected: size_t sinceRecompute{0};
+
+  protected: bool alarm{false};
+  protected: uint64_t alarms{0};
+  protected: mutable std::mutex dataMutex;
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__DRIFT_MONITOR_HH_
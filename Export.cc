@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "Export.hh"
+
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include <stdexcept>
+#include <string>
+
+#include "BinaryUtils.hh"
+#include "CsvUtils.hh"
+
+namespace
+{
+
+const char kCheckpointMagic[8] = {'I', 'G', 'N', 'C', 'K', 'P', 'T', '\0'};
+const uint32_t kCheckpointVersion = 2;
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+double WallSeconds()
+{
+  return std::chrono::duration<double>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+//////////////////////////////////////////////////
+Distribution::Backend DenseFromHistogram(
+  const Histogram & _hist)
+{
+  const auto axis = _hist.Axis();
+  const auto counts = _hist.Counts();
+  DenseBackend backend(axis.NumBins(), axis.Min(), axis.Max());
+  for (size_t ii = 0; ii < counts.size(); ++ii) {
+    const double center = 0.5 * (axis.Edge(ii) + axis.Edge(ii + 1));
+    backend.InsertData(center,
+        static_cast<uint64_t>(std::lround(counts[ii])));
+  }
+  return backend;
+}
+
+//////////////////////////////////////////////////
+void ToCsv(
+  std::ostream & ost, const Moments & moments,
+  const Distribution & distribution,
+  const Reservoir & reservoir,
+  const LaggedCorrelation & correlation,
+  const Histogram2D & hist2d,
+  const IntervalHeatmap & intervals,
+  const std::vector<Gap> & gaps,
+  double simTime, double realTime)
+{
+  ost << simTime << "," << realTime << "," << std::endl;
+  ost << moments.Count() << "," << moments.Mean() << "," <<
+    moments.Variance() << "," << moments.Min() << "," << moments.Max() <<
+    "," << moments.Skewness() << "," << moments.Kurtosis() << "," <<
+    std::endl;
+  distribution.ToCsv(ost);
+  reservoir.ToCsv(ost);
+  correlation.ToCsv(ost);
+  hist2d.ToCsv(ost);
+  intervals.ToCsv(ost);
+  ost << gaps.size() << "," << std::endl;
+  for (const auto &gap : gaps) {
+    ost << gap.simStart << "," << gap.simEnd << "," << gap.realStart <<
+      "," << gap.realEnd << "," << gap.wallSeconds << "," << std::endl;
+  }
+}
+
+//////////////////////////////////////////////////
+LoadedData FromCsv(
+  std::istream & ist, Distribution & distribution,
+  Reservoir & reservoir,
+  LaggedCorrelation & correlation,
+  Histogram2D & hist2d,
+  IntervalHeatmap & intervals)
+{
+  LoadedData data;
+  GetNextCsv(ist, data.simTime);
+  GetNextCsv(ist, data.realTime);
+  GetNewLine(ist);
+  GetNextCsv(ist, data.count);
+  GetNextCsv(ist, data.mean);
+  GetNextCsv(ist, data.var);
+  GetNextCsv(ist, data.min);
+  GetNextCsv(ist, data.max);
+  // Exports written before the higher moments existed end the line here
+  if (ist.peek() != '\n' && ist.peek() != '\r') {
+    GetNextCsv(ist, data.skewness);
+    GetNextCsv(ist, data.kurtosis);
+  }
+  GetNewLine(ist);
+
+  // Exports written before the back-ends existed hold a plain histogram
+  if (std::isalpha(ist.peek())) {
+    distribution.FromCsv(ist);
+  } else {
+    Histogram hist;
+    hist.FromCsv(ist);
+    distribution.SetBackend(DenseFromHistogram(hist));
+  }
+  // Exports written before the reservoir existed end after the histogram
+  if (ist.good()) {
+    reservoir.FromCsv(ist);
+  }
+  if (ist.good()) {
+    correlation.FromCsv(ist);
+  }
+  if (ist.good()) {
+    hist2d.FromCsv(ist);
+  }
+  if (ist.good()) {
+    intervals.FromCsv(ist);
+  }
+  if (ist.good()) {
+    size_t numGaps;
+    GetNextCsv(ist, numGaps);
+    // Not GetNewLine(), without gaps the export ends here
+    ist >> std::ws;
+    data.gaps.resize(numGaps);
+    for (auto &gap : data.gaps) {
+      GetNextCsv(ist, gap.simStart);
+      GetNextCsv(ist, gap.simEnd);
+      GetNextCsv(ist, gap.realStart);
+      GetNextCsv(ist, gap.realEnd);
+      GetNextCsv(ist, gap.wallSeconds);
+    }
+    ist >> std::ws;
+  }
+  // Skip whatever newer versions appended
+  while (ist.good()) {
+    std::string str;
+    ist >> str;
+  }
+  IGN_IMGUI_CHECK_STREAM(ist, eof);
+
+  return data;
+}
+
+//////////////////////////////////////////////////
+void ToBinary(
+  std::ostream & ost, const Moments & moments,
+  const Distribution & distribution,
+  const Reservoir & reservoir,
+  const LaggedCorrelation & correlation,
+  const Histogram2D & hist2d,
+  const IntervalHeatmap & intervals,
+  const std::vector<Gap> & gaps,
+  double simTime, double realTime)
+{
+  ost.write(kCheckpointMagic, sizeof(kCheckpointMagic));
+  WriteBinary(ost, kCheckpointVersion);
+  WriteBinary(ost, simTime);
+  WriteBinary(ost, realTime);
+  WriteBinary(ost, WallSeconds());
+  moments.ToBinary(ost);
+  distribution.ToBinary(ost);
+  reservoir.ToBinary(ost);
+  correlation.ToBinary(ost);
+  hist2d.ToBinary(ost);
+  intervals.ToBinary(ost);
+  WriteBinary(ost, gaps);
+}
+
+//////////////////////////////////////////////////
+Checkpoint FromBinary(
+  std::istream & ist, Moments & moments,
+  Distribution & distribution,
+  Reservoir & reservoir,
+  LaggedCorrelation & correlation,
+  Histogram2D & hist2d,
+  IntervalHeatmap & intervals)
+{
+  char magic[sizeof(kCheckpointMagic)];
+  ist.read(magic, sizeof(magic));
+  IGN_IMGUI_CHECK_BINARY(ist);
+  uint32_t version;
+  ReadBinary(ist, version);
+  if (0 != memcmp(magic, kCheckpointMagic, sizeof(magic)) ||
+      version == 0 || version > kCheckpointVersion) {
+    throw std::runtime_error{"failed to parse input binary file"};
+  }
+
+  Checkpoint checkpoint;
+  ReadBinary(ist, checkpoint.simTime);
+  ReadBinary(ist, checkpoint.realTime);
+  ReadBinary(ist, checkpoint.wallTime);
+  moments.FromBinary(ist);
+  // Version 1 checkpoints hold a plain histogram
+  if (version == 1) {
+    Histogram hist;
+    hist.FromBinary(ist);
+    distribution.SetBackend(DenseFromHistogram(hist));
+  } else {
+    distribution.FromBinary(ist);
+  }
+  reservoir.FromBinary(ist);
+  correlation.FromBinary(ist);
+  hist2d.FromBinary(ist);
+  intervals.FromBinary(ist);
+  ReadBinary(ist, checkpoint.gaps);
+  return checkpoint;
+}
+
+//////////////////////////////////////////////////
+bool IsCheckpoint(const char *_data, size_t _size)
+{
+  return _size >= sizeof(kCheckpointMagic) &&
+    0 == memcmp(_data, kCheckpointMagic, sizeof(kCheckpointMagic));
+}
+
+}  // namespace ign_imgui
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__EXPORT_HH_
+#define IGN_IMGUI__EXPORT_HH_
+
+#include <cstdlib>
+
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "Distribution.hh"
+#include "Histogram.hh"
+#include "Histogram2D.hh"
+#include "IntervalHeatmap.hh"
+#include "LaggedCorrelation.hh"
+#include "Moments.hh"
+#include "Reservoir.hh"
+
+namespace ign_imgui
+{
+
+/// \brief Wall clock time in seconds since the epoch, comparable across
+/// process restarts unlike SteadySeconds().
+double WallSeconds();
+
+/// \brief Stretch of the run that is missing from the accumulated data
+/// because the monitor was not running, e.g. between a checkpoint and the
+/// restart that resumed from it.
+struct Gap
+{
+  double simStart;
+  double simEnd;
+  double realStart;
+  double realEnd;
+  double wallSeconds;
+};
+
+/// \brief Summary statistics and clock of a CSV export.
+struct LoadedData
+{
+  size_t count;
+  double mean;
+  double var;
+  double max;
+  double min;
+  double skewness{0.0};
+  double kurtosis{0.0};
+
+  double realTime;
+  double simTime;
+
+  std::vector<Gap> gaps;
+};
+
+/// \brief Header fields of a checkpoint, the point the run stopped at.
+struct Checkpoint
+{
+  double simTime;
+  double realTime;
+  double wallTime;
+  std::vector<Gap> gaps;
+};
+
+/// \brief Dense back-end holding the same counts as _hist.
+Distribution::Backend DenseFromHistogram(const Histogram & _hist);
+
+void ToCsv(
+  std::ostream & ost, const Moments & moments,
+  const Distribution & distribution,
+  const Reservoir & reservoir,
+  const LaggedCorrelation & correlation,
+  const Histogram2D & hist2d,
+  const IntervalHeatmap & intervals,
+  const std::vector<Gap> & gaps,
+  double simTime, double realTime);
+
+LoadedData FromCsv(
+  std::istream & ist, Distribution & distribution,
+  Reservoir & reservoir,
+  LaggedCorrelation & correlation,
+  Histogram2D & hist2d,
+  IntervalHeatmap & intervals);
+
+/// \brief Write the full accumulation state, unlike ToCsv() this keeps
+/// everything needed to continue inserting, e.g. the central moments and the
+/// reservoir sampler position.
+void ToBinary(
+  std::ostream & ost, const Moments & moments,
+  const Distribution & distribution,
+  const Reservoir & reservoir,
+  const LaggedCorrelation & correlation,
+  const Histogram2D & hist2d,
+  const IntervalHeatmap & intervals,
+  const std::vector<Gap> & gaps,
+  double simTime, double realTime);
+
+Checkpoint FromBinary(
+  std::istream & ist, Moments & moments,
+  Distribution & distribution,
+  Reservoir & reservoir,
+  LaggedCorrelation & correlation,
+  Histogram2D & hist2d,
+  IntervalHeatmap & intervals);
+
+/// \brief Whether _data starts with the magic of a binary checkpoint.
+bool IsCheckpoint(const char *_data, size_t _size);
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__EXPORT_HH_
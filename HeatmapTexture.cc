@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HeatmapTexture.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+//////////////////////////////////////////////////
+ign_imgui::TextureBackend &Backend()
+{
+  static ign_imgui::TextureBackend backend;
+  return backend;
+}
+
+/// \brief Viridis sampled at five evenly spaced stops.
+const uint8_t kColorStops[5][3] = {
+  {68, 1, 84},
+  {59, 82, 139},
+  {33, 145, 140},
+  {94, 201, 98},
+  {253, 231, 37},
+};
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+HeatmapTexture::~HeatmapTexture()
+{
+  if (this->texture && Backend().destroy)
+    Backend().destroy(this->texture);
+}
+
+//////////////////////////////////////////////////
+void HeatmapTexture::SetBackend(const TextureBackend &_backend)
+{
+  Backend() = _backend;
+}
+
+//////////////////////////////////////////////////
+bool HeatmapTexture::IsCurrent(uint64_t _generation) const
+{
+  return this->texture && this->generation == _generation;
+}
+
+//////////////////////////////////////////////////
+void HeatmapTexture::Update(const float *_values, int _width, int _height,
+                            float _maxValue, uint64_t _generation)
+{
+  if (_width != this->width || _height != this->height)
+    this->Resize(_width, _height);
+
+  for (size_t ii = 0; ii < this->pixels.size(); ++ii)
+    this->pixels[ii] = Color(_values[ii], _maxValue);
+
+  this->generation = _generation;
+  this->Upload(0, this->width);
+}
+
+//////////////////////////////////////////////////
+void HeatmapTexture::UpdateColumn(int _column, const float *_values,
+                                  float _maxValue, uint64_t _generation)
+{
+  if (_column < 0 || _column >= this->width)
+    return;
+
+  for (int row = 0; row < this->height; ++row)
+    this->pixels[row * this->width + _column] = Color(_values[row], _maxValue);
+
+  this->generation = _generation;
+  this->Upload(_column, 1);
+}
+
+//////////////////////////////////////////////////
+void HeatmapTexture::Resize(int _width, int _height)
+{
+  auto &backend = Backend();
+  if (this->texture && backend.destroy)
+    backend.destroy(this->texture);
+  this->texture = nullptr;
+
+  this->width = _width;
+  this->height = _height;
+  this->pixels.assign(static_cast<size_t>(_width) * _height, Color(0, 0));
+  this->generation = UINT64_MAX;
+
+  if (backend.create && _width > 0 && _height > 0)
+  {
+    this->texture = backend.create(_width, _height);
+    this->Upload(0, _width);
+  }
+}
+
+//////////////////////////////////////////////////
+int HeatmapTexture::Width() const
+{
+  return this->width;
+}
+
+//////////////////////////////////////////////////
+int HeatmapTexture::Height() const
+{
+  return this->height;
+}
+
+//////////////////////////////////////////////////
+void HeatmapTexture::Draw(const ImVec2 &_size, const ImVec2 &_uv0,
+                          const ImVec2 &_uv1)
+{
+  if (!this->texture)
+  {
+    ImGui::TextUnformatted("(no texture backend for heatmap)");
+    return;
+  }
+  ImGui::Image(this->texture, _size, _uv0, _uv1);
+}
+
+//////////////////////////////////////////////////
+uint32_t HeatmapTexture::Color(float _value, float _maxValue)
+{
+  float t = 0.0f;
+  if (_maxValue > 0.0f && _value > 0.0f)
+    t = std::log1p(_value) / std::log1p(_maxValue);
+  t = std::min(std::max(t, 0.0f), 1.0f) * 4.0f;
+
+  const int stop = std::min(static_cast<int>(t), 3);
+  const float frac = t - stop;
+  uint32_t rgb[3];
+  for (int cc = 0; cc < 3; ++cc)
+  {
+    rgb[cc] = static_cast<uint32_t>(kColorStops[stop][cc] +
+        frac * (kColorStops[stop + 1][cc] - kColorStops[stop][cc]));
+  }
+  return IM_COL32(rgb[0], rgb[1], rgb[2], 255);
+}
+
+//////////////////////////////////////////////////
+void HeatmapTexture::Upload(int _x, int _width)
+{
+  auto &backend = Backend();
+  if (!this->texture || !backend.update)
+    return;
+
+  if (_width == this->width)
+  {
+    backend.update(this->texture, 0, 0, this->width, this->height,
+        this->pixels.data());
+    return;
+  }
+
+  this->column.resize(static_cast<size_t>(_width) * this->height);
+  for (int row = 0; row < this->height; ++row)
+  {
+    std::copy_n(this->pixels.begin() + row * this->width + _x, _width,
+        this->column.begin() + row * _width);
+  }
+  backend.update(this->texture, _x, 0, _width, this->height,
+      this->column.data());
+}
+
+}  // namespace ign_imgui
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__HEATMAP_TEXTURE_HH_
+#define IGN_IMGUI__HEATMAP_TEXTURE_HH_
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <imgui/imgui.h>
+
+namespace ign_imgui
+{
+
+/// \brief Renderer hooks for creating and updating RGBA8 textures.
+///
+/// ImGui leaves texture management to the graphics backend, so whoever sets
+/// up the frame loop installs these once with HeatmapTexture::SetBackend().
+/// No window backend is linked yet, until one installs these hooks every
+/// heatmap draws a "no texture backend" placeholder.
+struct TextureBackend
+{
+  std::function<ImTextureID(int _width, int _height)> create;
+  std::function<void(ImTextureID _texture, int _x, int _y,
+                     int _width, int _height, const uint32_t *_rgba)> update;
+  std::function<void(ImTextureID _texture)> destroy;
+};
+
+/// \brief A cached texture of a grid of values, drawn as an ImGui image.
+///
+/// Values are colour mapped on the CPU and only uploaded when the data
+/// generation changes, or one column at a time with UpdateColumn(). Must
+/// only be used from the thread running the frame loop.
+class HeatmapTexture
+{
+  public: HeatmapTexture() = default;
+  public: ~HeatmapTexture();
+
+  public: HeatmapTexture(const HeatmapTexture &) = delete;
+  public: HeatmapTexture &operator=(const HeatmapTexture &) = delete;
+
+  public: static void SetBackend(const TextureBackend &_backend);
+
+  /// \brief Whether the texture already shows data of _generation.
+  public: bool IsCurrent(uint64_t _generation) const;
+
+  /// \brief Recolour and upload the whole texture.
+  /// \param[in] _values Row-major values, row 0 drawn at the top.
+  /// \param[in] _maxValue Value mapped to the top of the colour scale.
+  public: void Update(const float *_values, int _width, int _height,
+                      float _maxValue, uint64_t _generation);
+
+  /// \brief Recolour and upload a single column, keeping the rest.
+  /// \param[in] _values _height values, top row first.
+  public: void UpdateColumn(int _column, const float *_values,
+                            float _maxValue, uint64_t _generation);
+
+  /// \brief Resize to _width x _height, clearing to the lowest colour.
+  public: void Resize(int _width, int _height);
+
+  public: int Width() const;
+  public: int Height() const;
+
+  public: void Draw(const ImVec2 &_size,
+                    const ImVec2 &_uv0 = ImVec2(0, 0),
+                    const ImVec2 &_uv1 = ImVec2(1, 1));
+
+  /// \brief Log-scaled colour for _value in [0, _maxValue].
+  public: static uint32_t Color(float _value, float _maxValue);
+
+  protected: void Upload(int _x, int _width);
+
+  protected: ImTextureID texture{nullptr};
+  protected: int width{0};
+  protected: int height{0};
+  protected: uint64_t generation{UINT64_MAX};
+  protected: std::vector<uint32_t> pixels;
+  protected: std::vector<uint32_t> column;
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__HEATMAP_TEXTURE_HH_
@@ -15,17 +15,66 @@
  *
  */
 
+#include "BinaryUtils.hh"
 #include "CsvUtils.hh"
 #include "Histogram.hh"
 
 #include <algorithm>
+#include <cstdint>
 #include <istream>
 #include <ostream>
 #include <sstream>
+#include <utility>
+
+namespace
+{
+
+const size_t kBatchSize = 256;
+
+}  // namespace
 
 namespace ign_imgui
 {
 
+//////////////////////////////////////////////////
+Histogram::Histogram(Histogram &&_other) noexcept
+{
+  this->Swap(_other);
+}
+
+//////////////////////////////////////////////////
+Histogram &Histogram::operator=(Histogram &&_other) noexcept
+{
+  if (this != &_other)
+  {
+    Histogram empty;
+    this->Swap(empty);
+    this->Swap(_other);
+  }
+  return *this;
+}
+
+//////////////////////////////////////////////////
+void Histogram::Swap(Histogram &_other) noexcept
+{
+  if (this == &_other)
+    return;
+  std::lock(this->dataMutex, _other.dataMutex);
+  std::lock_guard<std::mutex> lock(this->dataMutex, std::adopt_lock);
+  std::lock_guard<std::mutex> otherLock(_other.dataMutex, std::adopt_lock);
+  std::swap(this->numBins, _other.numBins);
+  std::swap(this->minBin, _other.minBin);
+  std::swap(this->maxBin, _other.maxBin);
+  std::swap(this->binStep, _other.binStep);
+  std::swap(this->axis, _other.axis);
+  this->counts.Swap(_other.counts);
+  std::swap(this->plot, _other.plot);
+  // Either plot may have cached the other generation number.
+  const uint64_t next = std::max(this->generation, _other.generation) + 1;
+  this->generation = next;
+  _other.generation = next;
+}
+
 //////////////////////////////////////////////////
 void Histogram::SetNumBins(size_t _numBins)
 {
@@ -45,20 +94,66 @@ void Histogram::SetRange(float _min, float _max)
 void Histogram::InsertData(float _data)
 {
   std::lock_guard<std::mutex> lock(this->dataMutex);
-  for (size_t ii = 0; ii < this->numBins; ++ii)
+  const auto index = this->axis.Index(_data);
+  if (index != HistogramAxis::kOutOfRange)
+    this->counts[index] += 1;
+  ++this->generation;
+}
+
+//////////////////////////////////////////////////
+void Histogram::InsertData(const float *_data, size_t _count)
+{
+  int32_t indices[kBatchSize];
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  for (size_t start = 0; start < _count; start += kBatchSize)
   {
-    if (_data <= this->bins[ii])
+    const size_t batch = std::min(kBatchSize, _count - start);
+    this->axis.Indices(_data + start, indices, batch);
+    for (size_t ii = 0; ii < batch; ++ii)
     {
-      this->counts[ii - 1] += 1;
-      break;
+      if (indices[ii] != HistogramAxis::kOutOfRange)
+        this->counts[indices[ii]] += 1;
     }
   }
+  ++this->generation;
 }
 
 //////////////////////////////////////////////////
 void Histogram::Reset()
 {
-  this->Update();
+  // The old counts are zeroed by the pool thread.
+  this->TakeCounts();
+}
+
+//////////////////////////////////////////////////
+HistogramBuffer Histogram::TakeCounts()
+{
+  auto zeroed = HistogramPool::Instance().Acquire(this->numBins);
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->counts.Swap(zeroed);
+  ++this->generation;
+  return zeroed;
+}
+
+//////////////////////////////////////////////////
+std::vector<float> Histogram::Counts() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return std::vector<float>(this->counts.begin(), this->counts.end());
+}
+
+//////////////////////////////////////////////////
+void Histogram::CopyCounts(std::vector<float> &_counts) const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  _counts.assign(this->counts.begin(), this->counts.end());
+}
+
+//////////////////////////////////////////////////
+HistogramAxis Histogram::Axis() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->axis;
 }
 
 //////////////////////////////////////////////////
@@ -66,29 +161,25 @@ void Histogram::Update()
 {
   std::lock_guard<std::mutex> lock(this->dataMutex);
   this->binStep = (this->maxBin - this->minBin) / this->numBins;
-  this->counts = std::vector<float>(this->numBins, 0);
-  this->bins = std::vector<float>(this->numBins, 0.0);
-  for (size_t ii = 0; ii < this->numBins; ++ii)
-  {
-    this->bins[ii] = ii * this->binStep;
-  }
+  this->axis.Set(this->numBins, this->minBin, this->maxBin,
+      HistogramAxis::Scale::kUniform);
+  this->counts = HistogramPool::Instance().Acquire(this->numBins);
+  ++this->generation;
 }
 
 //////////////////////////////////////////////////
 void Histogram::PlotHistogram(const std::string &_label, ImVec2 _graphSize)
 {
-  std::lock_guard<std::mutex> lock(this->dataMutex);
-  auto maxCount = *std::max_element(this->counts.begin(), this->counts.end());
-  auto minCount = *std::min_element(this->counts.begin(), this->counts.end());
-
-  ImGui::PlotHistogram(_label.c_str(),
-                       &this->counts[0],
-                       this->counts.size(),
-                       0,
-                       NULL,
-                       minCount,
-                       maxCount,
-                       _graphSize);
+  const ImVec2 graphSize = HistogramPlot::GraphSize(_graphSize);
+  {
+    std::lock_guard<std::mutex> lock(this->dataMutex);
+    if (this->plot.Stale(this->generation, graphSize.x))
+    {
+      this->plot.Update(this->counts.Data(), this->counts.Size(), this->axis,
+          this->generation, graphSize.x);
+    }
+  }
+  this->plot.Draw(_label, graphSize);
 }
 
 //////////////////////////////////////////////////
@@ -112,13 +203,41 @@ void Histogram::FromCsv(std::istream & ist)
   this->Update();
 
 
-  for (size_t i = 0u; ist.good() && i < this->counts.size(); ++i) {
+  for (size_t i = 0u; ist.good() && i < this->counts.Size(); ++i) {
     float val;
     GetNextCsv(ist, val);
-    this->counts.at(i) = val;
+    this->counts.Data()[i] = val;
   }
+  ++this->generation;
   ist >> std::ws;
 }
 
-}  // namespace ign_imgui
+//////////////////////////////////////////////////
+void Histogram::ToBinary(std::ostream & ost) const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  WriteBinary(ost, this->minBin);
+  WriteBinary(ost, this->maxBin);
+  // Same layout as WriteBinary() of a std::vector<float>.
+  WriteBinary(ost, static_cast<uint64_t>(this->counts.Size()));
+  ost.write(reinterpret_cast<const char *>(this->counts.Data()),
+      this->counts.Size() * sizeof(float));
+}
+
+//////////////////////////////////////////////////
+void Histogram::FromBinary(std::istream & ist)
+{
+  std::vector<float> newCounts;
+  ReadBinary(ist, this->minBin);
+  ReadBinary(ist, this->maxBin);
+  ReadBinary(ist, newCounts);
+  this->numBins = newCounts.size();
+
+  this->Update();
 
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  std::copy(newCounts.begin(), newCounts.end(), this->counts.begin());
+  ++this->generation;
+}
+
+}  // namespace ign_imgui
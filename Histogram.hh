@@ -18,6 +18,7 @@
 #ifndef IGN_IMGUI__HISTOGRAM_HH_
 #define IGN_IMGUI__HISTOGRAM_HH_
 
+#include <cstdint>
 #include <cstdlib>
 
 #include <istream>
@@ -29,19 +30,51 @@
 
 #include <imgui/imgui.h>
 
+#include "HistogramAxis.hh"
+#include "HistogramPlot.hh"
+#include "HistogramPool.hh"
+
 namespace ign_imgui
 {
 
+/// \brief Uniform histogram whose counts are borrowed from
+/// HistogramPool::Instance(), so resetting, rotating and moving it does not
+/// allocate or touch the counts.
 class Histogram
 {
   public: Histogram() = default;
 
+  /// \brief Take the layout, counts and plot of _other, which is left
+  /// without bins.
+  public: Histogram(Histogram &&_other) noexcept;
+  public: Histogram &operator=(Histogram &&_other) noexcept;
+
+  /// \brief Exchange layout, counts and plot with _other.
+  public: void Swap(Histogram &_other) noexcept;
+
   public: void SetNumBins(size_t _numBins);
   public: void SetRange(float _min, float _max);
   public: void InsertData(float _data);
+
+  /// \brief Insert _count values at once, with the SIMD bin index kernel.
+  public: void InsertData(const float *_data, size_t _count);
   public: void Draw();
+
+  /// \brief Zero the counts by swapping in a zeroed buffer from the pool.
   public: void Reset();
 
+  /// \brief Hand out the counts and continue with zeroed ones, O(1).
+  public: HistogramBuffer TakeCounts();
+
+  /// \brief Copy of the current counts, one per bin.
+  public: std::vector<float> Counts() const;
+
+  /// \brief Copy the counts into _counts, reusing its capacity.
+  public: void CopyCounts(std::vector<float> &_counts) const;
+
+  /// \brief Copy of the bin layout matching Counts().
+  public: HistogramAxis Axis() const;
+
   public: void PlotHistogram(const std::string &_label,
                              ImVec2 _graphSize=ImVec2(0,0));
 
@@ -49,15 +82,24 @@ class Histogram
 
   public: void FromCsv(std::istream & ist);
 
+  public: void ToBinary(std::ostream & ost) const;
+
+  public: void FromBinary(std::istream & ist);
+
 
   protected: void Update();
 
-  protected: size_t numBins;
-  protected: float minBin;
-  protected: float maxBin;
-  protected: float binStep;
-  protected: std::vector<float> counts;
-  protected: std::vector<float> bins;
+  protected: size_t numBins{0};
+  protected: float minBin{0.0f};
+  protected: float maxBin{0.0f};
+  protected: float binStep{0.0f};
+  protected: HistogramAxis axis;
+  protected: HistogramBuffer counts;
+
+  /// \brief Bumped whenever the counts change, so the plot knows when its
+  /// columns are stale.
+  protected: uint64_t generation{0};
+  protected: HistogramPlot plot;
   protected: mutable std::mutex dataMutex;
 };
 
@@ -0,0 +1,365 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "BinaryUtils.hh"
+#include "CsvUtils.hh"
+#include "Histogram2D.hh"
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+namespace
+{
+
+/// \brief Number of pairs binned per SIMD batch.
+const size_t kBatchSize = 256;
+
+/// \brief One hit cell of a sparse histogram, as stored in binary exports.
+struct SparseCell
+{
+  uint32_t index;
+  float count;
+};
+
+//////////////////////////////////////////////////
+void AxisToCsv(std::ostream & ost, const ign_imgui::HistogramAxis &_axis)
+{
+  ost << _axis.Min() << "," << _axis.Max() << "," << _axis.NumBins() << "," <<
+    static_cast<int>(_axis.GetScale()) << ",";
+}
+
+//////////////////////////////////////////////////
+void AxisFromCsv(std::istream & ist, ign_imgui::HistogramAxis &_axis)
+{
+  float min;
+  float max;
+  size_t numBins;
+  int scale;
+  ign_imgui::GetNextCsv(ist, min);
+  ign_imgui::GetNextCsv(ist, max);
+  ign_imgui::GetNextCsv(ist, numBins);
+  ign_imgui::GetNextCsv(ist, scale);
+  _axis.Set(numBins, min, max,
+      static_cast<ign_imgui::HistogramAxis::Scale>(scale));
+}
+
+//////////////////////////////////////////////////
+void AxisToBinary(std::ostream & ost, const ign_imgui::HistogramAxis &_axis)
+{
+  ign_imgui::WriteBinary(ost, _axis.Min());
+  ign_imgui::WriteBinary(ost, _axis.Max());
+  ign_imgui::WriteBinary(ost, static_cast<uint64_t>(_axis.NumBins()));
+  ign_imgui::WriteBinary(ost, static_cast<int32_t>(_axis.GetScale()));
+}
+
+//////////////////////////////////////////////////
+void AxisFromBinary(std::istream & ist, ign_imgui::HistogramAxis &_axis)
+{
+  float min;
+  float max;
+  uint64_t numBins;
+  int32_t scale;
+  ign_imgui::ReadBinary(ist, min);
+  ign_imgui::ReadBinary(ist, max);
+  ign_imgui::ReadBinary(ist, numBins);
+  ign_imgui::ReadBinary(ist, scale);
+  _axis.Set(numBins, min, max,
+      static_cast<ign_imgui::HistogramAxis::Scale>(scale));
+}
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+void Histogram2D::SetAxes(const HistogramAxis &_x, const HistogramAxis &_y)
+{
+  this->xAxis = _x;
+  this->yAxis = _y;
+  this->Update();
+}
+
+//////////////////////////////////////////////////
+void Histogram2D::SetStorage(Storage _storage)
+{
+  this->storage = _storage;
+  this->Update();
+}
+
+//////////////////////////////////////////////////
+void Histogram2D::InsertData(float _x, float _y)
+{
+  const auto ix = this->xAxis.Index(_x);
+  const auto iy = this->yAxis.Index(_y);
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->Increment(ix, iy);
+}
+
+//////////////////////////////////////////////////
+void Histogram2D::InsertData(const float *_x, const float *_y, size_t _count)
+{
+  int32_t ix[kBatchSize];
+  int32_t iy[kBatchSize];
+  for (size_t start = 0; start < _count; start += kBatchSize)
+  {
+    const size_t batch = std::min(kBatchSize, _count - start);
+    this->xAxis.Indices(_x + start, ix, batch);
+    this->yAxis.Indices(_y + start, iy, batch);
+
+    std::lock_guard<std::mutex> lock(this->dataMutex);
+    for (size_t ii = 0; ii < batch; ++ii)
+      this->Increment(ix[ii], iy[ii]);
+  }
+}
+
+//////////////////////////////////////////////////
+void Histogram2D::Reset()
+{
+  this->Update();
+}
+
+//////////////////////////////////////////////////
+const HistogramAxis &Histogram2D::XAxis() const
+{
+  return this->xAxis;
+}
+
+//////////////////////////////////////////////////
+const HistogramAxis &Histogram2D::YAxis() const
+{
+  return this->yAxis;
+}
+
+//////////////////////////////////////////////////
+float Histogram2D::Count(size_t _ix, size_t _iy) const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  const size_t index = _iy * this->xAxis.NumBins() + _ix;
+  if (this->storage == Storage::kDense)
+    return this->dense.at(index);
+  auto cell = this->sparse.find(static_cast<uint32_t>(index));
+  return cell == this->sparse.end() ? 0.0f : cell->second;
+}
+
+//////////////////////////////////////////////////
+uint64_t Histogram2D::Generation() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->generation;
+}
+
+//////////////////////////////////////////////////
+void Histogram2D::PlotHeatmap(const std::string &_label, ImVec2 _graphSize)
+{
+  const int width = static_cast<int>(this->xAxis.NumBins());
+  const int height = static_cast<int>(this->yAxis.NumBins());
+  bool stale = false;
+  uint64_t currentGeneration;
+  {
+    // Only copy under the lock, colour mapping and upload happen outside.
+    std::lock_guard<std::mutex> lock(this->dataMutex);
+    currentGeneration = this->generation;
+    stale = !this->texture.IsCurrent(currentGeneration);
+    if (stale)
+    {
+      // Texture rows run top to bottom, y bins bottom to top.
+      this->pixels.assign(static_cast<size_t>(width) * height, 0.0f);
+      auto pixel = [&](size_t _index) -> float &
+      {
+        const size_t ix = _index % width;
+        const size_t iy = _index / width;
+        return this->pixels[(height - 1 - iy) * width + ix];
+      };
+      if (this->storage == Storage::kDense)
+      {
+        for (size_t ii = 0; ii < this->dense.size(); ++ii)
+          pixel(ii) = this->dense[ii];
+      }
+      else
+      {
+        for (const auto &cell : this->sparse)
+          pixel(cell.first) = cell.second;
+      }
+    }
+  }
+
+  if (stale)
+  {
+    const float maxCount = this->pixels.empty() ? 0.0f :
+      *std::max_element(this->pixels.begin(), this->pixels.end());
+    this->texture.Update(this->pixels.data(), width, height, maxCount,
+        currentGeneration);
+  }
+
+  if (_graphSize.x <= 0.0f)
+    _graphSize.x = ImGui::CalcItemWidth();
+  if (_graphSize.y <= 0.0f)
+    _graphSize.y = _graphSize.x * 0.5f;
+  this->texture.Draw(_graphSize);
+  ImGui::SameLine();
+  ImGui::TextUnformatted(_label.c_str());
+}
+
+//////////////////////////////////////////////////
+void Histogram2D::ToCsv(std::ostream & ost) const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  AxisToCsv(ost, this->xAxis);
+  AxisToCsv(ost, this->yAxis);
+  ost << std::endl;
+
+  const size_t nx = this->xAxis.NumBins();
+  const size_t ny = this->yAxis.NumBins();
+  for (size_t iy = 0; iy < ny; ++iy)
+  {
+    for (size_t ix = 0; ix < nx; ++ix)
+    {
+      const size_t index = iy * nx + ix;
+      float count = 0.0f;
+      if (this->storage == Storage::kDense)
+      {
+        count = this->dense[index];
+      }
+      else
+      {
+        auto cell = this->sparse.find(static_cast<uint32_t>(index));
+        if (cell != this->sparse.end())
+          count = cell->second;
+      }
+      ost << count << ",";
+    }
+    ost << std::endl;
+  }
+}
+
+//////////////////////////////////////////////////
+void Histogram2D::FromCsv(std::istream & ist)
+{
+  AxisFromCsv(ist, this->xAxis);
+  AxisFromCsv(ist, this->yAxis);
+  GetNewLine(ist);
+
+  this->Update();
+
+  const size_t nx = this->xAxis.NumBins();
+  const size_t ny = this->yAxis.NumBins();
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  for (size_t index = 0; index < nx * ny; ++index)
+  {
+    float count;
+    GetNextCsv(ist, count);
+    if (this->storage == Storage::kDense)
+      this->dense[index] = count;
+    else if (count != 0.0f)
+      this->sparse[static_cast<uint32_t>(index)] = count;
+  }
+  ist >> std::ws;
+}
+
+//////////////////////////////////////////////////
+void Histogram2D::ToBinary(std::ostream & ost) const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  AxisToBinary(ost, this->xAxis);
+  AxisToBinary(ost, this->yAxis);
+  WriteBinary(ost, static_cast<int32_t>(this->storage));
+  if (this->storage == Storage::kDense)
+  {
+    WriteBinary(ost, this->dense);
+  }
+  else
+  {
+    std::vector<SparseCell> cells;
+    cells.reserve(this->sparse.size());
+    for (const auto &cell : this->sparse)
+      cells.push_back({cell.first, cell.second});
+    WriteBinary(ost, cells);
+  }
+}
+
+//////////////////////////////////////////////////
+void Histogram2D::FromBinary(std::istream & ist)
+{
+  int32_t newStorage;
+  AxisFromBinary(ist, this->xAxis);
+  AxisFromBinary(ist, this->yAxis);
+  ReadBinary(ist, newStorage);
+  if (newStorage != static_cast<int32_t>(Storage::kDense) &&
+      newStorage != static_cast<int32_t>(Storage::kSparse))
+  {
+    throw std::runtime_error{"failed to parse input binary file"};
+  }
+  this->storage = static_cast<Storage>(newStorage);
+
+  this->Update();
+
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  if (this->storage == Storage::kDense)
+  {
+    ReadBinary(ist, this->dense);
+    if (this->dense.size() != this->xAxis.NumBins() * this->yAxis.NumBins())
+      throw std::runtime_error{"failed to parse input binary file"};
+  }
+  else
+  {
+    std::vector<SparseCell> cells;
+    ReadBinary(ist, cells);
+    const size_t numCells = this->xAxis.NumBins() * this->yAxis.NumBins();
+    for (const auto &cell : cells)
+    {
+      if (cell.index >= numCells)
+        throw std::runtime_error{"failed to parse input binary file"};
+    }
+    for (const auto &cell : cells)
+      this->sparse[cell.index] = cell.count;
+  }
+}
+
+//////////////////////////////////////////////////
+void Histogram2D::Update()
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->sparse.clear();
+  if (this->storage == Storage::kDense)
+  {
+    this->dense = std::vector<float>(
+        this->xAxis.NumBins() * this->yAxis.NumBins(), 0);
+  }
+  else
+  {
+    this->dense = std::vector<float>();
+  }
+  ++this->generation;
+}
+
+//////////////////////////////////////////////////
+void Histogram2D::Increment(int32_t _ix, int32_t _iy)
+{
+  if (_ix == HistogramAxis::kOutOfRange || _iy == HistogramAxis::kOutOfRange)
+    return;
+  const size_t index = _iy * this->xAxis.NumBins() + _ix;
+  if (this->storage == Storage::kDense)
+    this->dense[index] += 1;
+  else
+    this->sparse[static_cast<uint32_t>(index)] += 1;
+  ++this->generation;
+}
+
+}  // namespace ign_imgui
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__HISTOGRAM2D_HH_
+#define IGN_IMGUI__HISTOGRAM2D_HH_
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <imgui/imgui.h>
+
+#include "HeatmapTexture.hh"
+#include "HistogramAxis.hh"
+
+namespace ign_imgui
+{
+
+/// \brief Joint histogram of two variables, e.g. RTF against step size.
+class Histogram2D
+{
+  /// \brief Dense keeps every cell, sparse only the cells that were hit.
+  public: enum class Storage
+  {
+    kDense,
+    kSparse
+  };
+
+  public: Histogram2D() = default;
+
+  public: void SetAxes(const HistogramAxis &_x, const HistogramAxis &_y);
+  public: void SetStorage(Storage _storage);
+  public: void InsertData(float _x, float _y);
+
+  /// \brief Insert _count pairs; bins are computed in SIMD batches and the
+  /// lock is taken once per batch.
+  public: void InsertData(const float *_x, const float *_y, size_t _count);
+  public: void Reset();
+
+  public: const HistogramAxis &XAxis() const;
+  public: const HistogramAxis &YAxis() const;
+  public: float Count(size_t _ix, size_t _iy) const;
+
+  /// \brief Incremented on every change to the counts.
+  public: uint64_t Generation() const;
+
+  /// \brief Draw as a heatmap, x to the right and y upwards. The texture is
+  /// only rebuilt when the counts changed since the last call.
+  public: void PlotHeatmap(const std::string &_label,
+                           ImVec2 _graphSize=ImVec2(0,0));
+
+  public: void ToCsv(std::ostream & ost) const;
+
+  public: void FromCsv(std::istream & ist);
+
+  public: void ToBinary(std::ostream & ost) const;
+
+  public: void FromBinary(std::istream & ist);
+
+  protected: void Update();
+
+  protected: void Increment(int32_t _ix, int32_t _iy);
+
+  protected: HistogramAxis xAxis;
+  protected: HistogramAxis yAxis;
+  protected: Storage storage{Storage::kDense};
+  protected: std::vector<float> dense;
+  protected: std::unordered_map<uint32_t, float> sparse;
+  protected: uint64_t generation{0};
+  protected: HeatmapTexture texture;
+  protected: std::vector<float> pixels;
+  protected: mutable std::mutex dataMutex;
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__HISTOGRAM2D_HH_
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HistogramAxis.hh"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+void HistogramAxis::Set(size_t _numBins, float _min, float _max, Scale _scale)
+{
+  this->numBins = _numBins;
+  this->min = _min;
+  this->max = _max;
+  this->scale = _scale;
+  this->limit = static_cast<float>(_numBins);
+
+  if (_scale == Scale::kLog)
+  {
+    this->offset = std::log(_min);
+    this->factor = _numBins / (std::log(_max) - this->offset);
+  }
+  else
+  {
+    this->offset = _min;
+    this->factor = _numBins / (_max - _min);
+  }
+}
+
+//////////////////////////////////////////////////
+float HistogramAxis::Edge(size_t _index) const
+{
+  if (_index >= this->numBins)
+    return this->max;
+  if (this->scale == Scale::kLog)
+    return std::exp(this->offset + _index / this->factor);
+  return this->min + _index / this->factor;
+}
+
+//////////////////////////////////////////////////
+void HistogramAxis::Indices(const float *_values, int32_t *_indices,
+                            size_t _count) const
+{
+  size_t ii = 0;
+#ifdef __SSE2__
+  const __m128 offsets = _mm_set1_ps(this->offset);
+  const __m128 factors = _mm_set1_ps(this->factor);
+  const __m128 limits = _mm_set1_ps(this->limit);
+  const __m128 zeros = _mm_setzero_ps();
+  const __m128i outside = _mm_set1_epi32(kOutOfRange);
+  const bool isLog = this->scale == Scale::kLog;
+
+  for (; ii + 4 <= _count; ii += 4)
+  {
+    __m128 t;
+    if (isLog)
+    {
+      // No portable vector log; transform first, then bin four at a time.
+      alignas(16) float logs[4];
+      for (size_t jj = 0; jj < 4; ++jj)
+        logs[jj] = std::log(_values[ii + jj]);
+      t = _mm_load_ps(logs);
+    }
+    else
+    {
+      t = _mm_loadu_ps(_values + ii);
+    }
+
+    const __m128 bins = _mm_mul_ps(_mm_sub_ps(t, offsets), factors);
+    // Ordered compares are false for NaN, matching Index().
+    const __m128i inside = _mm_castps_si128(_mm_and_ps(
+        _mm_cmpge_ps(bins, zeros), _mm_cmplt_ps(bins, limits)));
+    const __m128i indices = _mm_cvttps_epi32(bins);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(_indices + ii),
+        _mm_or_si128(_mm_and_si128(inside, indices),
+                     _mm_andnot_si128(inside, outside)));
+  }
+#endif
+
+  for (; ii < _count; ++ii)
+    _indices[ii] = this->Index(_values[ii]);
+}
+
+}  // namespace ign_imgui
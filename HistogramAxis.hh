@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__HISTOGRAM_AXIS_HH_
+#define IGN_IMGUI__HISTOGRAM_AXIS_HH_
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+namespace ign_imgui
+{
+
+/// \brief Maps values to bin indices in O(1), on a uniform or log scale.
+///
+/// The index of a value v is floor((t(v) - offset) * scale), where t is the
+/// identity or the natural log. The scalar and batched paths evaluate that
+/// expression with the same float operations, so they always agree.
+class HistogramAxis
+{
+  public: enum class Scale
+  {
+    kUniform,
+    kLog
+  };
+
+  /// \brief Value returned for samples outside [min, max) or NaN.
+  public: static constexpr int32_t kOutOfRange = -1;
+
+  public: HistogramAxis() = default;
+
+  /// \brief Set the axis. A log axis requires 0 < _min < _max.
+  public: void Set(size_t _numBins, float _min, float _max, Scale _scale);
+
+  public: size_t NumBins() const { return this->numBins; }
+  public: float Min() const { return this->min; }
+  public: float Max() const { return this->max; }
+  public: Scale GetScale() const { return this->scale; }
+
+  /// \brief Lower edge of bin _index; _index == NumBins() gives Max().
+  public: float Edge(size_t _index) const;
+
+  /// \brief Bin of _value, or kOutOfRange.
+  public: inline int32_t Index(float _value) const
+  {
+    const float t = this->scale == Scale::kLog ? std::log(_value) : _value;
+    const float bin = (t - this->offset) * this->factor;
+    // Written so that NaN fails the test as well.
+    if (!(bin >= 0.0f && bin < this->limit))
+      return kOutOfRange;
+    return static_cast<int32_t>(bin);
+  }
+
+  /// \brief Compute Index() for _count values, using SIMD where available.
+  public: void Indices(const float *_values, int32_t *_indices,
+                       size_t _count) const;
+
+  protected: size_t numBins{0};
+  protected: float min{0.0f};
+  protected: float max{0.0f};
+  protected: Scale scale{Scale::kUniform};
+  protected: float offset{0.0f};
+  protected: float factor{0.0f};
+  protected: float limit{0.0f};
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__HISTOGRAM_AXIS_HH_
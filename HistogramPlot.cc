@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HistogramPlot.hh"
+
+#include <algorithm>
+#include <limits>
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+ImVec2 HistogramPlot::GraphSize(ImVec2 _graphSize)
+{
+  if (_graphSize.x <= 0.0f)
+    _graphSize.x = ImGui::CalcItemWidth();
+  if (_graphSize.y <= 0.0f)
+  {
+    _graphSize.y = ImGui::GetTextLineHeight() +
+      ImGui::GetStyle().FramePadding.y * 2.0f;
+  }
+  return _graphSize;
+}
+
+//////////////////////////////////////////////////
+bool HistogramPlot::Stale(uint64_t _generation, float _width) const
+{
+  return _generation != this->generation ||
+    std::max(1, static_cast<int>(_width)) != this->width;
+}
+
+//////////////////////////////////////////////////
+void HistogramPlot::Update(const float *_counts, size_t _numBins,
+    const HistogramAxis &_axis, uint64_t _generation, float _width)
+{
+  this->axis = _axis;
+  this->numBins = _numBins;
+  this->generation = _generation;
+  this->width = std::max(1, static_cast<int>(_width));
+
+  this->columns.clear();
+  if (_numBins == 0)
+    return;
+
+  // With fewer bins than pixels a bin covers several columns, otherwise
+  // every bin lands in exactly one column.
+  const size_t numColumns = std::min<size_t>(this->width, _numBins);
+  this->columns.resize(numColumns);
+  this->scaleMin = std::numeric_limits<float>::max();
+  this->scaleMax = std::numeric_limits<float>::lowest();
+  for (size_t px = 0; px < numColumns; ++px)
+  {
+    const size_t begin = px * _numBins / numColumns;
+    const size_t end = (px + 1) * _numBins / numColumns;
+    Column &column = this->columns[px];
+    column.min = _counts[begin];
+    column.max = _counts[begin];
+    column.sum = 0.0f;
+    for (size_t ii = begin; ii < end; ++ii)
+    {
+      column.min = std::min(column.min, _counts[ii]);
+      column.max = std::max(column.max, _counts[ii]);
+      column.sum += _counts[ii];
+    }
+    this->scaleMin = std::min(this->scaleMin, column.min);
+    this->scaleMax = std::max(this->scaleMax, column.max);
+  }
+}
+
+//////////////////////////////////////////////////
+void HistogramPlot::Draw(const std::string &_label, ImVec2 _graphSize) const
+{
+  const ImVec2 pos = ImGui::GetCursorScreenPos();
+  ImGui::Dummy(_graphSize);
+  const bool hovered = ImGui::IsItemHovered();
+
+  auto drawList = ImGui::GetWindowDrawList();
+  drawList->AddRectFilled(pos,
+      ImVec2(pos.x + _graphSize.x, pos.y + _graphSize.y),
+      ImGui::GetColorU32(ImGuiCol_FrameBg));
+
+  const size_t numColumns = this->columns.size();
+  const float range = this->scaleMax - this->scaleMin;
+  if (numColumns > 0 && range > 0.0f)
+  {
+    const ImU32 solid = ImGui::GetColorU32(ImGuiCol_PlotHistogram);
+    const ImU32 faint = ImGui::GetColorU32(ImGuiCol_PlotHistogram, 0.5f);
+    const float columnWidth = _graphSize.x / numColumns;
+    const float bottom = pos.y + _graphSize.y;
+    for (size_t px = 0; px < numColumns; ++px)
+    {
+      const Column &column = this->columns[px];
+      if (column.max <= this->scaleMin)
+        continue;
+      const float x0 = pos.x + px * columnWidth;
+      const float x1 = x0 + columnWidth;
+      const float yMax = bottom -
+        _graphSize.y * (column.max - this->scaleMin) / range;
+      const float yMin = bottom -
+        _graphSize.y * (column.min - this->scaleMin) / range;
+      if (column.min < column.max)
+        drawList->AddRectFilled(ImVec2(x0, yMax), ImVec2(x1, yMin), faint);
+      if (column.min > this->scaleMin)
+        drawList->AddRectFilled(ImVec2(x0, yMin), ImVec2(x1, bottom), solid);
+    }
+
+    if (hovered)
+    {
+      const float mouseX = ImGui::GetMousePos().x - pos.x;
+      const size_t px = std::min(numColumns - 1, static_cast<size_t>(
+          std::max(0.0f, mouseX / columnWidth)));
+      const size_t begin = px * this->numBins / numColumns;
+      const size_t end = (px + 1) * this->numBins / numColumns;
+      const Column &column = this->columns[px];
+      ImGui::SetTooltip("%g - %g: max %g, min %g, sum %g",
+          this->axis.Edge(begin), this->axis.Edge(end),
+          column.max, column.min, column.sum);
+    }
+  }
+
+  const size_t labelEnd = _label.find("##");
+  if (labelEnd != 0)
+  {
+    ImGui::SameLine();
+    ImGui::TextUnformatted(_label.c_str(),
+        labelEnd == std::string::npos ? nullptr : _label.c_str() + labelEnd);
+  }
+}
+
+}  // namespace ign_imgui
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__HISTOGRAM_PLOT_HH_
+#define IGN_IMGUI__HISTOGRAM_PLOT_HH_
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <string>
+#include <vector>
+
+#include <imgui/imgui.h>
+
+#include "HistogramAxis.hh"
+
+namespace ign_imgui
+{
+
+/// \brief Histogram widget drawing one column per pixel rather than one
+/// rectangle per bin.
+///
+/// The bins are reduced to per-pixel min, max and sum only when the data
+/// generation or the plot width changes. Drawing an unchanged histogram
+/// costs O(width) no matter how many bins it has.
+class HistogramPlot
+{
+  /// \brief Bins falling on one pixel column.
+  public: struct Column
+  {
+    float min;
+    float max;
+    float sum;
+  };
+
+  /// \brief Size the plot will take, with the same defaults as
+  /// ImGui::PlotHistogram for non-positive components.
+  public: static ImVec2 GraphSize(ImVec2 _graphSize);
+
+  /// \brief True if Update() has not yet seen _generation at _width.
+  public: bool Stale(uint64_t _generation, float _width) const;
+
+  /// \brief Reduce _numBins counts laid out on _axis to at most one column
+  /// per pixel of _width.
+  public: void Update(const float *_counts, size_t _numBins,
+                      const HistogramAxis &_axis, uint64_t _generation,
+                      float _width);
+
+  /// \brief Draw the columns, the bar of each showing its largest bin over
+  /// a solid part for its smallest one.
+  public: void Draw(const std::string &_label, ImVec2 _graphSize) const;
+
+  public: const std::vector<Column> &Columns() const { return this->columns; }
+
+  protected: std::vector<Column> columns;
+  protected: HistogramAxis axis;
+  protected: size_t numBins{0};
+  protected: float scaleMin{0.0f};
+  protected: float scaleMax{0.0f};
+  protected: uint64_t generation{UINT64_MAX};
+  protected: int width{0};
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__HISTOGRAM_PLOT_HH_
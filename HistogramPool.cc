@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HistogramPool.hh"
+
+#include <algorithm>
+#include <utility>
+
+namespace ign_imgui
+{
+
+constexpr size_t HistogramPool::kBuffersPerSlab;
+constexpr size_t HistogramPool::kMinZeroAheadSize;
+
+//////////////////////////////////////////////////
+HistogramBuffer::HistogramBuffer(HistogramPool *_pool, float *_data,
+                                 size_t _size)
+  : pool(_pool), data(_data), size(_size)
+{
+}
+
+//////////////////////////////////////////////////
+HistogramBuffer::HistogramBuffer(HistogramBuffer &&_other) noexcept
+{
+  this->Swap(_other);
+}
+
+//////////////////////////////////////////////////
+HistogramBuffer &HistogramBuffer::operator=(HistogramBuffer &&_other) noexcept
+{
+  if (this != &_other)
+  {
+    this->Release();
+    this->Swap(_other);
+  }
+  return *this;
+}
+
+//////////////////////////////////////////////////
+HistogramBuffer::~HistogramBuffer()
+{
+  this->Release();
+}
+
+//////////////////////////////////////////////////
+void HistogramBuffer::Swap(HistogramBuffer &_other) noexcept
+{
+  std::swap(this->pool, _other.pool);
+  std::swap(this->data, _other.data);
+  std::swap(this->size, _other.size);
+}
+
+//////////////////////////////////////////////////
+void HistogramBuffer::Release()
+{
+  if (this->pool)
+    this->pool->Release(this->data, this->size);
+  this->pool = nullptr;
+  this->data = nullptr;
+  this->size = 0;
+}
+
+//////////////////////////////////////////////////
+HistogramPool &HistogramPool::Instance()
+{
+  static HistogramPool instance;
+  return instance;
+}
+
+//////////////////////////////////////////////////
+HistogramPool::~HistogramPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->running = false;
+  }
+  this->wake.notify_all();
+  if (this->thread.joinable())
+    this->thread.join();
+}
+
+//////////////////////////////////////////////////
+HistogramBuffer HistogramPool::Acquire(size_t _size)
+{
+  if (_size == 0)
+    return HistogramBuffer();
+
+  float *data = nullptr;
+  bool dirty = false;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto &sizeClass = this->Class(_size);
+    ++this->stats.acquired;
+    if (!sizeClass.zeroed.empty())
+    {
+      data = sizeClass.zeroed.back();
+      sizeClass.zeroed.pop_back();
+    }
+    else if (!sizeClass.dirty.empty())
+    {
+      data = sizeClass.dirty.back();
+      sizeClass.dirty.pop_back();
+      dirty = true;
+      ++this->stats.zeroedInline;
+    }
+    else
+    {
+      // Value-initialised, so a fresh slab needs no zeroing.
+      sizeClass.slabs.emplace_back(new float[kBuffersPerSlab * _size]());
+      float *slab = sizeClass.slabs.back().get();
+      for (size_t ii = 1; ii < kBuffersPerSlab; ++ii)
+        sizeClass.zeroed.push_back(slab + ii * _size);
+      data = slab;
+      ++this->stats.slabs;
+    }
+  }
+
+  if (dirty)
+    std::fill_n(data, _size, 0.0f);
+  return HistogramBuffer(this, data, _size);
+}
+
+//////////////////////////////////////////////////
+HistogramPoolStats HistogramPool::Stats() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->stats;
+}
+
+//////////////////////////////////////////////////
+void HistogramPool::Release(float *_data, size_t _size)
+{
+  if (_size < kMinZeroAheadSize)
+  {
+    std::fill_n(_data, _size, 0.0f);
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->Class(_size).zeroed.push_back(_data);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->Class(_size).dirty.push_back(_data);
+    if (!this->thread.joinable() && this->running)
+      this->thread = std::thread(&HistogramPool::Run, this);
+  }
+  this->wake.notify_one();
+}
+
+//////////////////////////////////////////////////
+void HistogramPool::Run()
+{
+  std::unique_lock<std::mutex> lock(this->mutex);
+  while (true)
+  {
+    SizeClass *sizeClass = nullptr;
+    for (auto &candidate : this->classes)
+    {
+      if (!candidate->dirty.empty())
+      {
+        sizeClass = candidate.get();
+        break;
+      }
+    }
+
+    if (!sizeClass)
+    {
+      if (!this->running)
+        return;
+      this->wake.wait(lock);
+      continue;
+    }
+
+    // Zero outside the lock, the buffer is in no list meanwhile.
+    float *data = sizeClass->dirty.back();
+    sizeClass->dirty.pop_back();
+    lock.unlock();
+    std::fill_n(data, sizeClass->size, 0.0f);
+    lock.lock();
+    sizeClass->zeroed.push_back(data);
+    ++this->stats.zeroedAhead;
+  }
+}
+
+//////////////////////////////////////////////////
+HistogramPool::SizeClass &HistogramPool::Class(size_t _size)
+{
+  for (auto &sizeClass : this->classes)
+  {
+    if (sizeClass->size == _size)
+      return *sizeClass;
+  }
+  this->classes.emplace_back(new SizeClass);
+  this->classes.back()->size = _size;
+  return *this->classes.back();
+}
+
+}  // namespace ign_imgui
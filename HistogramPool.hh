@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__HISTOGRAM_POOL_HH_
+#define IGN_IMGUI__HISTOGRAM_POOL_HH_
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ign_imgui
+{
+
+class HistogramPool;
+
+/// \brief Bin counts borrowed from a HistogramPool, handed back when the
+/// buffer is destroyed or replaced. Moving or swapping only moves pointers.
+class HistogramBuffer
+{
+  public: HistogramBuffer() = default;
+  public: HistogramBuffer(HistogramBuffer &&_other) noexcept;
+  public: HistogramBuffer &operator=(HistogramBuffer &&_other) noexcept;
+  public: ~HistogramBuffer();
+
+  public: HistogramBuffer(const HistogramBuffer &) = delete;
+  public: HistogramBuffer &operator=(const HistogramBuffer &) = delete;
+
+  public: float *Data() { return this->data; }
+  public: const float *Data() const { return this->data; }
+  public: size_t Size() const { return this->size; }
+  public: float &operator[](size_t _index) { return this->data[_index]; }
+  public: float operator[](size_t _index) const { return this->data[_index]; }
+
+  public: float *begin() { return this->data; }
+  public: float *end() { return this->data + this->size; }
+  public: const float *begin() const { return this->data; }
+  public: const float *end() const { return this->data + this->size; }
+
+  public: void Swap(HistogramBuffer &_other) noexcept;
+
+  /// \brief Give the counts back to the pool now.
+  public: void Release();
+
+  protected: friend class HistogramPool;
+  protected: HistogramBuffer(HistogramPool *_pool, float *_data,
+                             size_t _size);
+
+  protected: HistogramPool *pool{nullptr};
+  protected: float *data{nullptr};
+  protected: size_t size{0};
+};
+
+struct HistogramPoolStats
+{
+  /// \brief Slabs allocated, each holding kBuffersPerSlab buffers.
+  uint64_t slabs{0};
+  uint64_t acquired{0};
+
+  /// \brief Buffers zeroed by the pool thread ahead of time.
+  uint64_t zeroedAhead{0};
+
+  /// \brief Buffers zeroed by Acquire() because none were ready.
+  uint64_t zeroedInline{0};
+};
+
+/// \brief Recycles histogram count buffers, so histograms that are
+/// created, reset and rotated all the time stop allocating once warm.
+///
+/// Buffers of the same size are carved out of slabs of kBuffersPerSlab.
+/// Large released buffers are zeroed on the pool thread and handed out again
+/// by Acquire(), which only zeroes by itself when the thread fell behind.
+/// Slabs are never freed before the pool goes away.
+class HistogramPool
+{
+  public: static constexpr size_t kBuffersPerSlab = 16;
+
+  /// \brief Smaller buffers are zeroed on release right away, which is
+  /// cheaper than waking the pool thread.
+  public: static constexpr size_t kMinZeroAheadSize = 1024;
+
+  /// \brief Pool used by Histogram.
+  public: static HistogramPool &Instance();
+
+  public: HistogramPool() = default;
+  public: ~HistogramPool();
+
+  public: HistogramPool(const HistogramPool &) = delete;
+  public: HistogramPool &operator=(const HistogramPool &) = delete;
+
+  /// \brief Borrow _size zeroed counts. An empty buffer for _size 0.
+  public: HistogramBuffer Acquire(size_t _size);
+
+  public: HistogramPoolStats Stats() const;
+
+  protected: friend class HistogramBuffer;
+
+  /// \brief Queue _data for zeroing and reuse.
+  protected: void Release(float *_data, size_t _size);
+
+  protected: void Run();
+
+  /// \brief Buffers of one size.
+  protected: struct SizeClass
+  {
+    size_t size{0};
+    std::vector<std::unique_ptr<float[]>> slabs;
+    std::vector<float *> zeroed;
+    std::vector<float *> dirty;
+  };
+
+  /// \brief Class for _size, created on first use. Needs the mutex.
+  protected: SizeClass &Class(size_t _size);
+
+  protected: std::vector<std::unique_ptr<SizeClass>> classes;
+  protected: HistogramPoolStats stats;
+  protected: bool running{true};
+  protected: mutable std::mutex mutex;
+  protected: std::condition_variable wake;
+
+  /// \brief Zeroing thread, started by the first release.
+  protected: std::thread thread;
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__HISTOGRAM_POOL_HH_
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HostMetrics.hh"
+
+#include <time.h>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+
+namespace
+{
+
+//////////////////////////////////////////////////
+/// \brief Busy and total jiffies from the aggregate line of /proc/stat.
+bool ReadCpu(uint64_t &_busy, uint64_t &_total)
+{
+  std::ifstream fs("/proc/stat");
+  std::string cpu;
+  uint64_t user, nice, system, idle, iowait, irq, softirq, steal;
+  if (!(fs >> cpu >> user >> nice >> system >> idle >> iowait >> irq >>
+        softirq >> steal) || cpu != "cpu")
+  {
+    return false;
+  }
+  _busy = user + nice + system + irq + softirq + steal;
+  _total = _busy + idle + iowait;
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Cumulative "some" IO stall time from /proc/pressure/io.
+bool ReadIoStall(uint64_t &_stallUs)
+{
+  std::ifstream fs("/proc/pressure/io");
+  std::string token;
+  while (fs >> token)
+  {
+    if (token.compare(0, 6, "total=") == 0)
+    {
+      _stallUs = std::stoull(token.substr(6));
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+void HostMetrics::Sample()
+{
+  uint64_t busy = 0;
+  uint64_t total = 0;
+  uint64_t stallUs = 0;
+  const bool haveCpu = ReadCpu(busy, total);
+  const bool haveIo = ReadIoStall(stallUs);
+  const uint64_t wallUs = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+
+  if (this->sampled)
+  {
+    if (haveCpu && total > this->cpuTotal)
+    {
+      this->cpuUsage = static_cast<double>(busy - this->cpuBusy) /
+        (total - this->cpuTotal);
+    }
+    if (haveIo && wallUs > this->ioWallUs)
+    {
+      this->ioPressure = static_cast<double>(stallUs - this->ioStallUs) /
+        (wallUs - this->ioWallUs);
+    }
+  }
+
+  this->cpuBusy = busy;
+  this->cpuTotal = total;
+  this->ioStallUs = stallUs;
+  this->ioWallUs = wallUs;
+  this->sampled = true;
+}
+
+//////////////////////////////////////////////////
+double HostMetrics::CpuUsage() const
+{
+  return this->cpuUsage;
+}
+
+//////////////////////////////////////////////////
+double HostMetrics::IoPressure() const
+{
+  return this->ioPressure;
+}
+
+//////////////////////////////////////////////////
+void ThreadCpuMeter::Sample()
+{
+  const double cpu = ThreadSeconds();
+  const double wall = std::chrono::duration<double>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  if (this->lastCpu < 0.0)
+  {
+    this->lastCpu = cpu;
+    this->lastWall = wall;
+    return;
+  }
+  if (wall - this->lastWall < kPeriod)
+    return;
+
+  this->usage = (cpu - this->lastCpu) / (wall - this->lastWall);
+  this->lastCpu = cpu;
+  this->lastWall = wall;
+}
+
+//////////////////////////////////////////////////
+double ThreadCpuMeter::Usage() const
+{
+  return this->usage.load();
+}
+
+//////////////////////////////////////////////////
+double ThreadCpuMeter::ThreadSeconds()
+{
+  struct timespec ts;
+  if (::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+    return 0.0;
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+}  // namespace ign_imgui
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__HOST_METRICS_HH_
+#define IGN_IMGUI__HOST_METRICS_HH_
+
+#include <atomic>
+#include <cstdint>
+
+namespace ign_imgui
+{
+
+/// \brief Samples host-wide CPU usage and IO pressure from /proc.
+///
+/// Each value is the average over the interval between two Sample() calls.
+/// Sources that are not available (non-Linux hosts, kernels without PSI)
+/// read as zero.
+class HostMetrics
+{
+  public: HostMetrics() = default;
+
+  /// \brief Read the counters and update the interval averages.
+  public: void Sample();
+
+  /// \brief Fraction of CPU time spent non-idle, in [0, 1].
+  public: double CpuUsage() const;
+
+  /// \brief Fraction of wall time some task was stalled on IO, in [0, 1].
+  public: double IoPressure() const;
+
+  protected: uint64_t cpuBusy{0};
+  protected: uint64_t cpuTotal{0};
+  protected: uint64_t ioStallUs{0};
+  protected: uint64_t ioWallUs{0};
+  protected: bool sampled{false};
+  protected: double cpuUsage{0.0};
+  protected: double ioPressure{0.0};
+};
+
+/// \brief CPU time used by one thread, as a fraction of a core.
+///
+/// Sample() must be called from the measured thread, Usage() may be read
+/// from any thread.
+class ThreadCpuMeter
+{
+  /// \brief Shortest interval Usage() is averaged over, in seconds.
+  public: static constexpr double kPeriod = 1.0;
+
+  /// \brief Read the thread CPU clock, updating Usage() once per kPeriod.
+  public: void Sample();
+
+  public: double Usage() const;
+
+  /// \brief CPU seconds used by the calling thread so far.
+  public: static double ThreadSeconds();
+
+  protected: double lastCpu{-1.0};
+  protected: double lastWall{0.0};
+  protected: std::atomic<double> usage{0.0};
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__HOST_METRICS_HH_
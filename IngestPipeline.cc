@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "IngestPipeline.hh"
+
+#include <cmath>
+
+#include "AsyncLog.hh"
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+IngestPipeline::IngestPipeline(const IngestSinks &_sinks)
+  : sinks(_sinks)
+{
+}
+
+//////////////////////////////////////////////////
+void IngestPipeline::SetLazy(bool _lazy)
+{
+  this->Flush();
+  this->lazy = _lazy;
+}
+
+//////////////////////////////////////////////////
+void IngestPipeline::SetHist2dX(Hist2dX _x)
+{
+  this->hist2dX = _x;
+}
+
+//////////////////////////////////////////////////
+void IngestPipeline::SetCpuUsage(const std::atomic<float> *_cpuUsage)
+{
+  this->cpuUsage = _cpuUsage;
+}
+
+//////////////////////////////////////////////////
+void IngestPipeline::SetResumedFrom(const Checkpoint &_checkpoint)
+{
+  this->resumed = true;
+  this->resumedFrom = _checkpoint;
+  this->gaps = _checkpoint.gaps;
+}
+
+//////////////////////////////////////////////////
+void IngestPipeline::Insert(const ClockSample &_sample)
+{
+  const double now = _sample.steady;
+  if (this->sinks.correlation)
+    this->sinks.correlation->InsertData(this->sinks.msgSeries, now, 1.0);
+
+  // Messages from different transport threads can still arrive out of
+  // order, pairing one with a newer predecessor gives a meaningless RTF.
+  // Real time orders them, sim time goes back on a world reset.
+  if (this->started && _sample.RealNs() <= this->previous.RealNs())
+  {
+    ++this->outOfOrder;
+    IGN_IMGUI_LOG_DBG("Dropping clock sample at real time {}s, not after "
+        "the previous one at {}s", _sample.Real().Double(),
+        this->previous.Real().Double());
+    return;
+  }
+  if (this->started && _sample.SimNs() < this->previous.SimNs())
+  {
+    IGN_IMGUI_LOG_WARN("Sim time went back from {}s to {}s, the "
+        "simulation was likely reset", this->previous.Sim().Double(),
+        _sample.Sim().Double());
+    this->previous = _sample;
+    return;
+  }
+
+  if (this->sinks.lsqRtf)
+    this->sinks.lsqRtf->InsertData(_sample.RealNs(), _sample.SimNs(), now);
+
+  if (!this->started)
+  {
+    this->previous = _sample;
+    this->started = true;
+    if (this->resumed)
+    {
+      // Nothing between the checkpoint and this message was observed,
+      // don't let a single sample stand in for the whole gap.
+      Gap gap;
+      gap.simStart = this->resumedFrom.simTime;
+      gap.simEnd = _sample.Sim().Double();
+      gap.realStart = this->resumedFrom.realTime;
+      gap.realEnd = _sample.Real().Double();
+      gap.wallSeconds = WallSeconds() - this->resumedFrom.wallTime;
+      this->gaps.push_back(gap);
+      IGN_IMGUI_LOG_WARN("Resumed with a gap of {}s sim time, "
+          "{}s real time, {}s wall time since the checkpoint",
+          gap.simEnd - gap.simStart, gap.realEnd - gap.realStart,
+          gap.wallSeconds);
+      if (gap.simEnd < gap.simStart)
+      {
+        IGN_IMGUI_LOG_WARN("Sim time went backwards since the "
+            "checkpoint, the simulation was likely restarted");
+      }
+    }
+    return;
+  }
+
+  const ignition::common::Time real = _sample.Real();
+  const ignition::common::Time sim = _sample.Sim();
+  const auto realDt = real - this->previous.Real();
+  const auto simDt = sim - this->previous.Sim();
+  const double rtf = simDt.Double() / realDt.Double();
+  this->previous = _sample;
+
+  if (!std::isfinite(rtf))
+  {
+    IGN_IMGUI_LOG_DBG("Skipping non-finite RTF, sim step {}s over "
+        "real step {}s", simDt.Double(), realDt.Double());
+    return;
+  }
+
+  float x = 0.0f;
+  switch (this->hist2dX)
+  {
+    case Hist2dX::kStep:
+      x = simDt.Double();
+      break;
+    case Hist2dX::kSimTime:
+      x = sim.Double();
+      break;
+    case Hist2dX::kCpu:
+      x = this->cpuUsage ? this->cpuUsage->load() : 0.0f;
+      break;
+  }
+
+  if (this->sinks.anomalies &&
+      this->sinks.anomalies->Score(rtf, sim.Double(), now))
+  {
+    IGN_IMGUI_LOG_WARN("Anomalous RTF {} at sim time {}s", rtf,
+        sim.Double());
+  }
+
+  const RtfSample sample{rtf, sim.Double(), real.Double()};
+  if (this->lazy)
+  {
+    if (this->bulk.Append(sample, now, x))
+      this->Flush();
+  }
+  else
+  {
+    if (this->sinks.moments)
+      this->sinks.moments->InsertData(rtf);
+    if (this->sinks.distribution)
+      this->sinks.distribution->InsertData(rtf);
+    if (this->sinks.drift)
+      this->sinks.drift->InsertData(rtf);
+    if (this->sinks.rtfMetric)
+      this->sinks.rtfMetric->Observe(rtf);
+    if (this->sinks.intervals)
+      this->sinks.intervals->InsertData(now, rtf);
+    if (this->sinks.reservoir)
+      this->sinks.reservoir->InsertData(sample);
+    if (this->sinks.hist2d)
+      this->sinks.hist2d->InsertData(x, rtf);
+  }
+
+  // Correlation periods close as host metrics arrive, so RTF has to reach
+  // it in order with them.
+  if (this->sinks.correlation)
+    this->sinks.correlation->InsertRtf(now, rtf);
+  if (this->sinks.history && this->sinks.history->IsOpen())
+    this->sinks.history->Append(sample);
+  if (this->sinks.arrow && this->sinks.arrow->IsOpen())
+    this->sinks.arrow->AppendSample(sample);
+  if (this->sinks.remoteWrite && this->sinks.remoteWrite->Running())
+  {
+    this->sinks.remoteWrite->Push(rtf,
+        static_cast<int64_t>(WallSeconds() * 1000.0));
+  }
+  if (this->sinks.anomalies && this->sinks.distribution &&
+      this->sinks.anomalies->NeedsRefresh())
+  {
+    this->sinks.anomalies->Refresh(*this->sinks.distribution);
+  }
+}
+
+//////////////////////////////////////////////////
+void IngestPipeline::Flush()
+{
+  if (this->bulk.Empty())
+    return;
+  const size_t count = this->bulk.Size();
+  if (this->sinks.moments)
+    this->sinks.moments->InsertData(this->bulk.Rtf(), count);
+  if (this->sinks.distribution)
+    this->sinks.distribution->InsertData(this->bulk.Rtf(), count);
+  if (this->sinks.drift)
+    this->sinks.drift->InsertData(this->bulk.Rtf(), count);
+  if (this->sinks.rtfMetric)
+  {
+    for (size_t i = 0; i < count; ++i)
+      this->sinks.rtfMetric->Observe(this->bulk.Rtf()[i]);
+  }
+  if (this->sinks.intervals)
+  {
+    this->sinks.intervals->InsertData(this->bulk.Steady(),
+        this->bulk.RtfFloat(), count);
+  }
+  if (this->sinks.reservoir)
+    this->sinks.reservoir->InsertData(this->bulk.Samples(), count);
+  if (this->sinks.hist2d)
+  {
+    this->sinks.hist2d->InsertData(this->bulk.X(), this->bulk.RtfFloat(),
+        count);
+  }
+  this->bulk.Clear();
+}
+
+//////////////////////////////////////////////////
+bool IngestPipeline::Buffered() const
+{
+  return !this->bulk.Empty();
+}
+
+//////////////////////////////////////////////////
+bool IngestPipeline::Started() const
+{
+  return this->started;
+}
+
+//////////////////////////////////////////////////
+const ClockSample &IngestPipeline::Latest() const
+{
+  return this->previous;
+}
+
+//////////////////////////////////////////////////
+uint64_t IngestPipeline::OutOfOrder() const
+{
+  return this->outOfOrder;
+}
+
+//////////////////////////////////////////////////
+const std::vector<Gap> &IngestPipeline::Gaps() const
+{
+  return this->gaps;
+}
+
+}  // namespace ign_imgui
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__INGEST_PIPELINE_HH_
+#define IGN_IMGUI__INGEST_PIPELINE_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+#include <vector>
+
+#include "AnomalyDetector.hh"
+#include "ArrowExport.hh"
+#include "BulkBuffer.hh"
+#include "ClockSample.hh"
+#include "Distribution.hh"
+#include "DriftMonitor.hh"
+#include "Export.hh"
+#include "Histogram2D.hh"
+#include "IntervalHeatmap.hh"
+#include "LaggedCorrelation.hh"
+#include "LeastSquaresRtf.hh"
+#include "MetricRegistry.hh"
+#include "Moments.hh"
+#include "RemoteWrite.hh"
+#include "Reservoir.hh"
+#include "RingFile.hh"
+
+namespace ign_imgui
+{
+
+/// \brief Variable plotted against RTF in the 2D histogram.
+enum class Hist2dX
+{
+  kStep,
+  kSimTime,
+  kCpu
+};
+
+/// \brief Where IngestPipeline sends samples. Null members are skipped,
+/// the others must outlive the pipeline.
+struct IngestSinks
+{
+  Moments *moments{nullptr};
+  Distribution *distribution{nullptr};
+  IntervalHeatmap *intervals{nullptr};
+  Reservoir *reservoir{nullptr};
+  Histogram2D *hist2d{nullptr};
+  LeastSquaresRtf *lsqRtf{nullptr};
+  AnomalyDetector *anomalies{nullptr};
+  DriftMonitor *drift{nullptr};
+  HistogramMetric *rtfMetric{nullptr};
+
+  /// \brief Gets every RTF, and a count per sample in msgSeries.
+  LaggedCorrelation *correlation{nullptr};
+  size_t msgSeries{0};
+
+  /// \brief Outputs, only written while open or running.
+  RingFileWriter *history{nullptr};
+  ArrowExport *arrow{nullptr};
+  RemoteWriteExporter *remoteWrite{nullptr};
+};
+
+/// \brief The step from a clock sample to every accumulator and output,
+/// the work the ingest thread does per sample.
+///
+/// Samples not after the previous one in real time are dropped, pairing
+/// one with a newer predecessor gives a meaningless RTF. Sim time going
+/// back, e.g. on a world reset, restarts the pairing. The RTF of every
+/// other sample against its predecessor goes to the sinks.
+///
+/// Not thread-safe, the caller serializes Insert() and Flush() with reads
+/// of the accumulators.
+class IngestPipeline
+{
+  public: explicit IngestPipeline(const IngestSinks &_sinks);
+
+  /// \brief Buffer the accumulator inserts and apply them a chunk at a
+  /// time, see BulkBuffer. Outputs are still written per sample.
+  public: void SetLazy(bool _lazy);
+
+  public: void SetHist2dX(Hist2dX _x);
+
+  /// \brief CPU usage read for Hist2dX::kCpu, must outlive the pipeline.
+  public: void SetCpuUsage(const std::atomic<float> *_cpuUsage);
+
+  /// \brief Continue from _checkpoint, whose gaps are kept. The time
+  /// between it and the first sample is recorded as another gap.
+  public: void SetResumedFrom(const Checkpoint &_checkpoint);
+
+  public: void Insert(const ClockSample &_sample);
+
+  /// \brief Apply the buffered inserts in lazy mode.
+  public: void Flush();
+
+  /// \brief True if lazy inserts are waiting for Flush().
+  public: bool Buffered() const;
+
+  /// \brief True once a sample was accepted.
+  public: bool Started() const;
+
+  /// \brief Last accepted sample, valid once Started().
+  public: const ClockSample &Latest() const;
+
+  /// \brief Samples dropped for not being after the previous one.
+  public: uint64_t OutOfOrder() const;
+
+  public: const std::vector<Gap> &Gaps() const;
+
+  protected: IngestSinks sinks;
+  protected: bool lazy{false};
+  protected: BulkBuffer bulk;
+  protected: Hist2dX hist2dX{Hist2dX::kStep};
+  protected: const std::atomic<float> *cpuUsage{nullptr};
+
+  protected: bool resumed{false};
+  protected: Checkpoint resumedFrom;
+  protected: std::vector<Gap> gaps;
+
+  protected: bool started{false};
+  protected: ClockSample previous;
+  protected: uint64_t outOfOrder{0};
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__INGEST_PIPELINE_HH_
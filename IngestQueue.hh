@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__INGEST_QUEUE_HH_
+#define IGN_IMGUI__INGEST_QUEUE_HH_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ign_imgui
+{
+
+/// \brief Counters describing how an IngestQueue has been used.
+struct IngestQueueStats
+{
+  /// \brief Threads that have enqueued at least once.
+  size_t producers{0};
+  uint64_t enqueued{0};
+  /// \brief Items dropped because their producer's ring was full.
+  uint64_t dropped{0};
+  /// \brief Items dropped because more than kMaxProducers threads enqueued.
+  uint64_t overflowed{0};
+  /// \brief Times a producer found its ring apparently full and had to
+  /// re-read the consumer position, i.e. how often the two sides contended
+  /// for the same cache line.
+  uint64_t headRefreshes{0};
+  /// \brief Deepest any single ring has been, in items.
+  uint64_t maxDepth{0};
+  uint64_t drains{0};
+  uint64_t emptyDrains{0};
+};
+
+/// \brief Bounded multi-producer single-consumer queue.
+///
+/// Every producer thread gets its own single-producer ring the first time it
+/// enqueues, so producers never write to shared state and Push() is wait-free:
+/// a bounded number of steps whatever the other threads do. The exception is
+/// the first Push() from each thread, which allocates that thread's ring.
+/// When a ring is full the item is dropped and counted rather than waiting
+/// for the consumer.
+///
+/// Items keep their order within a producer but not across producers, with
+/// Drain() taking a batch from one ring before moving to the next. When the
+/// consumer depends on order, DrainOrdered() merges the rings by a key.
+///
+/// Rings are not released when their thread exits, the queue is meant for
+/// long-lived callback threads such as the ign-transport thread pool.
+template<typename T>
+class IngestQueue
+{
+  static_assert(std::is_trivially_copyable<T>::value,
+      "IngestQueue items are copied into preallocated slots");
+
+  public: static constexpr size_t kMaxProducers = 64;
+
+  /// \param[in] _capacity Items per producer, rounded up to a power of two.
+  public: explicit IngestQueue(size_t _capacity = 4096)
+    : id(NextId())
+  {
+    this->capacity = 1;
+    while (this->capacity < _capacity)
+      this->capacity <<= 1;
+    for (auto &ring : this->rings)
+      ring.store(nullptr, std::memory_order_relaxed);
+  }
+
+  public: ~IngestQueue()
+  {
+    for (auto &ring : this->rings)
+      delete ring.load(std::memory_order_relaxed);
+  }
+
+  public: IngestQueue(const IngestQueue &) = delete;
+  public: IngestQueue &operator=(const IngestQueue &) = delete;
+
+  /// \brief Enqueue from any thread.
+  /// \return False if the item was dropped.
+  public: bool Push(const T &_item)
+  {
+    Ring *ring = this->LocalRing();
+    if (!ring)
+    {
+      this->overflowed.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    const uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    if (tail - ring->cachedHead >= this->capacity)
+    {
+      Bump(ring->headRefreshes);
+      ring->cachedHead = ring->head.load(std::memory_order_acquire);
+      if (tail - ring->cachedHead >= this->capacity)
+      {
+        Bump(ring->dropped);
+        return false;
+      }
+    }
+
+    ring->slots[tail & (this->capacity - 1)] = _item;
+    ring->tail.store(tail + 1, std::memory_order_release);
+
+    const uint64_t depth = tail + 1 - ring->cachedHead;
+    if (depth > ring->maxDepth.load(std::memory_order_relaxed))
+      ring->maxDepth.store(depth, std::memory_order_relaxed);
+    return true;
+  }
+
+  /// \brief Pop up to _max items, visiting producers round robin so a busy
+  /// thread can't starve the others. Must only be called from one thread.
+  /// \return Number of items passed to _fn.
+  public: template<typename Fn>
+  size_t Drain(Fn &&_fn, size_t _max = SIZE_MAX)
+  {
+    const size_t numRings = std::min<size_t>(
+        this->numProducers.load(std::memory_order_acquire), kMaxProducers);
+
+    size_t popped = 0;
+    bool more = true;
+    while (more && popped < _max)
+    {
+      more = false;
+      for (size_t ii = 0; ii < numRings && popped < _max; ++ii)
+      {
+        Ring *ring = this->rings[ii].load(std::memory_order_acquire);
+        if (!ring)
+          continue;
+
+        const uint64_t head = ring->head.load(std::memory_order_relaxed);
+        const uint64_t tail = ring->tail.load(std::memory_order_acquire);
+        if (head == tail)
+          continue;
+
+        // Take a bounded batch per ring per pass to keep the fairness.
+        const uint64_t end = head + std::min<uint64_t>({tail - head,
+            kDrainBatch, _max - popped});
+        const T *slots = ring->slots.get();
+        for (uint64_t pos = head; pos < end; ++pos)
+          _fn(slots[pos & (this->capacity - 1)]);
+        ring->head.store(end, std::memory_order_release);
+
+        popped += end - head;
+        more = more || end < tail;
+      }
+    }
+
+    Bump(popped ? this->drains : this->emptyDrains);
+    return popped;
+  }
+
+  /// \brief Pop the items present when called, merging the rings so that
+  /// items come out ordered by _less as long as every producer pushed them in
+  /// that order. Items pushed later can still be older than ones already
+  /// popped. Must only be called from one thread.
+  /// \return Number of items passed to _fn.
+  public: template<typename Fn, typename Less>
+  size_t DrainOrdered(Fn &&_fn, Less &&_less)
+  {
+    const size_t numRings = std::min<size_t>(
+        this->numProducers.load(std::memory_order_acquire), kMaxProducers);
+
+    std::array<Ring *, kMaxProducers> active;
+    std::array<uint64_t, kMaxProducers> heads;
+    std::array<uint64_t, kMaxProducers> tails;
+    size_t numActive = 0;
+    for (size_t ii = 0; ii < numRings; ++ii)
+    {
+      Ring *ring = this->rings[ii].load(std::memory_order_acquire);
+      if (!ring)
+        continue;
+      const uint64_t head = ring->head.load(std::memory_order_relaxed);
+      const uint64_t tail = ring->tail.load(std::memory_order_acquire);
+      if (head == tail)
+        continue;
+      active[numActive] = ring;
+      heads[numActive] = head;
+      tails[numActive] = tail;
+      ++numActive;
+    }
+
+    // Producers are few, a linear scan of the ring heads beats a heap.
+    const uint64_t mask = this->capacity - 1;
+    size_t popped = 0;
+    while (true)
+    {
+      size_t best = numActive;
+      for (size_t ii = 0; ii < numActive; ++ii)
+      {
+        if (heads[ii] == tails[ii])
+          continue;
+        if (best == numActive ||
+            _less(active[ii]->slots[heads[ii] & mask],
+                  active[best]->slots[heads[best] & mask]))
+        {
+          best = ii;
+        }
+      }
+      if (best == numActive)
+        break;
+
+      _fn(active[best]->slots[heads[best] & mask]);
+      ++heads[best];
+      ++popped;
+      if ((heads[best] & (kDrainBatch - 1)) == 0)
+        active[best]->head.store(heads[best], std::memory_order_release);
+    }
+    for (size_t ii = 0; ii < numActive; ++ii)
+      active[ii]->head.store(heads[ii], std::memory_order_release);
+
+    Bump(popped ? this->drains : this->emptyDrains);
+    return popped;
+  }
+
+  public: IngestQueueStats Stats() const
+  {
+    IngestQueueStats stats;
+    stats.producers = std::min<size_t>(
+        this->numProducers.load(std::memory_order_acquire), kMaxProducers);
+    stats.overflowed = this->overflowed.load(std::memory_order_relaxed);
+    stats.drains = this->drains.load(std::memory_order_relaxed);
+    stats.emptyDrains = this->emptyDrains.load(std::memory_order_relaxed);
+    for (size_t ii = 0; ii < stats.producers; ++ii)
+    {
+      const Ring *ring = this->rings[ii].load(std::memory_order_acquire);
+      if (!ring)
+        continue;
+      stats.enqueued += ring->tail.load(std::memory_order_relaxed);
+      stats.dropped += ring->dropped.load(std::memory_order_relaxed);
+      stats.headRefreshes += ring->headRefreshes.load(
+          std::memory_order_relaxed);
+      stats.maxDepth = std::max<uint64_t>(stats.maxDepth,
+          ring->maxDepth.load(std::memory_order_relaxed));
+    }
+    return stats;
+  }
+
+  protected: static constexpr uint64_t kDrainBatch = 256;
+
+  /// \brief Single-producer ring, the producer and consumer sides are kept
+  /// on separate cache lines.
+  protected: struct Ring
+  {
+    explicit Ring(size_t _capacity)
+      : slots(new T[_capacity])
+    {
+    }
+
+    alignas(64) std::atomic<uint64_t> tail{0};
+    uint64_t cachedHead{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> headRefreshes{0};
+    std::atomic<uint64_t> maxDepth{0};
+
+    alignas(64) std::atomic<uint64_t> head{0};
+
+    alignas(64) std::unique_ptr<T[]> slots;
+  };
+
+  /// \brief Increment a counter only ever written by one thread, without
+  /// paying for an atomic read-modify-write.
+  protected: static void Bump(std::atomic<uint64_t> &_counter)
+  {
+    _counter.store(_counter.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+  }
+
+  protected: static uint64_t NextId()
+  {
+    static std::atomic<uint64_t> nextId{1};
+    return nextId.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /// \brief Ring owned by the calling thread, created on first use.
+  /// \return Null once kMaxProducers threads have claimed a ring.
+  protected: Ring *LocalRing()
+  {
+    // Keyed by a unique id rather than the address, which a later queue
+    // could reuse.
+    thread_local std::vector<std::pair<uint64_t, Ring *>> owned;
+    for (const auto &entry : owned)
+    {
+      if (entry.first == this->id)
+        return entry.second;
+    }
+
+    Ring *ring = nullptr;
+    const size_t slot = this->numProducers.fetch_add(1,
+        std::memory_order_acq_rel);
+    if (slot < kMaxProducers)
+    {
+      ring = new Ring(this->capacity);
+      this->rings[slot].store(ring, std::memory_order_release);
+    }
+    owned.emplace_back(this->id, ring);
+    return ring;
+  }
+
+  protected: const uint64_t id;
+  protected: size_t capacity;
+  protected: std::array<std::atomic<Ring *>, kMaxProducers> rings;
+  protected: std::atomic<size_t> numProducers{0};
+  protected: std::atomic<uint64_t> overflowed{0};
+  protected: std::atomic<uint64_t> drains{0};
+  protected: std::atomic<uint64_t> emptyDrains{0};
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__INGEST_QUEUE_HH_
@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "IngestQueue.hh"
+
+// Compares the IngestQueue against the mutex-protected hand-off it replaces,
+// with 1 to 32 producer threads pushing into a single consumer.
+
+namespace
+{
+
+const size_t kDefaultItemsPerProducer = 1000000;
+const size_t kQueueCapacity = 4096;
+const int kProducerCounts[] = {1, 2, 4, 8, 16, 32};
+
+struct Item
+{
+  uint64_t producer;
+  uint64_t sequence;
+  double value;
+};
+
+struct Result
+{
+  double seconds{0.0};
+  uint64_t consumed{0};
+  uint64_t dropped{0};
+  uint64_t headRefreshes{0};
+  double pushNs{0.0};
+};
+
+using Clock = std::chrono::steady_clock;
+
+//////////////////////////////////////////////////
+/// \brief Start all producers at once, so thread creation isn't measured.
+class StartGate
+{
+  public: void Wait()
+  {
+    while (!this->open.load(std::memory_order_acquire))
+      std::this_thread::yield();
+  }
+
+  public: void Open()
+  {
+    this->open.store(true, std::memory_order_release);
+  }
+
+  protected: std::atomic<bool> open{false};
+};
+
+//////////////////////////////////////////////////
+Result RunIngestQueue(int _producers, size_t _items)
+{
+  ign_imgui::IngestQueue<Item> queue(kQueueCapacity);
+  StartGate gate;
+  std::atomic<int> running{_producers};
+  std::atomic<uint64_t> pushNs{0};
+
+  std::vector<std::thread> threads;
+  for (int pp = 0; pp < _producers; ++pp)
+  {
+    threads.emplace_back([&, pp]()
+    {
+      gate.Wait();
+      const auto start = Clock::now();
+      for (size_t ii = 0; ii < _items; ++ii)
+        queue.Push({static_cast<uint64_t>(pp), ii, static_cast<double>(ii)});
+      pushNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+          Clock::now() - start).count();
+      --running;
+    });
+  }
+
+  Result result;
+  double sum = 0.0;
+  const auto start = Clock::now();
+  gate.Open();
+  while (true)
+  {
+    const bool done = running.load() == 0;
+    const size_t count = queue.Drain([&](const Item &_item)
+    {
+      sum += _item.value;
+    });
+    result.consumed += count;
+    if (done && count == 0)
+      break;
+  }
+  result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  for (auto &thread : threads)
+    thread.join();
+
+  const auto stats = queue.Stats();
+  result.dropped = stats.dropped + stats.overflowed;
+  result.headRefreshes = stats.headRefreshes;
+  result.pushNs = static_cast<double>(pushNs) / (_producers * _items);
+  // Keep the consumer work from being optimized away.
+  if (sum < 0.0)
+    std::printf("%f\n", sum);
+  return result;
+}
+
+//////////////////////////////////////////////////
+Result RunMutex(int _producers, size_t _items)
+{
+  std::mutex mutex;
+  std::vector<Item> pending;
+  std::vector<Item> draining;
+  StartGate gate;
+  std::atomic<int> running{_producers};
+  std::atomic<uint64_t> pushNs{0};
+
+  std::vector<std::thread> threads;
+  for (int pp = 0; pp < _producers; ++pp)
+  {
+    threads.emplace_back([&, pp]()
+    {
+      gate.Wait();
+      const auto start = Clock::now();
+      for (size_t ii = 0; ii < _items; ++ii)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(
+            {static_cast<uint64_t>(pp), ii, static_cast<double>(ii)});
+      }
+      pushNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+          Clock::now() - start).count();
+      --running;
+    });
+  }
+
+  Result result;
+  double sum = 0.0;
+  const auto start = Clock::now();
+  gate.Open();
+  while (true)
+  {
+    const bool done = running.load() == 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      std::swap(pending, draining);
+    }
+    for (const auto &item : draining)
+      sum += item.value;
+    result.consumed += draining.size();
+    const bool empty = draining.empty();
+    draining.clear();
+    if (done && empty)
+      break;
+  }
+  result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  for (auto &thread : threads)
+    thread.join();
+
+  result.pushNs = static_cast<double>(pushNs) / (_producers * _items);
+  if (sum < 0.0)
+    std::printf("%f\n", sum);
+  return result;
+}
+
+//////////////////////////////////////////////////
+void Print(const char *_name, int _producers, const Result &_result)
+{
+  std::printf("%-12s %9d %12.2f %12.1f %12llu %12llu\n", _name, _producers,
+      _result.consumed / _result.seconds / 1e6, _result.pushNs,
+      static_cast<unsigned long long>(_result.dropped),
+      static_cast<unsigned long long>(_result.headRefreshes));
+}
+
+}  // namespace
+
+//////////////////////////////////////////////////
+int main(int _argc, char **_argv)
+{
+  size_t items = kDefaultItemsPerProducer;
+  for (int i = 1; i < _argc; ++i)
+  {
+    if (i + 1 < _argc && 0 == strcmp(_argv[i], "--items"))
+    {
+      items = std::stoull(_argv[++i]);
+      continue;
+    }
+    std::printf("%s [--items <ITEMS_PER_PRODUCER>]\n", _argv[0]);
+    return 0;
+  }
+
+  std::printf("%-12s %9s %12s %12s %12s %12s\n", "queue", "producers",
+      "Mitems/s", "ns/push", "dropped", "refreshes");
+  for (int producers : kProducerCounts)
+  {
+    Print("ingest", producers, RunIngestQueue(producers, items));
+    Print("mutex", producers, RunMutex(producers, items));
+  }
+  return 0;
+}
@@ -0,0 +1,502 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "BinaryUtils.hh"
+#include "CsvUtils.hh"
+#include "IntervalHeatmap.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+
+const ImU32 kPercentileColors[3] = {
+  IM_COL32(255, 255, 255, 255),
+  IM_COL32(255, 160, 64, 255),
+  IM_COL32(255, 64, 64, 255),
+};
+
+//////////////////////////////////////////////////
+/// \brief Value below which _fraction of the counts fall, interpolating
+/// linearly inside the bin. NaN for an empty histogram.
+float Percentile(const float *_counts, size_t _numBins, float _min,
+                 float _max, float _fraction)
+{
+  double total = 0.0;
+  for (size_t ii = 0; ii < _numBins; ++ii)
+    total += _counts[ii];
+  if (total <= 0.0)
+    return std::numeric_limits<float>::quiet_NaN();
+
+  const double target = _fraction * total;
+  const float step = (_max - _min) / _numBins;
+  double cumulative = 0.0;
+  for (size_t ii = 0; ii < _numBins; ++ii)
+  {
+    if (_counts[ii] > 0.0f && cumulative + _counts[ii] >= target)
+    {
+      const double within = (target - cumulative) / _counts[ii];
+      return _min + step * (ii + static_cast<float>(within));
+    }
+    cumulative += _counts[ii];
+  }
+  return _max;
+}
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+constexpr std::array<float, 3> IntervalHeatmap::kPercentiles;
+
+//////////////////////////////////////////////////
+IntervalHeatmap::IntervalHeatmap()
+{
+  this->Update();
+}
+
+//////////////////////////////////////////////////
+void IntervalHeatmap::SetNumBins(size_t _numBins)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->numBins = _numBins;
+  this->Update();
+}
+
+//////////////////////////////////////////////////
+void IntervalHeatmap::SetRange(float _min, float _max)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->minBin = _min;
+  this->maxBin = _max;
+  this->Update();
+}
+
+//////////////////////////////////////////////////
+void IntervalHeatmap::SetInterval(double _interval)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->interval = _interval;
+  this->intervalStart = -1.0;
+}
+
+//////////////////////////////////////////////////
+void IntervalHeatmap::SetCapacity(size_t _columns)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->capacity = _columns;
+  this->Update();
+}
+
+//////////////////////////////////////////////////
+void IntervalHeatmap::InsertData(double _time, float _data)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  if (this->intervalStart < 0.0)
+    this->intervalStart = _time;
+
+  if (_time >= this->intervalStart + this->interval)
+  {
+    const auto elapsed = static_cast<uint64_t>(
+        (_time - this->intervalStart) / this->interval);
+    // Beyond a full ring of empty intervals older columns are gone anyway.
+    const uint64_t rotations = std::min<uint64_t>(elapsed, this->capacity);
+    for (uint64_t ii = 0; ii < rotations; ++ii)
+      this->RotateUnlocked();
+    this->intervalStart += elapsed * this->interval;
+  }
+
+  this->current.InsertData(_data);
+}
+
+//////////////////////////////////////////////////
+void IntervalHeatmap::InsertData(const double *_time, const float *_data,
+                                 size_t _count)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  size_t start = 0;
+  while (start < _count)
+  {
+    if (this->intervalStart < 0.0)
+      this->intervalStart = _time[start];
+
+    if (_time[start] >= this->intervalStart + this->interval)
+    {
+      const auto elapsed = static_cast<uint64_t>(
+          (_time[start] - this->intervalStart) / this->interval);
+      const uint64_t rotations = std::min<uint64_t>(elapsed, this->capacity);
+      for (uint64_t ii = 0; ii < rotations; ++ii)
+        this->RotateUnlocked();
+      this->intervalStart += elapsed * this->interval;
+    }
+
+    // Everything up to the first sample past this interval goes in one go.
+    const double end = this->intervalStart + this->interval;
+    size_t stop = start + 1;
+    while (stop < _count && _time[stop] < end)
+      ++stop;
+    this->current.InsertData(_data + start, stop - start);
+    start = stop;
+  }
+}
+
+//////////////////////////////////////////////////
+void IntervalHeatmap::Rotate()
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->RotateUnlocked();
+}
+
+//////////////////////////////////////////////////
+size_t IntervalHeatmap::NumColumns() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return std::min<uint64_t>(this->closed, this->capacity);
+}
+
+//////////////////////////////////////////////////
+IntervalColumns IntervalHeatmap::Columns(uint64_t _first) const
+{
+  IntervalColumns result;
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  result.numBins = this->numBins;
+  result.min = this->minBin;
+  result.max = this->maxBin;
+  result.interval = this->interval;
+  const uint64_t stored = std::min<uint64_t>(this->closed, this->capacity);
+  result.first = std::max(_first, this->closed - stored);
+  if (result.first >= this->closed)
+  {
+    result.first = this->closed;
+    return result;
+  }
+
+  const uint64_t count = this->closed - result.first;
+  result.counts.resize(count * this->numBins);
+  result.percentiles.resize(count * kPercentiles.size());
+  for (uint64_t done = 0; done < count; ++done)
+  {
+    const uint64_t kk = result.first + done;
+    std::copy_n(this->columns[kk % this->capacity].Data(), this->numBins,
+        result.counts.begin() + done * this->numBins);
+    std::copy_n(this->Percentiles(kk).data(), kPercentiles.size(),
+        result.percentiles.begin() + done * kPercentiles.size());
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////
+void IntervalHeatmap::Plot(const std::string &_label, ImVec2 _graphSize)
+{
+  if (_graphSize.x <= 0.0f)
+    _graphSize.x = ImGui::CalcItemWidth();
+  if (_graphSize.y <= 0.0f)
+    _graphSize.y = _graphSize.x * 0.5f;
+  const int width = std::max(1, static_cast<int>(_graphSize.x));
+
+  size_t bins;
+  size_t ringSize;
+  uint64_t closedNow;
+  float rangeMin;
+  float rangeMax;
+  uint64_t firstPending;
+  std::vector<std::array<float, 3>> pixelPercentiles(width);
+  {
+    std::lock_guard<std::mutex> lock(this->dataMutex);
+    bins = this->numBins;
+    ringSize = this->capacity;
+    closedNow = this->closed;
+    rangeMin = this->minBin;
+    rangeMax = this->maxBin;
+
+    if (this->layout != this->uploadedLayout)
+    {
+      this->texture.Resize(static_cast<int>(ringSize), static_cast<int>(bins));
+      this->uploadedLayout = this->layout;
+      this->uploaded = 0;
+    }
+
+    // Copy out only the columns the texture has not seen yet.
+    firstPending = std::max(this->uploaded,
+        closedNow > ringSize ? closedNow - ringSize : 0);
+    this->pending.resize((closedNow - firstPending) * bins);
+    for (uint64_t kk = firstPending; kk < closedNow; ++kk)
+    {
+      std::copy_n(this->columns[kk % ringSize].Data(), bins,
+          this->pending.begin() + (kk - firstPending) * bins);
+    }
+
+    // Percentile curves are sampled once per pixel, not once per column.
+    const uint64_t visible = std::min<uint64_t>(closedNow, ringSize);
+    for (int px = 0; px < width && visible > 0; ++px)
+    {
+      const uint64_t kk = closedNow - visible + px * visible / width;
+      pixelPercentiles[px] = this->Percentiles(kk);
+    }
+  }
+
+  std::vector<float> flipped(bins);
+  for (uint64_t kk = firstPending; kk < closedNow; ++kk)
+  {
+    const float *counts = &this->pending[(kk - firstPending) * bins];
+    float maxCount = 0.0f;
+    for (size_t ii = 0; ii < bins; ++ii)
+    {
+      flipped[bins - 1 - ii] = counts[ii];
+      maxCount = std::max(maxCount, counts[ii]);
+    }
+    // Each column is scaled on its own, so intervals with fewer samples
+    // still show their shape and old columns never need recolouring.
+    this->texture.UpdateColumn(static_cast<int>(kk % ringSize),
+        flipped.data(), maxCount, kk + 1);
+  }
+  this->uploaded = closedNow;
+
+  const ImVec2 pos = ImGui::GetCursorScreenPos();
+  const uint64_t visible = std::min<uint64_t>(closedNow, ringSize);
+  if (visible == 0 || ringSize == 0)
+  {
+    ImGui::Dummy(_graphSize);
+  }
+  else
+  {
+    // Oldest column on the left: the ring may wrap inside the texture.
+    const uint64_t start = (closedNow - visible) % ringSize;
+    const uint64_t firstRun = std::min<uint64_t>(visible, ringSize - start);
+    const float firstWidth = _graphSize.x * firstRun / visible;
+    this->texture.Draw(ImVec2(firstWidth, _graphSize.y),
+        ImVec2(static_cast<float>(start) / ringSize, 0.0f),
+        ImVec2(static_cast<float>(start + firstRun) / ringSize, 1.0f));
+    if (firstRun < visible)
+    {
+      ImGui::SameLine(0.0f, 0.0f);
+      this->texture.Draw(ImVec2(_graphSize.x - firstWidth, _graphSize.y),
+          ImVec2(0.0f, 0.0f),
+          ImVec2(static_cast<float>(visible - firstRun) / ringSize, 1.0f));
+    }
+
+    auto drawList = ImGui::GetWindowDrawList();
+    const float range = rangeMax - rangeMin;
+    for (size_t pp = 0; pp < kPercentiles.size(); ++pp)
+    {
+      for (int px = 1; px < width; ++px)
+      {
+        const float a = pixelPercentiles[px - 1][pp];
+        const float b = pixelPercentiles[px][pp];
+        if (std::isnan(a) || std::isnan(b))
+          continue;
+        const float ya = std::min(std::max((a - rangeMin) / range, 0.0f), 1.0f);
+        const float yb = std::min(std::max((b - rangeMin) / range, 0.0f), 1.0f);
+        drawList->AddLine(
+            ImVec2(pos.x + px - 1, pos.y + _graphSize.y * (1.0f - ya)),
+            ImVec2(pos.x + px, pos.y + _graphSize.y * (1.0f - yb)),
+            kPercentileColors[pp]);
+      }
+    }
+  }
+  ImGui::SameLine();
+  ImGui::TextUnformatted(_label.c_str());
+}
+
+//////////////////////////////////////////////////
+void IntervalHeatmap::ToCsv(std::ostream & ost) const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  const uint64_t stored = std::min<uint64_t>(this->closed, this->capacity);
+  ost << this->numBins << "," << this->minBin << "," << this->maxBin << "," <<
+    this->interval << "," << this->capacity << "," << this->closed << "," <<
+    stored << "," << std::endl;
+  for (uint64_t kk = this->closed - stored; kk < this->closed; ++kk)
+  {
+    for (auto value : this->Percentiles(kk))
+      ost << value << ",";
+    for (auto count : this->columns[kk % this->capacity])
+      ost << count << ",";
+    ost << std::endl;
+  }
+}
+
+//////////////////////////////////////////////////
+void IntervalHeatmap::FromCsv(std::istream & ist)
+{
+  size_t newNumBins;
+  float newMin;
+  float newMax;
+  double newInterval;
+  size_t newCapacity;
+  uint64_t newClosed;
+  uint64_t stored;
+  GetNextCsv(ist, newNumBins);
+  GetNextCsv(ist, newMin);
+  GetNextCsv(ist, newMax);
+  GetNextCsv(ist, newInterval);
+  GetNextCsv(ist, newCapacity);
+  GetNextCsv(ist, newClosed);
+  GetNextCsv(ist, stored);
+  GetNewLine(ist);
+  if (stored > newCapacity || stored > newClosed)
+    throw std::runtime_error{"failed to parse input csv file"};
+
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->numBins = newNumBins;
+  this->minBin = newMin;
+  this->maxBin = newMax;
+  this->interval = newInterval;
+  this->capacity = newCapacity;
+  this->Update();
+
+  this->closed = newClosed - stored;
+  std::vector<float> counts(this->numBins);
+  for (uint64_t kk = 0; kk < stored; ++kk)
+  {
+    // Percentiles are recomputed from the counts; they are read as text
+    // since empty intervals were written as nan, which streams do not parse.
+    for (size_t pp = 0; pp < kPercentiles.size(); ++pp)
+    {
+      std::string percentile;
+      GetNextCsv(ist, percentile);
+    }
+    for (auto &count : counts)
+      GetNextCsv(ist, count);
+    this->PushColumn(counts);
+  }
+  ist >> std::ws;
+}
+
+//////////////////////////////////////////////////
+void IntervalHeatmap::ToBinary(std::ostream & ost) const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  const uint64_t stored = std::min<uint64_t>(this->closed, this->capacity);
+  WriteBinary(ost, static_cast<uint64_t>(this->numBins));
+  WriteBinary(ost, this->minBin);
+  WriteBinary(ost, this->maxBin);
+  WriteBinary(ost, this->interval);
+  WriteBinary(ost, static_cast<uint64_t>(this->capacity));
+  WriteBinary(ost, this->closed);
+  WriteBinary(ost, stored);
+  for (uint64_t kk = this->closed - stored; kk < this->closed; ++kk)
+  {
+    ost.write(reinterpret_cast<const char *>(
+          this->columns[kk % this->capacity].Data()),
+        this->numBins * sizeof(float));
+  }
+}
+
+//////////////////////////////////////////////////
+void IntervalHeatmap::FromBinary(std::istream & ist)
+{
+  uint64_t newNumBins;
+  float newMin;
+  float newMax;
+  double newInterval;
+  uint64_t newCapacity;
+  uint64_t newClosed;
+  uint64_t stored;
+  ReadBinary(ist, newNumBins);
+  ReadBinary(ist, newMin);
+  ReadBinary(ist, newMax);
+  ReadBinary(ist, newInterval);
+  ReadBinary(ist, newCapacity);
+  ReadBinary(ist, newClosed);
+  ReadBinary(ist, stored);
+  if (stored > newCapacity || stored > newClosed)
+    throw std::runtime_error{"failed to parse input binary file"};
+
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->numBins = newNumBins;
+  this->minBin = newMin;
+  this->maxBin = newMax;
+  this->interval = newInterval;
+  this->capacity = newCapacity;
+  this->Update();
+
+  this->closed = newClosed - stored;
+  std::vector<float> counts(this->numBins);
+  for (uint64_t kk = 0; kk < stored; ++kk)
+  {
+    ist.read(reinterpret_cast<char *>(counts.data()),
+        counts.size() * sizeof(float));
+    IGN_IMGUI_CHECK_BINARY(ist);
+    this->PushColumn(counts);
+  }
+}
+
+//////////////////////////////////////////////////
+void IntervalHeatmap::Update()
+{
+  this->current.SetNumBins(this->numBins);
+  this->current.SetRange(this->minBin, this->maxBin);
+  this->columns.clear();
+  this->columns.resize(this->capacity);
+  this->percentiles.resize(this->capacity);
+  this->percentileColumns.assign(this->capacity, UINT64_MAX);
+  this->closed = 0;
+  this->intervalStart = -1.0;
+  ++this->layout;
+}
+
+//////////////////////////////////////////////////
+void IntervalHeatmap::RotateUnlocked()
+{
+  if (this->capacity == 0)
+  {
+    this->current.Reset();
+    return;
+  }
+  // The counts replaced in the slot go back to the pool for zeroing.
+  this->columns[this->closed % this->capacity] = this->current.TakeCounts();
+  ++this->closed;
+}
+
+//////////////////////////////////////////////////
+void IntervalHeatmap::PushColumn(const std::vector<float> &_counts)
+{
+  if (this->capacity == 0)
+    return;
+  auto column = HistogramPool::Instance().Acquire(this->numBins);
+  std::copy_n(_counts.begin(), this->numBins, column.begin());
+  this->columns[this->closed % this->capacity] = std::move(column);
+  ++this->closed;
+}
+
+//////////////////////////////////////////////////
+const std::array<float, 3> &IntervalHeatmap::Percentiles(
+    uint64_t _column) const
+{
+  const auto slot = _column % this->capacity;
+  if (this->percentileColumns[slot] != _column)
+  {
+    const auto &counts = this->columns[slot];
+    for (size_t pp = 0; pp < kPercentiles.size(); ++pp)
+    {
+      this->percentiles[slot][pp] = Percentile(counts.Data(), counts.Size(),
+          this->minBin, this->maxBin, kPercentiles[pp]);
+    }
+    this->percentileColumns[slot] = _column;
+  }
+  return this->percentiles[slot];
+}
+
+}  // namespace ign_imgui
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__INTERVAL_HEATMAP_HH_
+#define IGN_IMGUI__INTERVAL_HEATMAP_HH_
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <imgui/imgui.h>
+
+#include "HeatmapTexture.hh"
+#include "Histogram.hh"
+
+namespace ign_imgui
+{
+
+/// \brief Closed intervals copied out of an IntervalHeatmap, oldest first.
+struct IntervalColumns
+{
+  /// \brief Number of the first interval, counting every interval closed
+  /// since the layout was last set.
+  uint64_t first{0};
+  size_t numBins{0};
+  float min{0.0f};
+  float max{0.0f};
+  double interval{0.0};
+
+  /// \brief numBins counts per interval.
+  std::vector<float> counts;
+
+  /// \brief kPercentiles.size() values per interval, NaN when empty.
+  std::vector<float> percentiles;
+};
+
+/// \brief Distribution over time: one heatmap column per time interval.
+///
+/// Samples go into a Histogram for the current interval. When an interval
+/// ends its pooled counts move into a ring of columns and the histogram
+/// continues with zeroed ones, so closing an interval is O(1). Percentiles
+/// of a column are computed the first time they are read. The texture only
+/// receives the columns closed since the last frame, so drawing costs
+/// O(new columns * bins + width) no matter how many columns are kept.
+class IntervalHeatmap
+{
+  /// \brief Percentiles drawn over the heatmap, in [0, 1].
+  public: static constexpr std::array<float, 3> kPercentiles{
+    {0.5f, 0.9f, 0.99f}};
+
+  public: IntervalHeatmap();
+
+  public: void SetNumBins(size_t _numBins);
+  public: void SetRange(float _min, float _max);
+  public: void SetInterval(double _interval);
+  public: void SetCapacity(size_t _columns);
+
+  /// \brief Insert a sample taken at _time seconds, closing the current
+  /// interval first if _time is past its end.
+  public: void InsertData(double _time, float _data);
+
+  /// \brief Same as inserting each sample in turn, with the samples of
+  /// each interval binned as one batch. _time must not decrease.
+  public: void InsertData(const double *_time, const float *_data,
+                          size_t _count);
+
+  /// \brief Close the current interval now.
+  public: void Rotate();
+
+  public: size_t NumColumns() const;
+
+  /// \brief Copy the closed intervals numbered _first and later that are
+  /// still kept, e.g. to export what closed since the last export.
+  public: IntervalColumns Columns(uint64_t _first) const;
+
+  public: void Plot(const std::string &_label,
+                    ImVec2 _graphSize=ImVec2(0,0));
+
+  public: void ToCsv(std::ostream & ost) const;
+
+  public: void FromCsv(std::istream & ist);
+
+  public: void ToBinary(std::ostream & ost) const;
+
+  public: void FromBinary(std::istream & ist);
+
+  protected: void Update();
+  protected: void RotateUnlocked();
+  protected: void PushColumn(const std::vector<float> &_counts);
+
+  /// \brief Percentiles of the kept column _column. Needs the mutex.
+  protected: const std::array<float, 3> &Percentiles(uint64_t _column) const;
+
+  protected: size_t numBins{0};
+  protected: float minBin{0.0f};
+  protected: float maxBin{0.0f};
+  protected: double interval{10.0};
+  protected: size_t capacity{4096};
+  protected: double intervalStart{-1.0};
+
+  protected: Histogram current;
+
+  /// \brief Ring of closed columns, column k in slot k % capacity.
+  protected: std::vector<HistogramBuffer> columns;
+
+  /// \brief Percentiles per slot, valid if percentileColumns holds the
+  /// number of the column in the slot.
+  protected: mutable std::vector<std::array<float, 3>> percentiles;
+  protected: mutable std::vector<uint64_t> percentileColumns;
+  protected: uint64_t closed{0};
+  protected: mutable std::mutex dataMutex;
+
+  /// \brief Render-thread state: columns already in the texture.
+  protected: HeatmapTexture texture;
+  protected: uint64_t uploaded{0};
+  protected: uint64_t layout{0};
+  protected: uint64_t uploadedLayout{UINT64_MAX};
+  protected: std::vector<float> pending;
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__INTERVAL_HEATMAP_HH_
@@ -0,0 +1,405 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "BinaryUtils.hh"
+#include "CsvUtils.hh"
+#include "LaggedCorrelation.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+#include <imgui/imgui.h>
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+void LaggedCorrelation::CoMoments::InsertData(double _x, double _y)
+{
+  ++this->count;
+  const double dx = _x - this->meanX;
+  const double dy = _y - this->meanY;
+  this->meanX += dx / this->count;
+  this->meanY += dy / this->count;
+  this->m2x += dx * (_x - this->meanX);
+  this->m2y += dy * (_y - this->meanY);
+  this->cxy += dx * (_y - this->meanY);
+}
+
+//////////////////////////////////////////////////
+double LaggedCorrelation::CoMoments::Pearson() const
+{
+  if (this->count < 2 || this->m2x <= 0.0 || this->m2y <= 0.0)
+    return 0.0;
+  return this->cxy / std::sqrt(this->m2x * this->m2y);
+}
+
+//////////////////////////////////////////////////
+void LaggedCorrelation::SetPeriod(double _period)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->period = _period;
+  this->cell = -1;
+}
+
+//////////////////////////////////////////////////
+void LaggedCorrelation::SetLags(const std::vector<int> &_lags)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->lags = _lags;
+  size_t maxLag = 0;
+  for (auto lag : this->lags)
+    maxLag = std::max(maxLag, static_cast<size_t>(std::abs(lag)));
+  this->historySize = maxLag + 1;
+  this->historyHead = 0;
+  this->historyCount = 0;
+
+  this->InitHistory(this->rtf);
+  for (auto &s : this->series)
+    this->InitHistory(s);
+}
+
+//////////////////////////////////////////////////
+size_t LaggedCorrelation::AddSeries(const std::string &_name,
+                                    Aggregation _aggregation)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  Series s;
+  s.name = _name;
+  s.aggregation = _aggregation;
+  this->InitHistory(s);
+  this->series.push_back(std::move(s));
+  return this->series.size() - 1;
+}
+
+//////////////////////////////////////////////////
+void LaggedCorrelation::Reset()
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->historyHead = 0;
+  this->historyCount = 0;
+  this->cell = -1;
+  this->InitHistory(this->rtf);
+  for (auto &s : this->series)
+    this->InitHistory(s);
+}
+
+//////////////////////////////////////////////////
+void LaggedCorrelation::InsertRtf(double _time, double _rtf)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->Advance(_time);
+  this->rtf.sum += _rtf;
+  ++this->rtf.samples;
+}
+
+//////////////////////////////////////////////////
+void LaggedCorrelation::InsertData(size_t _series, double _time, double _value)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->Advance(_time);
+  auto &s = this->series.at(_series);
+  s.sum += _value;
+  ++s.samples;
+}
+
+//////////////////////////////////////////////////
+size_t LaggedCorrelation::NumSeries() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->series.size();
+}
+
+//////////////////////////////////////////////////
+std::string LaggedCorrelation::SeriesName(size_t _series) const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->series.at(_series).name;
+}
+
+//////////////////////////////////////////////////
+std::vector<int> LaggedCorrelation::Lags() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->lags;
+}
+
+//////////////////////////////////////////////////
+std::vector<float> LaggedCorrelation::Correlations(size_t _series) const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  const auto &s = this->series.at(_series);
+  std::vector<float> result(s.lags.size());
+  for (size_t ii = 0; ii < s.lags.size(); ++ii)
+    result[ii] = static_cast<float>(s.lags[ii].Pearson());
+  return result;
+}
+
+//////////////////////////////////////////////////
+int LaggedCorrelation::StrongestLag(size_t _series) const
+{
+  auto correlations = this->Correlations(_series);
+  auto lagValues = this->Lags();
+  if (correlations.empty())
+    return 0;
+  auto strongest = std::max_element(correlations.begin(), correlations.end(),
+      [](float _a, float _b) { return std::abs(_a) < std::abs(_b); });
+  return lagValues[strongest - correlations.begin()];
+}
+
+//////////////////////////////////////////////////
+void LaggedCorrelation::Draw()
+{
+  const size_t numSeries = this->NumSeries();
+  for (size_t ii = 0; ii < numSeries; ++ii)
+  {
+    auto correlations = this->Correlations(ii);
+    if (correlations.empty())
+      continue;
+    const int lag = this->StrongestLag(ii);
+    const auto lagValues = this->Lags();
+    const auto strongest = std::find(lagValues.begin(), lagValues.end(), lag);
+
+    char overlay[64];
+    std::snprintf(overlay, sizeof(overlay), "strongest lag %d: r=%.2f", lag,
+        correlations[strongest - lagValues.begin()]);
+    const std::string label = "rtf vs " + this->SeriesName(ii);
+    ImGui::PlotHistogram(label.c_str(),
+                         &correlations[0],
+                         correlations.size(),
+                         0,
+                         overlay,
+                         -1.0f,
+                         1.0f,
+                         ImVec2(0, 80));
+  }
+}
+
+//////////////////////////////////////////////////
+void LaggedCorrelation::ToCsv(std::ostream & ost) const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  const auto precision = ost.precision(std::numeric_limits<double>::max_digits10);
+  ost << this->period << "," << this->lags.size() << "," <<
+    this->series.size() << "," << std::endl;
+  for (auto lag : this->lags)
+    ost << lag << ",";
+  ost << std::endl;
+  for (const auto &s : this->series)
+  {
+    for (size_t ii = 0; ii < this->lags.size(); ++ii)
+    {
+      const auto &m = s.lags[ii];
+      ost << s.name << "," << static_cast<int>(s.aggregation) << "," <<
+        this->lags[ii] << "," << m.Pearson() << "," << m.count << "," <<
+        m.meanX << "," << m.meanY << "," << m.m2x << "," << m.m2y << "," <<
+        m.cxy << "," << std::endl;
+    }
+  }
+  ost.precision(precision);
+}
+
+//////////////////////////////////////////////////
+void LaggedCorrelation::FromCsv(std::istream & ist)
+{
+  double newPeriod;
+  size_t numLags;
+  size_t numSeries;
+  GetNextCsv(ist, newPeriod);
+  GetNextCsv(ist, numLags);
+  GetNextCsv(ist, numSeries);
+  GetNewLine(ist);
+
+  std::vector<int> newLags(numLags);
+  for (auto &lag : newLags)
+    GetNextCsv(ist, lag);
+
+  std::vector<Series> newSeries(numSeries);
+  for (auto &s : newSeries)
+  {
+    s.lags.resize(numLags);
+    for (size_t ii = 0; ii < numLags; ++ii)
+    {
+      int aggregation;
+      int lag;
+      double pearson;
+      auto &m = s.lags[ii];
+      GetNextCsv(ist, s.name);
+      GetNextCsv(ist, aggregation);
+      GetNextCsv(ist, lag);
+      GetNextCsv(ist, pearson);
+      GetNextCsv(ist, m.count);
+      GetNextCsv(ist, m.meanX);
+      GetNextCsv(ist, m.meanY);
+      GetNextCsv(ist, m.m2x);
+      GetNextCsv(ist, m.m2y);
+      GetNextCsv(ist, m.cxy);
+      if (lag != newLags[ii])
+        throw std::runtime_error{"failed to parse input csv file"};
+      s.aggregation = static_cast<Aggregation>(aggregation);
+    }
+  }
+  ist >> std::ws;
+
+  this->SetPeriod(newPeriod);
+  this->SetLags(newLags);
+
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->series = std::move(newSeries);
+  for (auto &s : this->series)
+  {
+    auto comoments = std::move(s.lags);
+    this->InitHistory(s);
+    s.lags = std::move(comoments);
+  }
+}
+
+//////////////////////////////////////////////////
+void LaggedCorrelation::ToBinary(std::ostream & ost) const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  WriteBinary(ost, this->period);
+  WriteBinary(ost, this->lags);
+  WriteBinary(ost, static_cast<uint64_t>(this->series.size()));
+  for (const auto &s : this->series)
+  {
+    WriteBinary(ost, s.name);
+    WriteBinary(ost, static_cast<int32_t>(s.aggregation));
+    WriteBinary(ost, s.lags);
+  }
+}
+
+//////////////////////////////////////////////////
+void LaggedCorrelation::FromBinary(std::istream & ist)
+{
+  double newPeriod;
+  std::vector<int> newLags;
+  uint64_t numSeries;
+  ReadBinary(ist, newPeriod);
+  ReadBinary(ist, newLags);
+  ReadBinary(ist, numSeries);
+
+  std::vector<Series> newSeries(numSeries);
+  for (auto &s : newSeries)
+  {
+    int32_t aggregation;
+    ReadBinary(ist, s.name);
+    ReadBinary(ist, aggregation);
+    ReadBinary(ist, s.lags);
+    s.aggregation = static_cast<Aggregation>(aggregation);
+    if (s.lags.size() != newLags.size())
+      throw std::runtime_error{"failed to parse input binary file"};
+  }
+
+  this->SetPeriod(newPeriod);
+  this->SetLags(newLags);
+
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->series = std::move(newSeries);
+  for (auto &s : this->series)
+  {
+    auto comoments = std::move(s.lags);
+    this->InitHistory(s);
+    s.lags = std::move(comoments);
+  }
+}
+
+//////////////////////////////////////////////////
+void LaggedCorrelation::InitHistory(Series &_series) const
+{
+  const double empty = _series.aggregation == Aggregation::kSum ?
+    0.0 : std::numeric_limits<double>::quiet_NaN();
+  _series.sum = 0.0;
+  _series.samples = 0;
+  _series.held = empty;
+  _series.history.assign(this->historySize,
+      std::numeric_limits<double>::quiet_NaN());
+  _series.lags.assign(this->lags.size(), CoMoments());
+}
+
+//////////////////////////////////////////////////
+void LaggedCorrelation::Advance(double _time)
+{
+  const auto newCell = static_cast<int64_t>(std::floor(_time / this->period));
+  if (this->cell < 0)
+  {
+    this->cell = newCell;
+    return;
+  }
+  if (newCell <= this->cell)
+    return;
+
+  // Past a full history of empty cells nothing more can pair up, so long
+  // gaps are closed in bounded time.
+  const auto ticks = std::min<int64_t>(newCell - this->cell,
+      static_cast<int64_t>(this->historySize) + 1);
+  for (int64_t ii = 0; ii < ticks; ++ii)
+    this->Tick();
+  this->cell = newCell;
+}
+
+//////////////////////////////////////////////////
+void LaggedCorrelation::Tick()
+{
+  this->historyHead = (this->historyHead + 1) % this->historySize;
+  this->historyCount = std::min(this->historyCount + 1, this->historySize);
+
+  // Cells without any RTF sample never pair with anything.
+  this->rtf.history[this->historyHead] = this->rtf.samples > 0 ?
+    this->rtf.sum / this->rtf.samples : std::numeric_limits<double>::quiet_NaN();
+  this->rtf.sum = 0.0;
+  this->rtf.samples = 0;
+
+  for (auto &s : this->series)
+  {
+    double value;
+    if (s.aggregation == Aggregation::kSum)
+      value = s.sum;
+    else
+      value = s.samples > 0 ? s.sum / s.samples : s.held;
+    s.held = value;
+    s.sum = 0.0;
+    s.samples = 0;
+    s.history[this->historyHead] = value;
+
+    for (size_t ii = 0; ii < this->lags.size(); ++ii)
+    {
+      const int lag = this->lags[ii];
+      if (this->historyCount <= static_cast<size_t>(std::abs(lag)))
+        continue;
+      const double x = lag >= 0 ? this->History(s, lag) : this->History(s, 0);
+      const double y = lag >= 0 ?
+        this->History(this->rtf, 0) : this->History(this->rtf, -lag);
+      if (std::isfinite(x) && std::isfinite(y))
+        s.lags[ii].InsertData(x, y);
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+double LaggedCorrelation::History(const Series &_series, size_t _age) const
+{
+  return _series.history[
+    (this->historyHead + this->historySize - _age) % this->historySize];
+}
+
+}  // namespace ign_imgui
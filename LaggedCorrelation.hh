@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__LAGGED_CORRELATION_HH_
+#define IGN_IMGUI__LAGGED_CORRELATION_HH_
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ign_imgui
+{
+
+/// \brief Streaming Pearson correlation between the RTF series and a set of
+/// auxiliary series, for a fixed set of lags.
+///
+/// All series are resampled onto a common grid of period SetPeriod(). When a
+/// grid cell closes every series contributes one value and each (series, lag)
+/// pair updates its running co-moments, so a tick costs O(series * lags).
+/// A positive lag pairs the auxiliary value with the RTF value that many
+/// ticks later, i.e. the auxiliary series leads.
+class LaggedCorrelation
+{
+  /// \brief How samples falling in the same grid cell are combined.
+  public: enum class Aggregation
+  {
+    /// \brief Average of the samples, holding the last value through empty
+    /// cells (gauges such as CPU usage).
+    kMean,
+    /// \brief Sum of the samples, zero for empty cells (event counts).
+    kSum
+  };
+
+  public: LaggedCorrelation() = default;
+
+  public: void SetPeriod(double _period);
+  public: void SetLags(const std::vector<int> &_lags);
+  public: size_t AddSeries(const std::string &_name,
+                           Aggregation _aggregation);
+  public: void Reset();
+
+  public: void InsertRtf(double _time, double _rtf);
+  public: void InsertData(size_t _series, double _time, double _value);
+
+  public: size_t NumSeries() const;
+  public: std::string SeriesName(size_t _series) const;
+  public: std::vector<int> Lags() const;
+
+  /// \brief Pearson coefficient for every lag, in SetLags() order.
+  public: std::vector<float> Correlations(size_t _series) const;
+
+  /// \brief Lag with the largest absolute correlation.
+  public: int StrongestLag(size_t _series) const;
+
+  public: void Draw();
+
+  public: void ToCsv(std::ostream & ost) const;
+
+  public: void FromCsv(std::istream & ist);
+
+  public: void ToBinary(std::ostream & ost) const;
+
+  public: void FromBinary(std::istream & ist);
+
+  /// \brief Running means and co-moments for one (series, lag) pair.
+  protected: struct CoMoments
+  {
+    uint64_t count{0};
+    double meanX{0.0};
+    double meanY{0.0};
+    double m2x{0.0};
+    double m2y{0.0};
+    double cxy{0.0};
+
+    void InsertData(double _x, double _y);
+    double Pearson() const;
+  };
+
+  protected: struct Series
+  {
+    std::string name;
+    Aggregation aggregation{Aggregation::kMean};
+    double sum{0.0};
+    size_t samples{0};
+    double held{0.0};
+    std::vector<double> history;
+    std::vector<CoMoments> lags;
+  };
+
+  protected: void InitHistory(Series &_series) const;
+  protected: void Advance(double _time);
+  protected: void Tick();
+  protected: double History(const Series &_series, size_t _age) const;
+
+  protected: double period{0.1};
+  protected: std::vector<int> lags{0};
+  protected: size_t historySize{1};
+  protected: size_t historyHead{0};
+  protected: size_t historyCount{0};
+  protected: int64_t cell{-1};
+  protected: Series rtf;
+  protected: std::vector<Series> series;
+  protected: mutable std::mutex dataMutex;
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__LAGGED_CORRELATION_HH_
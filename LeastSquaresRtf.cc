@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "LeastSquaresRtf.hh"
+
+#include <cmath>
+
+#include <imgui/imgui.h>
+
+namespace
+{
+
+const size_t kSlopeBins = 200;
+const size_t kResidualBins = 100;
+const double kNsPerSecond = 1e9;
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+constexpr size_t LeastSquaresRtf::kDefaultWindow;
+constexpr float LeastSquaresRtf::kResidualMaxMs;
+
+//////////////////////////////////////////////////
+LeastSquaresRtf::LeastSquaresRtf()
+{
+  this->regression.SetWindow(kDefaultWindow);
+  this->slopes.SetNumBins(kSlopeBins);
+  this->slopes.SetRange(0.0f, 2.0f);
+  this->residuals.SetNumBins(kResidualBins);
+  this->residuals.SetRange(0.0f, kResidualMaxMs);
+  this->slopeIntervals.SetNumBins(kSlopeBins);
+  this->slopeIntervals.SetRange(0.0f, 2.0f);
+}
+
+//////////////////////////////////////////////////
+void LeastSquaresRtf::SetWindow(size_t _samples)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->regression.SetWindow(_samples);
+  this->full = false;
+}
+
+//////////////////////////////////////////////////
+size_t LeastSquaresRtf::Window() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->regression.Window();
+}
+
+//////////////////////////////////////////////////
+void LeastSquaresRtf::SetRange(float _min, float _max)
+{
+  this->slopes.SetRange(_min, _max);
+  this->slopeIntervals.SetRange(_min, _max);
+}
+
+//////////////////////////////////////////////////
+void LeastSquaresRtf::SetIntervals(double _interval, size_t _columns)
+{
+  this->slopeIntervals.SetInterval(_interval);
+  this->slopeIntervals.SetCapacity(_columns);
+}
+
+//////////////////////////////////////////////////
+void LeastSquaresRtf::InsertData(int64_t _real, int64_t _sim, double _steady)
+{
+  RegressionFit fit;
+  {
+    std::lock_guard<std::mutex> lock(this->dataMutex);
+    // A point behind the previous one, e.g. after a world reset, isn't on
+    // the same line, so the window restarts with it.
+    if (this->regression.Count() > 0 &&
+        (_sim < this->lastSim || _real < this->lastReal))
+    {
+      this->regression.Clear();
+    }
+    this->lastReal = _real;
+    this->lastSim = _sim;
+    this->regression.Add(_real, _sim);
+    this->full = this->regression.Count() == this->regression.Window();
+    if (!this->full || !this->regression.Fit(fit))
+      return;
+    fit.intercept /= kNsPerSecond;
+    fit.residualVariance /= kNsPerSecond * kNsPerSecond;
+    this->latest = fit;
+  }
+
+  const float slope = static_cast<float>(fit.slope);
+  this->slopes.InsertData(slope);
+  this->residuals.InsertData(
+      static_cast<float>(std::sqrt(fit.residualVariance) * 1e3));
+  this->slopeIntervals.InsertData(_steady, slope);
+}
+
+//////////////////////////////////////////////////
+bool LeastSquaresRtf::Latest(RegressionFit &_fit) const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  if (!this->full)
+    return false;
+  _fit = this->latest;
+  return true;
+}
+
+//////////////////////////////////////////////////
+void LeastSquaresRtf::Draw()
+{
+  RegressionFit fit;
+  if (this->Latest(fit))
+  {
+    ImGui::Text("least squares over %zu samples: RTF %.4f, "
+        "sim offset %.3fs, residual sd %.3f ms", fit.count, fit.slope,
+        fit.intercept, std::sqrt(fit.residualVariance) * 1e3);
+  }
+  else
+  {
+    ImGui::Text("least squares: waiting for %zu samples", this->Window());
+  }
+  this->slopes.PlotHistogram("RTF (least squares)", ImVec2(0, 120));
+  this->residuals.PlotHistogram("residual sd (ms)", ImVec2(0, 60));
+  this->slopeIntervals.Plot("least-squares RTF over time");
+}
+
+}  // namespace ign_imgui
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__LEAST_SQUARES_RTF_HH_
+#define IGN_IMGUI__LEAST_SQUARES_RTF_HH_
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <mutex>
+
+#include "Histogram.hh"
+#include "IntervalHeatmap.hh"
+#include "SlidingRegression.hh"
+
+namespace ign_imgui
+{
+
+/// \brief RTF as the slope of sim time against real time over the last
+/// Window() clock samples.
+///
+/// The ratio of consecutive steps amplifies timestamp jitter, while the
+/// slope of a fit averages it out and stays defined when two messages
+/// share a real time. Once the window is full every sample adds the slope
+/// and the residual standard deviation to their histograms, and the slope
+/// to a heatmap over time.
+class LeastSquaresRtf
+{
+  public: static constexpr size_t kDefaultWindow = 100;
+
+  /// \brief Upper end of the residual histogram in milliseconds.
+  public: static constexpr float kResidualMaxMs = 10.0f;
+
+  public: LeastSquaresRtf();
+
+  /// \brief Fit over the last _samples samples, clears the window.
+  /// \throws std::runtime_error if SlidingRegression rejects _samples.
+  public: void SetWindow(size_t _samples);
+  public: size_t Window() const;
+
+  /// \brief RTF range of the slope histogram and heatmap.
+  public: void SetRange(float _min, float _max);
+
+  /// \brief Heatmap interval length in seconds and number of columns.
+  public: void SetIntervals(double _interval, size_t _columns);
+
+  /// \brief Add a clock sample. A sample with sim or real time before the
+  /// previous one clears the window, the fit restarts from it.
+  /// \param[in] _real Real time in nanoseconds.
+  /// \param[in] _sim Sim time in nanoseconds.
+  /// \param[in] _steady Local receive time, see SteadySeconds().
+  public: void InsertData(int64_t _real, int64_t _sim, double _steady);
+
+  /// \brief Latest fit, with sim and real time in seconds.
+  /// \return False before the first full window.
+  public: bool Latest(RegressionFit &_fit) const;
+
+  public: void Draw();
+
+  protected: SlidingRegression regression;
+  protected: RegressionFit latest;
+  protected: bool full{false};
+
+  /// \brief Real and sim time of the previous sample in nanoseconds.
+  protected: int64_t lastReal{0};
+  protected: int64_t lastSim{0};
+  protected: mutable std::mutex dataMutex;
+
+  protected: Histogram slopes;
+  protected: Histogram residuals;
+  protected: IntervalHeatmap slopeIntervals;
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__LEAST_SQUARES_RTF_HH_
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "MappedFile.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdexcept>
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+MappedFile::~MappedFile()
+{
+  this->Close();
+}
+
+//////////////////////////////////////////////////
+void MappedFile::Open(const std::string &_path)
+{
+  this->Close();
+
+  int fd = ::open(_path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error{"failed to open " + _path};
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0)
+  {
+    ::close(fd);
+    throw std::runtime_error{"failed to stat " + _path};
+  }
+
+  if (st.st_size > 0)
+  {
+    void *mapped = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED)
+    {
+      ::close(fd);
+      throw std::runtime_error{"failed to map " + _path};
+    }
+    // The whole file is about to be parsed front to back. Advice values
+    // are not flags, each needs its own call.
+    ::madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+    ::madvise(mapped, st.st_size, MADV_WILLNEED);
+    this->data = mapped;
+    this->size = st.st_size;
+  }
+  ::close(fd);
+}
+
+//////////////////////////////////////////////////
+void MappedFile::Close()
+{
+  if (this->data)
+    ::munmap(this->data, this->size);
+  this->data = nullptr;
+  this->size = 0;
+}
+
+//////////////////////////////////////////////////
+const char *MappedFile::Data() const
+{
+  return static_cast<const char *>(this->data);
+}
+
+//////////////////////////////////////////////////
+size_t MappedFile::Size() const
+{
+  return this->size;
+}
+
+//////////////////////////////////////////////////
+MemoryStreamBuf::MemoryStreamBuf(const char *_data, size_t _size)
+{
+  // The get area is never written through, std::streambuf just wants char *.
+  char *begin = const_cast<char *>(_data);
+  this->setg(begin, begin, begin + _size);
+}
+
+//////////////////////////////////////////////////
+MemoryStreamBuf::pos_type MemoryStreamBuf::seekoff(off_type _off,
+    std::ios_base::seekdir _dir, std::ios_base::openmode _which)
+{
+  if (!(_which & std::ios_base::in))
+    return pos_type(off_type(-1));
+
+  off_type base = 0;
+  if (_dir == std::ios_base::cur)
+    base = this->gptr() - this->eback();
+  else if (_dir == std::ios_base::end)
+    base = this->egptr() - this->eback();
+
+  const off_type target = base + _off;
+  if (target < 0 || target > this->egptr() - this->eback())
+    return pos_type(off_type(-1));
+  this->setg(this->eback(), this->eback() + target, this->egptr());
+  return pos_type(target);
+}
+
+//////////////////////////////////////////////////
+MemoryStreamBuf::pos_type MemoryStreamBuf::seekpos(pos_type _pos,
+    std::ios_base::openmode _which)
+{
+  return this->seekoff(off_type(_pos), std::ios_base::beg, _which);
+}
+
+}  // namespace ign_imgui
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__MAPPED_FILE_HH_
+#define IGN_IMGUI__MAPPED_FILE_HH_
+
+#include <cstdlib>
+
+#include <streambuf>
+#include <string>
+
+namespace ign_imgui
+{
+
+/// \brief Read-only memory mapping of a whole file.
+class MappedFile
+{
+  public: MappedFile() = default;
+  public: ~MappedFile();
+
+  public: MappedFile(const MappedFile &) = delete;
+  public: MappedFile &operator=(const MappedFile &) = delete;
+
+  /// \throws std::runtime_error if the file cannot be opened or mapped.
+  public: void Open(const std::string &_path);
+  public: void Close();
+
+  public: const char *Data() const;
+  public: size_t Size() const;
+
+  protected: void *data{nullptr};
+  protected: size_t size{0};
+};
+
+/// \brief Stream buffer reading straight out of memory, so binary state in
+/// a MappedFile can be parsed with the usual FromBinary() functions and
+/// bulk reads become a single copy out of the page cache.
+class MemoryStreamBuf : public std::streambuf
+{
+  public: MemoryStreamBuf(const char *_data, size_t _size);
+
+  /// \brief Seeking lets readers check counts against the bytes left.
+  protected: pos_type seekoff(off_type _off, std::ios_base::seekdir _dir,
+      std::ios_base::openmode _which) override;
+  protected: pos_type seekpos(pos_type _pos,
+      std::ios_base::openmode _which) override;
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__MAPPED_FILE_HH_
@@ -0,0 +1,541 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "MetricRegistry.hh"
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+
+namespace
+{
+
+const std::string kLeLabel = "le";
+const std::string kQuantileLabel = "quantile";
+
+//////////////////////////////////////////////////
+/// \brief Prometheus metric and label names: [a-zA-Z_:][a-zA-Z0-9_:]*,
+/// without colons for labels.
+bool ValidName(const std::string &_name, bool _label)
+{
+  if (_name.empty())
+    return false;
+  for (size_t ii = 0; ii < _name.size(); ++ii)
+  {
+    const char c = _name[ii];
+    const bool alpha = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+      c == '_' || (!_label && c == ':');
+    if (!alpha && (ii == 0 || c < '0' || c > '9'))
+      return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+void AddAtomic(std::atomic<double> &_value, double _delta)
+{
+  double current = _value.load(std::memory_order_relaxed);
+  while (!_value.compare_exchange_weak(current, current + _delta,
+        std::memory_order_relaxed))
+  {
+  }
+}
+
+//////////////////////////////////////////////////
+uint64_t Mix(uint64_t _hash, uint64_t _value)
+{
+  uint64_t z = _hash + _value + 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+//////////////////////////////////////////////////
+/// \brief Shortest text that reads back as _value, so 0.9 stays "0.9".
+std::string FormatBound(double _value)
+{
+  std::string text;
+  for (int precision = 6;
+       precision <= std::numeric_limits<double>::max_digits10; ++precision)
+  {
+    std::ostringstream oss;
+    oss.precision(precision);
+    oss << _value;
+    text = oss.str();
+    if (std::strtod(text.c_str(), nullptr) == _value)
+      break;
+  }
+  return text;
+}
+
+//////////////////////////////////////////////////
+void WriteValue(std::ostream &_ost, double _value)
+{
+  if (std::isnan(_value))
+    _ost << "NaN";
+  else if (std::isinf(_value))
+    _ost << (_value > 0 ? "+Inf" : "-Inf");
+  else
+    _ost << _value;
+}
+
+//////////////////////////////////////////////////
+void WriteLabelValue(std::ostream &_ost, const std::string &_value)
+{
+  for (const char c : _value)
+  {
+    if (c == '\\')
+      _ost << "\\\\";
+    else if (c == '"')
+      _ost << "\\\"";
+    else if (c == '\n')
+      _ost << "\\n";
+    else
+      _ost << c;
+  }
+}
+
+//////////////////////////////////////////////////
+const char *TypeName(ign_imgui::MetricKind _kind)
+{
+  switch (_kind)
+  {
+    case ign_imgui::MetricKind::kCounter:
+      return "counter";
+    case ign_imgui::MetricKind::kGauge:
+      return "gauge";
+    case ign_imgui::MetricKind::kHistogram:
+      return "histogram";
+    case ign_imgui::MetricKind::kSketch:
+      return "summary";
+  }
+  return "untyped";
+}
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+constexpr size_t MetricRegistry::kDefaultMaxSeries;
+constexpr const char *MetricRegistry::kOverflowLabel;
+
+//////////////////////////////////////////////////
+void GaugeMetric::Add(double _delta)
+{
+  AddAtomic(this->value, _delta);
+}
+
+//////////////////////////////////////////////////
+HistogramMetric::HistogramMetric(const HistogramAxis &_axis)
+  : axis(_axis),
+    counts(new std::atomic<uint64_t>[_axis.NumBins() + 2])
+{
+  for (size_t ii = 0; ii < this->axis.NumBins() + 2; ++ii)
+    this->counts[ii].store(0, std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+void HistogramMetric::Observe(double _value)
+{
+  const float value = static_cast<float>(_value);
+  const int32_t index = this->axis.Index(value);
+  size_t slot;
+  if (index != HistogramAxis::kOutOfRange)
+    slot = static_cast<size_t>(index) + 1;
+  else if (value < this->axis.Min())
+    slot = 0;
+  else
+    slot = this->axis.NumBins() + 1;
+  this->counts[slot].fetch_add(1, std::memory_order_relaxed);
+  AddAtomic(this->sum, _value);
+}
+
+//////////////////////////////////////////////////
+void HistogramMetric::Cumulative(std::vector<uint64_t> &_counts) const
+{
+  const size_t numBins = this->axis.NumBins();
+  _counts.resize(numBins + 1);
+  uint64_t total = this->counts[0].load(std::memory_order_relaxed);
+  for (size_t ii = 0; ii < numBins; ++ii)
+  {
+    total += this->counts[ii + 1].load(std::memory_order_relaxed);
+    _counts[ii] = total;
+  }
+  _counts[numBins] =
+    total + this->counts[numBins + 1].load(std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+double HistogramMetric::Sum() const
+{
+  return this->sum.load(std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+SketchMetric::SketchMetric()
+{
+  this->distribution.SetBackend(
+      Distribution::MakeBackend(Distribution::Kind::kDDSketch));
+}
+
+//////////////////////////////////////////////////
+void SketchMetric::Observe(double _value)
+{
+  this->distribution.InsertData(_value);
+  AddAtomic(this->sum, _value);
+}
+
+//////////////////////////////////////////////////
+double SketchMetric::Sum() const
+{
+  return this->sum.load(std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+template<>
+void MetricFamily<CounterMetric>::CollectOne(const CounterMetric &_metric,
+    MetricSeries &_series,
+    const std::function<void(const MetricSeries &)> &_fn) const
+{
+  _series.kind = MetricKind::kCounter;
+  _series.name = &this->seriesNames[0];
+  _series.value = static_cast<double>(_metric.Value());
+  _fn(_series);
+}
+
+//////////////////////////////////////////////////
+template<>
+void MetricFamily<GaugeMetric>::CollectOne(const GaugeMetric &_metric,
+    MetricSeries &_series,
+    const std::function<void(const MetricSeries &)> &_fn) const
+{
+  _series.kind = MetricKind::kGauge;
+  _series.name = &this->seriesNames[0];
+  _series.value = _metric.Value();
+  _fn(_series);
+}
+
+//////////////////////////////////////////////////
+template<>
+void MetricFamily<HistogramMetric>::CollectOne(
+    const HistogramMetric &_metric, MetricSeries &_series,
+    const std::function<void(const MetricSeries &)> &_fn) const
+{
+  // Reused across series and collections, like the series itself.
+  static thread_local std::vector<uint64_t> cumulative;
+  _metric.Cumulative(cumulative);
+
+  _series.kind = MetricKind::kHistogram;
+  _series.name = &this->seriesNames[1];
+  _series.labels.emplace_back(&kLeLabel, nullptr);
+  for (size_t ii = 0; ii < cumulative.size(); ++ii)
+  {
+    _series.labels.back().second = &this->boundLabels[ii];
+    _series.value = static_cast<double>(cumulative[ii]);
+    _fn(_series);
+  }
+  _series.labels.pop_back();
+
+  _series.name = &this->seriesNames[2];
+  _series.value = _metric.Sum();
+  _fn(_series);
+  _series.name = &this->seriesNames[3];
+  _series.value = static_cast<double>(cumulative.back());
+  _fn(_series);
+}
+
+//////////////////////////////////////////////////
+template<>
+void MetricFamily<SketchMetric>::CollectOne(const SketchMetric &_metric,
+    MetricSeries &_series,
+    const std::function<void(const MetricSeries &)> &_fn) const
+{
+  const Distribution &data = _metric.Data();
+  const uint64_t count = data.Count();
+
+  _series.kind = MetricKind::kSketch;
+  _series.name = &this->seriesNames[0];
+  _series.labels.emplace_back(&kQuantileLabel, nullptr);
+  for (size_t ii = 0; ii < this->quantiles.size(); ++ii)
+  {
+    _series.labels.back().second = &this->boundLabels[ii];
+    _series.value = count > 0 ?
+      data.Quantile(this->quantiles[ii]) :
+      std::numeric_limits<double>::quiet_NaN();
+    _fn(_series);
+  }
+  _series.labels.pop_back();
+
+  _series.name = &this->seriesNames[1];
+  _series.value = _metric.Sum();
+  _fn(_series);
+  _series.name = &this->seriesNames[2];
+  _series.value = static_cast<double>(count);
+  _fn(_series);
+}
+
+//////////////////////////////////////////////////
+template<typename T>
+MetricFamily<T> &MetricRegistry::Register(const std::string &_name,
+    const std::string &_help, MetricKind _kind,
+    const std::vector<std::string> &_labels, size_t _maxSeries)
+{
+  if (!ValidName(_name, false))
+    throw std::runtime_error{"invalid metric name [" + _name + "]"};
+  for (const auto &label : _labels)
+  {
+    if (!ValidName(label, true) || label == kLeLabel ||
+        label == kQuantileLabel)
+    {
+      throw std::runtime_error{"invalid label name [" + label +
+        "] for metric [" + _name + "]"};
+    }
+  }
+  if (_maxSeries == 0)
+    throw std::runtime_error{"metric [" + _name + "] allows no series"};
+
+  for (const auto &family : this->families)
+  {
+    if (family->name != _name)
+      continue;
+    if (family->kind != _kind || family->labelNames != _labels)
+    {
+      throw std::runtime_error{"metric [" + _name +
+        "] is already registered with another type or labels"};
+    }
+    return static_cast<MetricFamily<T> &>(*family);
+  }
+
+  auto family = std::make_unique<MetricFamily<T>>();
+  family->registry = this;
+  family->name = _name;
+  family->help = _help;
+  family->kind = _kind;
+  family->labelNames = _labels;
+  family->maxSeries = _maxSeries;
+  family->seriesNames.push_back(_name);
+  MetricFamily<T> &result = *family;
+  this->families.push_back(std::move(family));
+  return result;
+}
+
+//////////////////////////////////////////////////
+MetricFamily<CounterMetric> &MetricRegistry::Counter(
+    const std::string &_name, const std::string &_help,
+    const std::vector<std::string> &_labels, size_t _maxSeries)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  auto &family = this->Register<CounterMetric>(_name, _help,
+      MetricKind::kCounter, _labels, _maxSeries);
+  if (!family.factory)
+    family.factory = [] { return std::make_unique<CounterMetric>(); };
+  return family;
+}
+
+//////////////////////////////////////////////////
+MetricFamily<GaugeMetric> &MetricRegistry::Gauge(
+    const std::string &_name, const std::string &_help,
+    const std::vector<std::string> &_labels, size_t _maxSeries)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  auto &family = this->Register<GaugeMetric>(_name, _help,
+      MetricKind::kGauge, _labels, _maxSeries);
+  if (!family.factory)
+    family.factory = [] { return std::make_unique<GaugeMetric>(); };
+  return family;
+}
+
+//////////////////////////////////////////////////
+MetricFamily<HistogramMetric> &MetricRegistry::Histogram(
+    const std::string &_name, const std::string &_help,
+    const std::vector<std::string> &_labels, const HistogramAxis &_axis,
+    size_t _maxSeries)
+{
+  if (_axis.NumBins() == 0)
+    throw std::runtime_error{"histogram [" + _name + "] has no bins"};
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  auto &family = this->Register<HistogramMetric>(_name, _help,
+      MetricKind::kHistogram, _labels, _maxSeries);
+  if (family.factory)
+    return family;
+
+  family.factory = [_axis] { return std::make_unique<HistogramMetric>(_axis); };
+  family.seriesNames.push_back(_name + "_bucket");
+  family.seriesNames.push_back(_name + "_sum");
+  family.seriesNames.push_back(_name + "_count");
+  // The first bucket also counts values below the axis.
+  for (size_t ii = 1; ii <= _axis.NumBins(); ++ii)
+    family.boundLabels.push_back(FormatBound(_axis.Edge(ii)));
+  family.boundLabels.push_back("+Inf");
+  return family;
+}
+
+//////////////////////////////////////////////////
+MetricFamily<SketchMetric> &MetricRegistry::Sketch(
+    const std::string &_name, const std::string &_help,
+    const std::vector<std::string> &_labels,
+    const std::vector<double> &_quantiles, size_t _maxSeries)
+{
+  for (const double q : _quantiles)
+  {
+    if (!(q >= 0.0 && q <= 1.0))
+      throw std::runtime_error{"quantiles of [" + _name + "] must be in [0, 1]"};
+  }
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  auto &family = this->Register<SketchMetric>(_name, _help,
+      MetricKind::kSketch, _labels, _maxSeries);
+  if (family.factory)
+    return family;
+
+  family.factory = [] { return std::make_unique<SketchMetric>(); };
+  family.seriesNames.push_back(_name + "_sum");
+  family.seriesNames.push_back(_name + "_count");
+  family.quantiles = _quantiles;
+  for (const double q : _quantiles)
+    family.boundLabels.push_back(FormatBound(q));
+  return family;
+}
+
+//////////////////////////////////////////////////
+void MetricRegistry::Collect(
+    const std::function<void(const MetricSeries &)> &_fn) const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  MetricSeries series;
+  for (const auto &family : this->families)
+    family->Collect(series, _fn);
+}
+
+//////////////////////////////////////////////////
+void MetricRegistry::ToText(std::ostream &_ost) const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  MetricSeries series;
+  for (const auto &family : this->families)
+  {
+    _ost << "# HELP " << family->name << ' ';
+    for (const char c : family->help)
+    {
+      if (c == '\\')
+        _ost << "\\\\";
+      else if (c == '\n')
+        _ost << "\\n";
+      else
+        _ost << c;
+    }
+    _ost << "\n# TYPE " << family->name << ' ' << TypeName(family->kind)
+         << '\n';
+
+    family->Collect(series, [&_ost](const MetricSeries &_series)
+    {
+      _ost << *_series.name;
+      if (!_series.labels.empty())
+      {
+        _ost << '{';
+        for (size_t ii = 0; ii < _series.labels.size(); ++ii)
+        {
+          if (ii > 0)
+            _ost << ',';
+          _ost << *_series.labels[ii].first << "=\"";
+          WriteLabelValue(_ost, *_series.labels[ii].second);
+          _ost << '"';
+        }
+        _ost << '}';
+      }
+      _ost << ' ';
+      WriteValue(_ost, _series.value);
+      _ost << '\n';
+    });
+  }
+}
+
+//////////////////////////////////////////////////
+size_t MetricRegistry::NumSeries() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->numSeries;
+}
+
+//////////////////////////////////////////////////
+std::vector<const MetricFamilyBase *> MetricRegistry::Families() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  std::vector<const MetricFamilyBase *> result;
+  result.reserve(this->families.size());
+  for (const auto &family : this->families)
+    result.push_back(family.get());
+  return result;
+}
+
+//////////////////////////////////////////////////
+LabelSet MetricRegistry::MakeLabels(const std::vector<std::string> &_values)
+{
+  LabelSet labels;
+  labels.values.reserve(_values.size());
+  uint64_t hash = _values.size();
+  for (const auto &value : _values)
+  {
+    const uint32_t id = this->Intern(value);
+    labels.values.push_back(id);
+    hash = Mix(hash, id);
+  }
+  labels.hash = hash;
+  return labels;
+}
+
+//////////////////////////////////////////////////
+bool MetricRegistry::FindLabels(const std::vector<std::string> &_values,
+    LabelSet &_labels) const
+{
+  _labels.values.clear();
+  _labels.values.reserve(_values.size());
+  uint64_t hash = _values.size();
+  for (const auto &value : _values)
+  {
+    auto found = this->stringIds.find(value);
+    if (found == this->stringIds.end())
+      return false;
+    _labels.values.push_back(found->second);
+    hash = Mix(hash, found->second);
+  }
+  _labels.hash = hash;
+  return true;
+}
+
+//////////////////////////////////////////////////
+uint32_t MetricRegistry::Intern(const std::string &_value)
+{
+  auto found = this->stringIds.find(_value);
+  if (found != this->stringIds.end())
+    return found->second;
+  const uint32_t id = static_cast<uint32_t>(this->strings.size());
+  this->strings.push_back(_value);
+  this->stringIds.emplace(this->strings.back(), id);
+  return id;
+}
+
+//////////////////////////////////////////////////
+const std::string &MetricRegistry::Interned(uint32_t _id) const
+{
+  return this->strings[_id];
+}
+
+}  // namespace ign_imgui
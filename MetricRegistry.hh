@@ -0,0 +1,386 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__METRIC_REGISTRY_HH_
+#define IGN_IMGUI__METRIC_REGISTRY_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Distribution.hh"
+#include "HistogramAxis.hh"
+
+namespace ign_imgui
+{
+
+class MetricRegistry;
+
+enum class MetricKind
+{
+  kCounter,
+  kGauge,
+  kHistogram,
+  kSketch
+};
+
+/// \brief Label values of one series as interned ids, in the order of the
+/// family's label names, hashed once when the set is built.
+struct LabelSet
+{
+  std::vector<uint32_t> values;
+  uint64_t hash{0};
+
+  bool operator==(const LabelSet &_other) const
+  {
+    return this->hash == _other.hash && this->values == _other.values;
+  }
+};
+
+struct LabelSetHash
+{
+  size_t operator()(const LabelSet &_labels) const
+  {
+    return static_cast<size_t>(_labels.hash);
+  }
+};
+
+/// \brief Monotonic count, lock-free.
+class CounterMetric
+{
+  public: void Add(uint64_t _count = 1)
+  {
+    this->value.fetch_add(_count, std::memory_order_relaxed);
+  }
+
+  public: uint64_t Value() const
+  {
+    return this->value.load(std::memory_order_relaxed);
+  }
+
+  protected: std::atomic<uint64_t> value{0};
+};
+
+/// \brief Value that goes up and down, lock-free.
+class GaugeMetric
+{
+  public: void Set(double _value)
+  {
+    this->value.store(_value, std::memory_order_relaxed);
+  }
+
+  public: void Add(double _delta);
+
+  public: double Value() const
+  {
+    return this->value.load(std::memory_order_relaxed);
+  }
+
+  protected: std::atomic<double> value{0.0};
+};
+
+/// \brief Counts per bin of a fixed axis, lock-free. Values below the axis
+/// count in the first bucket, values above only in the +Inf bucket.
+class HistogramMetric
+{
+  public: explicit HistogramMetric(const HistogramAxis &_axis);
+
+  public: void Observe(double _value);
+
+  /// \brief Cumulative counts per upper bin edge, then the total.
+  public: void Cumulative(std::vector<uint64_t> &_counts) const;
+  public: double Sum() const;
+
+  protected: HistogramAxis axis;
+
+  /// \brief Below the axis, one per bin, above the axis.
+  protected: std::unique_ptr<std::atomic<uint64_t>[]> counts;
+  protected: std::atomic<double> sum{0.0};
+};
+
+/// \brief Quantile sketch with bounded relative error, see DDSketchBackend.
+class SketchMetric
+{
+  public: SketchMetric();
+
+  public: void Observe(double _value);
+
+  public: const Distribution &Data() const { return this->distribution; }
+
+  /// \brief Exact sum, the sketch only keeps an approximate mean.
+  public: double Sum() const;
+
+  protected: Distribution distribution;
+  protected: std::atomic<double> sum{0.0};
+};
+
+/// \brief Series of a family, exported in one pass by
+/// MetricRegistry::Collect(). Strings point into the registry.
+struct MetricSeries
+{
+  MetricKind kind{MetricKind::kCounter};
+
+  /// \brief Family name plus a suffix such as _bucket for histograms.
+  const std::string *name{nullptr};
+
+  /// \brief Label names and values, including le and quantile labels.
+  std::vector<std::pair<const std::string *, const std::string *>> labels;
+  double value{0.0};
+};
+
+/// \brief Named metric with a fixed list of label names.
+class MetricFamilyBase
+{
+  public: virtual ~MetricFamilyBase() = default;
+
+  public: const std::string &Name() const { return this->name; }
+  public: const std::string &Help() const { return this->help; }
+  public: MetricKind Kind() const { return this->kind; }
+  public: const std::vector<std::string> &LabelNames() const
+  {
+    return this->labelNames;
+  }
+
+  /// \brief Lookups that got the overflow series because the family
+  /// already had its maximum number of series.
+  public: uint64_t Rejected() const
+  {
+    return this->rejected.load(std::memory_order_relaxed);
+  }
+
+  protected: friend class MetricRegistry;
+
+  /// \brief Emit every series, with the registry lock held.
+  protected: virtual void Collect(MetricSeries &_series,
+      const std::function<void(const MetricSeries &)> &_fn) const = 0;
+
+  protected: MetricRegistry *registry{nullptr};
+  protected: std::string name;
+  protected: std::string help;
+  protected: MetricKind kind{MetricKind::kCounter};
+  protected: std::vector<std::string> labelNames;
+  protected: size_t maxSeries{0};
+  protected: std::atomic<uint64_t> rejected{0};
+
+  /// \brief Series names: the family name, then for histograms _bucket,
+  /// _sum and _count, for sketches _sum and _count.
+  protected: std::vector<std::string> seriesNames;
+
+  /// \brief Formatted upper edges of a histogram, then "+Inf", or the
+  /// quantiles of a sketch.
+  protected: std::vector<std::string> boundLabels;
+  protected: std::vector<double> quantiles;
+};
+
+/// \brief Family of metrics of type T, one per label set.
+template<typename T>
+class MetricFamily : public MetricFamilyBase
+{
+  /// \brief Metric for the label values _values, in the order of
+  /// LabelNames(). The lookup hashes the values and interns those of new
+  /// series, so call it once and keep the pointer, which stays valid as
+  /// long as the registry. Beyond the family's maximum number of series
+  /// every new label set gets one shared series with all values "overflow".
+  /// \throws std::runtime_error if the number of values is wrong.
+  public: T *WithLabels(const std::vector<std::string> &_values);
+
+  protected: friend class MetricRegistry;
+
+  protected: void Collect(MetricSeries &_series,
+      const std::function<void(const MetricSeries &)> &_fn) const override;
+
+  protected: void CollectOne(const T &_metric, MetricSeries &_series,
+      const std::function<void(const MetricSeries &)> &_fn) const;
+
+  protected: std::function<std::unique_ptr<T>()> factory;
+  protected: std::unordered_map<LabelSet, std::unique_ptr<T>, LabelSetHash>
+    children;
+
+  /// \brief Children in the order they were created, for stable exports.
+  protected: std::vector<std::pair<LabelSet, const T *>> ordered;
+};
+
+/// \brief Labelled counters, gauges, histograms and sketches, exported
+/// together.
+///
+/// Registration and label lookups take a lock and may allocate, updating a
+/// metric through the pointer a lookup returned does neither. Label names
+/// and values are interned, so a series is identified by a few integers
+/// and a precomputed hash.
+class MetricRegistry
+{
+  public: static constexpr size_t kDefaultMaxSeries = 1000;
+
+  /// \brief Label value of the series past a family's limit.
+  public: static constexpr const char *kOverflowLabel = "overflow";
+
+  public: MetricRegistry() = default;
+  public: MetricRegistry(const MetricRegistry &) = delete;
+  public: MetricRegistry &operator=(const MetricRegistry &) = delete;
+
+  /// \brief Register a family, or get the one registered under _name.
+  /// \throws std::runtime_error if _name is registered with another kind
+  /// or other label names, or is no valid metric name.
+  public: MetricFamily<CounterMetric> &Counter(const std::string &_name,
+      const std::string &_help, const std::vector<std::string> &_labels,
+      size_t _maxSeries = kDefaultMaxSeries);
+
+  public: MetricFamily<GaugeMetric> &Gauge(const std::string &_name,
+      const std::string &_help, const std::vector<std::string> &_labels,
+      size_t _maxSeries = kDefaultMaxSeries);
+
+  public: MetricFamily<HistogramMetric> &Histogram(const std::string &_name,
+      const std::string &_help, const std::vector<std::string> &_labels,
+      const HistogramAxis &_axis, size_t _maxSeries = kDefaultMaxSeries);
+
+  /// \brief Sketches export as summaries with the quantiles _quantiles.
+  public: MetricFamily<SketchMetric> &Sketch(const std::string &_name,
+      const std::string &_help, const std::vector<std::string> &_labels,
+      const std::vector<double> &_quantiles = {0.5, 0.9, 0.99},
+      size_t _maxSeries = kDefaultMaxSeries);
+
+  /// \brief Call _fn for every exported value of every family, in
+  /// registration order. _fn runs with the registry locked.
+  public: void Collect(
+      const std::function<void(const MetricSeries &)> &_fn) const;
+
+  /// \brief Write everything in the Prometheus text exposition format.
+  public: void ToText(std::ostream &_ost) const;
+
+  /// \brief Label sets across all families.
+  public: size_t NumSeries() const;
+
+  /// \brief Families in registration order.
+  public: std::vector<const MetricFamilyBase *> Families() const;
+
+  protected: template<typename T> friend class MetricFamily;
+
+  /// \brief Find or add the family _name, with the lock held.
+  protected: template<typename T>
+  MetricFamily<T> &Register(const std::string &_name,
+      const std::string &_help, MetricKind _kind,
+      const std::vector<std::string> &_labels, size_t _maxSeries);
+
+  /// \brief Interned and hashed _values. Needs the lock.
+  protected: LabelSet MakeLabels(const std::vector<std::string> &_values);
+
+  /// \brief _values as MakeLabels() would return them, without interning.
+  /// Needs the lock.
+  /// \return False if a value isn't interned, so no series has them.
+  protected: bool FindLabels(const std::vector<std::string> &_values,
+      LabelSet &_labels) const;
+
+  /// \brief Id of _value, adding it if new. Needs the lock.
+  protected: uint32_t Intern(const std::string &_value);
+  protected: const std::string &Interned(uint32_t _id) const;
+
+  protected: mutable std::mutex mutex;
+  protected: std::vector<std::unique_ptr<MetricFamilyBase>> families;
+  protected: size_t numSeries{0};
+
+  /// \brief Deque elements never move, so the views stay valid.
+  protected: std::deque<std::string> strings;
+  protected: std::unordered_map<std::string_view, uint32_t> stringIds;
+};
+
+//////////////////////////////////////////////////
+template<typename T>
+T *MetricFamily<T>::WithLabels(const std::vector<std::string> &_values)
+{
+  if (_values.size() != this->labelNames.size())
+  {
+    throw std::runtime_error{"metric [" + this->name + "] takes " +
+      std::to_string(this->labelNames.size()) + " label values"};
+  }
+
+  std::lock_guard<std::mutex> lock(this->registry->mutex);
+  LabelSet labels;
+  if (this->registry->FindLabels(_values, labels))
+  {
+    auto found = this->children.find(labels);
+    if (found != this->children.end())
+      return found->second.get();
+  }
+
+  // The overflow series is the one allowed past the limit. Rejected values
+  // are never interned, so they can't grow the registry either.
+  if (this->children.size() >= this->maxSeries)
+  {
+    this->rejected.fetch_add(1, std::memory_order_relaxed);
+    labels = this->registry->MakeLabels(std::vector<std::string>(
+          _values.size(), MetricRegistry::kOverflowLabel));
+    auto found = this->children.find(labels);
+    if (found != this->children.end())
+      return found->second.get();
+  }
+  else
+  {
+    labels = this->registry->MakeLabels(_values);
+  }
+
+  auto metric = this->factory();
+  T *result = metric.get();
+  this->ordered.emplace_back(labels, result);
+  this->children.emplace(std::move(labels), std::move(metric));
+  ++this->registry->numSeries;
+  return result;
+}
+
+//////////////////////////////////////////////////
+template<typename T>
+void MetricFamily<T>::Collect(MetricSeries &_series,
+    const std::function<void(const MetricSeries &)> &_fn) const
+{
+  for (const auto &child : this->ordered)
+  {
+    _series.labels.clear();
+    for (size_t ii = 0; ii < this->labelNames.size(); ++ii)
+    {
+      _series.labels.emplace_back(&this->labelNames[ii],
+          &this->registry->Interned(child.first.values[ii]));
+    }
+    this->CollectOne(*child.second, _series, _fn);
+  }
+}
+
+template<> void MetricFamily<CounterMetric>::CollectOne(
+    const CounterMetric &, MetricSeries &,
+    const std::function<void(const MetricSeries &)> &) const;
+template<> void MetricFamily<GaugeMetric>::CollectOne(
+    const GaugeMetric &, MetricSeries &,
+    const std::function<void(const MetricSeries &)> &) const;
+template<> void MetricFamily<HistogramMetric>::CollectOne(
+    const HistogramMetric &, MetricSeries &,
+    const std::function<void(const MetricSeries &)> &) const;
+template<> void MetricFamily<SketchMetric>::CollectOne(
+    const SketchMetric &, MetricSeries &,
+    const std::function<void(const MetricSeries &)> &) const;
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__METRIC_REGISTRY_HH_
@@ -0,0 +1,367 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "BinaryUtils.hh"
+#include "Moments.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+/// \brief Independent accumulators per batch loop, so the reductions can be
+/// vectorised without reassociating floating point sums.
+const size_t kLanes = 4;
+
+/// \brief Values per batch merged into the running moments.
+const size_t kBatchSize = 1024;
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+Moments::Moments(const Moments &_other)
+{
+  *this = _other;
+}
+
+//////////////////////////////////////////////////
+Moments &Moments::operator=(const Moments &_other)
+{
+  if (&_other == this)
+    return *this;
+  std::lock(this->dataMutex, _other.dataMutex);
+  std::lock_guard<std::mutex> lock(this->dataMutex, std::adopt_lock);
+  std::lock_guard<std::mutex> otherLock(_other.dataMutex, std::adopt_lock);
+  this->count = _other.count;
+  this->mean = _other.mean;
+  this->m2 = _other.m2;
+  this->m3 = _other.m3;
+  this->m4 = _other.m4;
+  this->min = _other.min;
+  this->max = _other.max;
+  this->Publish();
+  return *this;
+}
+
+//////////////////////////////////////////////////
+void Moments::InsertData(double _data)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  const double n1 = static_cast<double>(this->count);
+  ++this->count;
+  const double n = static_cast<double>(this->count);
+  const double delta = _data - this->mean;
+  const double deltaN = delta / n;
+  const double deltaN2 = deltaN * deltaN;
+  const double term1 = delta * deltaN * n1;
+
+  this->mean += deltaN;
+  this->m4 += term1 * deltaN2 * (n * n - 3 * n + 3) +
+    6 * deltaN2 * this->m2 - 4 * deltaN * this->m3;
+  this->m3 += term1 * deltaN * (n - 2) - 3 * deltaN * this->m2;
+  this->m2 += term1;
+  this->min = std::min(this->min, _data);
+  this->max = std::max(this->max, _data);
+  this->Publish();
+}
+
+//////////////////////////////////////////////////
+void Moments::InsertData(const double *_data, size_t _count)
+{
+  for (size_t start = 0; start < _count; start += kBatchSize)
+  {
+    const double *data = _data + start;
+    const size_t size = std::min(kBatchSize, _count - start);
+    const size_t vectorSize = size - size % kLanes;
+
+    double sums[kLanes] = {0.0};
+    double mins[kLanes];
+    double maxs[kLanes];
+    std::fill_n(mins, kLanes, std::numeric_limits<double>::infinity());
+    std::fill_n(maxs, kLanes, -std::numeric_limits<double>::infinity());
+    for (size_t ii = 0; ii < vectorSize; ii += kLanes)
+    {
+      for (size_t ll = 0; ll < kLanes; ++ll)
+      {
+        sums[ll] += data[ii + ll];
+        mins[ll] = std::min(mins[ll], data[ii + ll]);
+        maxs[ll] = std::max(maxs[ll], data[ii + ll]);
+      }
+    }
+    double sum = 0.0;
+    double batchMin = std::numeric_limits<double>::infinity();
+    double batchMax = -std::numeric_limits<double>::infinity();
+    for (size_t ll = 0; ll < kLanes; ++ll)
+    {
+      sum += sums[ll];
+      batchMin = std::min(batchMin, mins[ll]);
+      batchMax = std::max(batchMax, maxs[ll]);
+    }
+    for (size_t ii = vectorSize; ii < size; ++ii)
+    {
+      sum += data[ii];
+      batchMin = std::min(batchMin, data[ii]);
+      batchMax = std::max(batchMax, data[ii]);
+    }
+    const double batchMean = sum / size;
+
+    double s2[kLanes] = {0.0};
+    double s3[kLanes] = {0.0};
+    double s4[kLanes] = {0.0};
+    for (size_t ii = 0; ii < vectorSize; ii += kLanes)
+    {
+      for (size_t ll = 0; ll < kLanes; ++ll)
+      {
+        const double d = data[ii + ll] - batchMean;
+        const double d2 = d * d;
+        s2[ll] += d2;
+        s3[ll] += d2 * d;
+        s4[ll] += d2 * d2;
+      }
+    }
+    double batchM2 = 0.0;
+    double batchM3 = 0.0;
+    double batchM4 = 0.0;
+    for (size_t ll = 0; ll < kLanes; ++ll)
+    {
+      batchM2 += s2[ll];
+      batchM3 += s3[ll];
+      batchM4 += s4[ll];
+    }
+    for (size_t ii = vectorSize; ii < size; ++ii)
+    {
+      const double d = data[ii] - batchMean;
+      const double d2 = d * d;
+      batchM2 += d2;
+      batchM3 += d2 * d;
+      batchM4 += d2 * d2;
+    }
+
+    std::lock_guard<std::mutex> lock(this->dataMutex);
+    this->MergeUnlocked(static_cast<double>(size), batchMean,
+        batchM2, batchM3, batchM4);
+    this->count += size;
+    this->min = std::min(this->min, batchMin);
+    this->max = std::max(this->max, batchMax);
+    this->Publish();
+  }
+}
+
+//////////////////////////////////////////////////
+void Moments::Merge(const Moments &_other)
+{
+  const Moments other(_other);
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->MergeUnlocked(static_cast<double>(other.count), other.mean,
+      other.m2, other.m3, other.m4);
+  this->count += other.count;
+  this->min = std::min(this->min, other.min);
+  this->max = std::max(this->max, other.max);
+  this->Publish();
+}
+
+//////////////////////////////////////////////////
+void Moments::Reset()
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->count = 0;
+  this->mean = 0.0;
+  this->m2 = 0.0;
+  this->m3 = 0.0;
+  this->m4 = 0.0;
+  this->min = std::numeric_limits<double>::infinity();
+  this->max = -std::numeric_limits<double>::infinity();
+  this->Publish();
+}
+
+//////////////////////////////////////////////////
+void Moments::SetSummary(uint64_t _count, double _mean, double _variance,
+                         double _skewness, double _kurtosis, double _min,
+                         double _max)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->count = _count;
+  this->mean = _mean;
+  this->m2 = _count > 1 ? _variance * (_count - 1) : 0.0;
+  this->m3 = _count > 1 ?
+    _skewness * std::pow(this->m2, 1.5) / std::sqrt(_count) : 0.0;
+  this->m4 = _count > 1 ?
+    (_kurtosis + 3.0) * this->m2 * this->m2 / _count : 0.0;
+  this->min = _count > 0 ? _min : std::numeric_limits<double>::infinity();
+  this->max = _count > 0 ? _max : -std::numeric_limits<double>::infinity();
+  this->Publish();
+}
+
+//////////////////////////////////////////////////
+uint64_t Moments::Count() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->count;
+}
+
+//////////////////////////////////////////////////
+double Moments::Mean() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->mean;
+}
+
+//////////////////////////////////////////////////
+double Moments::Min() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->count > 0 ? this->min : 0.0;
+}
+
+//////////////////////////////////////////////////
+double Moments::Max() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->count > 0 ? this->max : 0.0;
+}
+
+//////////////////////////////////////////////////
+double Moments::Variance() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  if (this->count < 2)
+    return 0.0;
+  return this->m2 / (this->count - 1);
+}
+
+//////////////////////////////////////////////////
+double Moments::Skewness() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  if (this->count < 2 || this->m2 <= 0.0)
+    return 0.0;
+  return std::sqrt(static_cast<double>(this->count)) * this->m3 /
+    std::pow(this->m2, 1.5);
+}
+
+//////////////////////////////////////////////////
+double Moments::Kurtosis() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  if (this->count < 2 || this->m2 <= 0.0)
+    return 0.0;
+  return this->count * this->m4 / (this->m2 * this->m2) - 3.0;
+}
+
+//////////////////////////////////////////////////
+void Moments::ToBinary(std::ostream & ost) const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  WriteBinary(ost, this->count);
+  WriteBinary(ost, this->mean);
+  WriteBinary(ost, this->m2);
+  WriteBinary(ost, this->m3);
+  WriteBinary(ost, this->m4);
+  WriteBinary(ost, this->min);
+  WriteBinary(ost, this->max);
+}
+
+//////////////////////////////////////////////////
+void Moments::FromBinary(std::istream & ist)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  ReadBinary(ist, this->count);
+  ReadBinary(ist, this->mean);
+  ReadBinary(ist, this->m2);
+  ReadBinary(ist, this->m3);
+  ReadBinary(ist, this->m4);
+  ReadBinary(ist, this->min);
+  ReadBinary(ist, this->max);
+  this->Publish();
+}
+
+//////////////////////////////////////////////////
+void Moments::AttachStorage(MomentsSlots *_slots, bool _adopt)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->storage = _slots;
+  if (!_adopt)
+  {
+    this->Publish();
+    return;
+  }
+
+  const auto &state =
+    _slots->slots[_slots->active.load(std::memory_order_acquire) & 1];
+  this->count = state.count;
+  this->mean = state.mean;
+  this->m2 = state.m2;
+  this->m3 = state.m3;
+  this->m4 = state.m4;
+  this->min = state.min;
+  this->max = state.max;
+}
+
+//////////////////////////////////////////////////
+void Moments::DetachStorage()
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->storage = nullptr;
+}
+
+//////////////////////////////////////////////////
+void Moments::Publish()
+{
+  if (!this->storage)
+    return;
+
+  const uint32_t next =
+    1 - (this->storage->active.load(std::memory_order_relaxed) & 1);
+  this->storage->slots[next] = {this->count, this->mean, this->m2, this->m3,
+    this->m4, this->min, this->max};
+  this->storage->active.store(next, std::memory_order_release);
+}
+
+//////////////////////////////////////////////////
+void Moments::MergeUnlocked(double _n, double _mean, double _m2,
+                            double _m3, double _m4)
+{
+  if (_n <= 0.0)
+    return;
+
+  const double na = static_cast<double>(this->count);
+  const double nb = _n;
+  const double n = na + nb;
+  const double delta = _mean - this->mean;
+  const double delta2 = delta * delta;
+  const double nanb = na * nb;
+
+  const double newM2 = this->m2 + _m2 + delta2 * nanb / n;
+  const double newM3 = this->m3 + _m3 +
+    delta * delta2 * nanb * (na - nb) / (n * n) +
+    3.0 * delta * (na * _m2 - nb * this->m2) / n;
+  const double newM4 = this->m4 + _m4 +
+    delta2 * delta2 * nanb * (na * na - nanb + nb * nb) / (n * n * n) +
+    6.0 * delta2 * (na * na * _m2 + nb * nb * this->m2) / (n * n) +
+    4.0 * delta * (na * _m3 - nb * this->m3) / n;
+
+  this->mean += delta * nb / n;
+  this->m2 = newM2;
+  this->m3 = newM3;
+  this->m4 = newM4;
+}
+
+}  // namespace ign_imgui
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__MOMENTS_HH_
+#define IGN_IMGUI__MOMENTS_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+#include <istream>
+#include <limits>
+#include <mutex>
+#include <ostream>
+
+namespace ign_imgui
+{
+
+/// \brief Shared memory copy of a Moments accumulator that survives the
+/// process being killed at any point.
+///
+/// Updates are written to the inactive slot and then published by flipping
+/// active, so the active slot always holds a complete state.
+struct MomentsSlots
+{
+  struct State
+  {
+    uint64_t count;
+    double mean;
+    double m2;
+    double m3;
+    double m4;
+    double min;
+    double max;
+  };
+
+  std::atomic<uint32_t> active;
+  State slots[2];
+};
+
+/// \brief One-pass accumulator of the first four central moments.
+///
+/// Updates and merges use Pébay's formulas for the central sums M2, M3 and
+/// M4, which stay accurate where raw power sums would cancel catastrophically.
+/// Merging two accumulators is exact: it gives the same moments as inserting
+/// both streams into one. The minimum and maximum are tracked alongside.
+class Moments
+{
+  public: Moments() = default;
+
+  public: Moments(const Moments &_other);
+  public: Moments &operator=(const Moments &_other);
+
+  public: void InsertData(double _data);
+
+  /// \brief Insert _count values. The batch moments are computed with
+  /// vectorisable two-pass loops and then merged in.
+  public: void InsertData(const double *_data, size_t _count);
+
+  public: void Merge(const Moments &_other);
+  public: void Reset();
+
+  /// \brief Replace the state with one having the given summary, e.g. as
+  /// read back from a CSV export. Inverts the definitions of Variance(),
+  /// Skewness() and Kurtosis().
+  public: void SetSummary(uint64_t _count, double _mean, double _variance,
+                          double _skewness, double _kurtosis, double _min,
+                          double _max);
+
+  public: uint64_t Count() const;
+  public: double Mean() const;
+
+  /// \brief Smallest value inserted, 0 if empty.
+  public: double Min() const;
+
+  /// \brief Largest value inserted, 0 if empty.
+  public: double Max() const;
+
+  /// \brief Unbiased sample variance, matching ignition::math::SignalStats.
+  public: double Variance() const;
+
+  /// \brief Sample skewness g1 = sqrt(n) M3 / M2^1.5, 0 if undefined.
+  public: double Skewness() const;
+
+  /// \brief Excess sample kurtosis g2 = n M4 / M2^2 - 3, 0 if undefined.
+  public: double Kurtosis() const;
+
+  public: void ToBinary(std::ostream & ost) const;
+
+  public: void FromBinary(std::istream & ist);
+
+  /// \brief Mirror every update into _slots, e.g. in a PersistentState.
+  /// With _adopt the state in _slots replaces the current one, otherwise
+  /// the current state is written to _slots.
+  public: void AttachStorage(MomentsSlots *_slots, bool _adopt);
+
+  /// \brief Stop mirroring, keeping the current state.
+  public: void DetachStorage();
+
+  /// \brief Write the state to the attached slots, if any.
+  protected: void Publish();
+
+  protected: void MergeUnlocked(double _n, double _mean, double _m2,
+                                double _m3, double _m4);
+
+  protected: uint64_t count{0};
+  protected: double mean{0.0};
+  protected: double m2{0.0};
+  protected: double m3{0.0};
+  protected: double m4{0.0};
+  protected: double min{std::numeric_limits<double>::infinity()};
+  protected: double max{-std::numeric_limits<double>::infinity()};
+  protected: MomentsSlots *storage{nullptr};
+  protected: mutable std::mutex dataMutex;
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__MOMENTS_HH_
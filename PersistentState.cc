@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "PersistentState.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+
+const char kPersistentStateMagic[8] =
+  {'I', 'G', 'N', 'P', 'S', 'T', 'A', '\0'};
+const uint32_t kPersistentStateVersion = 1;
+
+/// \brief Moments and counts each start on their own cache lines.
+const size_t kMomentsOffset = 128;
+const size_t kCountsOffset = 256;
+
+static_assert(sizeof(ign_imgui::PersistentStateHeader) <= kMomentsOffset,
+    "persistent state header does not fit before the moments");
+static_assert(kMomentsOffset + sizeof(ign_imgui::MomentsSlots) <=
+    kCountsOffset, "moments do not fit before the counts");
+static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+    std::atomic<uint64_t>::is_always_lock_free,
+    "persistent state atomics must be lock-free to live in shared memory");
+
+//////////////////////////////////////////////////
+size_t FileSize(size_t _numBins)
+{
+  return kCountsOffset + (_numBins + 2) * sizeof(uint64_t);
+}
+
+//////////////////////////////////////////////////
+ign_imgui::PersistentStateLayout ExpectedLayout(
+    const ign_imgui::HistogramAxis &_axis)
+{
+  ign_imgui::PersistentStateLayout layout;
+  std::memset(&layout, 0, sizeof(layout));
+  std::memcpy(layout.magic, kPersistentStateMagic,
+      sizeof(kPersistentStateMagic));
+  layout.version = kPersistentStateVersion;
+  layout.headerSize = sizeof(ign_imgui::PersistentStateHeader);
+  layout.numBins = _axis.NumBins();
+  layout.min = _axis.Min();
+  layout.max = _axis.Max();
+  layout.momentsOffset = kMomentsOffset;
+  layout.countsOffset = kCountsOffset;
+  layout.fileSize = FileSize(_axis.NumBins());
+  return layout;
+}
+
+//////////////////////////////////////////////////
+/// \brief 32-bit FNV-1a over the layout fields.
+uint32_t Checksum(const ign_imgui::PersistentStateLayout &_layout)
+{
+  const auto *bytes = reinterpret_cast<const unsigned char *>(&_layout);
+  uint32_t hash = 2166136261u;
+  for (size_t ii = 0; ii < sizeof(_layout); ++ii)
+  {
+    hash ^= bytes[ii];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+PersistentState::~PersistentState()
+{
+  this->Close();
+}
+
+//////////////////////////////////////////////////
+void PersistentState::Open(const std::string &_path,
+    const HistogramAxis &_axis)
+{
+  this->Close();
+
+  int fd = ::open(_path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0)
+    throw std::runtime_error{"failed to open persistent state file " + _path};
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0)
+  {
+    ::close(fd);
+    throw std::runtime_error{"failed to open persistent state file " + _path};
+  }
+
+  // Only an empty file is initialised, anything else must validate so that
+  // a mistyped path never clobbers data.
+  const PersistentStateLayout expected = ExpectedLayout(_axis);
+  const bool create = st.st_size == 0;
+  if (create && ::ftruncate(fd, expected.fileSize) != 0)
+  {
+    ::close(fd);
+    throw std::runtime_error{"failed to resize persistent state file " +
+      _path};
+  }
+  if (!create && static_cast<size_t>(st.st_size) < kCountsOffset)
+  {
+    ::close(fd);
+    throw std::runtime_error{"not a persistent state file " + _path};
+  }
+
+  const size_t mappedSize = create ? expected.fileSize : st.st_size;
+  void *mapped = ::mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE,
+      MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED)
+    throw std::runtime_error{"failed to map persistent state file " + _path};
+
+  this->data = mapped;
+  this->size = mappedSize;
+  this->header = static_cast<PersistentStateHeader *>(mapped);
+
+  if (create)
+  {
+    // The checksum is written last, a file torn during creation fails it.
+    this->header->layout = expected;
+    this->header->clean.store(1, std::memory_order_relaxed);
+    this->header->opens.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    this->header->checksum = Checksum(expected);
+  }
+  else
+  {
+    const PersistentStateLayout &layout = this->header->layout;
+    std::string error;
+    if (std::memcmp(layout.magic, kPersistentStateMagic,
+          sizeof(kPersistentStateMagic)) != 0)
+    {
+      error = "not a persistent state file ";
+    }
+    else if (layout.version != kPersistentStateVersion)
+    {
+      error = "unsupported persistent state file version ";
+    }
+    else if (this->header->checksum != Checksum(layout))
+    {
+      error = "corrupt persistent state file header ";
+    }
+    else if (std::memcmp(&layout, &expected, sizeof(layout)) != 0 ||
+        layout.fileSize != this->size)
+    {
+      error = "persistent state file has a different layout ";
+    }
+
+    if (!error.empty())
+    {
+      ::munmap(this->data, this->size);
+      this->data = nullptr;
+      this->size = 0;
+      this->header = nullptr;
+      throw std::runtime_error{error + _path};
+    }
+  }
+
+  this->created = create;
+  this->recovered = this->header->clean.exchange(0) == 0;
+  this->header->opens.fetch_add(1);
+}
+
+//////////////////////////////////////////////////
+void PersistentState::Close()
+{
+  if (this->data)
+  {
+    this->header->clean.store(1, std::memory_order_release);
+    ::msync(this->data, this->size, MS_ASYNC);
+    ::munmap(this->data, this->size);
+  }
+  this->data = nullptr;
+  this->size = 0;
+  this->header = nullptr;
+  this->created = false;
+  this->recovered = false;
+}
+
+//////////////////////////////////////////////////
+bool PersistentState::IsOpen() const
+{
+  return this->data != nullptr;
+}
+
+//////////////////////////////////////////////////
+bool PersistentState::Created() const
+{
+  return this->created;
+}
+
+//////////////////////////////////////////////////
+bool PersistentState::Recovered() const
+{
+  return this->recovered;
+}
+
+//////////////////////////////////////////////////
+uint64_t *PersistentState::Counts() const
+{
+  return this->data ? reinterpret_cast<uint64_t *>(
+      static_cast<char *>(this->data) + kCountsOffset) : nullptr;
+}
+
+//////////////////////////////////////////////////
+size_t PersistentState::NumBins() const
+{
+  return this->header ? this->header->layout.numBins : 0;
+}
+
+//////////////////////////////////////////////////
+MomentsSlots *PersistentState::Moments() const
+{
+  return this->data ? reinterpret_cast<MomentsSlots *>(
+      static_cast<char *>(this->data) + kMomentsOffset) : nullptr;
+}
+
+//////////////////////////////////////////////////
+void PersistentState::Sync()
+{
+  if (this->data)
+    ::msync(this->data, this->size, MS_ASYNC);
+}
+
+}  // namespace ign_imgui
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__PERSISTENT_STATE_HH_
+#define IGN_IMGUI__PERSISTENT_STATE_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+#include <string>
+
+#include "HistogramAxis.hh"
+#include "Moments.hh"
+
+namespace ign_imgui
+{
+
+/// \brief Fields describing where everything lives in a persistent state
+/// file. Covered by the header checksum and never changed after creation.
+struct PersistentStateLayout
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t headerSize;
+  uint64_t numBins;
+  float min;
+  float max;
+  uint64_t momentsOffset;
+  uint64_t countsOffset;
+  uint64_t fileSize;
+};
+
+/// \brief On-disk layout of a persistent state file header.
+struct PersistentStateHeader
+{
+  PersistentStateLayout layout;
+  uint32_t checksum;
+  /// \brief 0 while a process has the file open, 1 after a clean Close().
+  std::atomic<uint32_t> clean;
+  /// \brief Number of times the file was opened.
+  std::atomic<uint64_t> opens;
+};
+
+/// \brief Live histogram counts and moments kept in a shared file mapping.
+///
+/// The accumulators are attached to the mapped memory and keep updating it
+/// with plain stores, so inserting costs the same as with heap storage and
+/// the kernel writes the pages back even if the process is killed. Counts
+/// are updated in place, a kill loses at most the sample being inserted.
+/// Moments are double buffered, see MomentsSlots.
+class PersistentState
+{
+  public: PersistentState() = default;
+  public: ~PersistentState();
+
+  public: PersistentState(const PersistentState &) = delete;
+  public: PersistentState &operator=(const PersistentState &) = delete;
+
+  /// \brief Create the file, or reopen it if it holds a histogram with the
+  /// bins of _axis.
+  /// \throws std::runtime_error if the file cannot be mapped, is not a
+  /// persistent state file, fails its checksum or has another layout. The
+  /// file is left untouched in that case.
+  public: void Open(const std::string &_path, const HistogramAxis &_axis);
+
+  /// \brief Mark the file as cleanly closed and unmap it. Accumulators must
+  /// be detached first.
+  public: void Close();
+  public: bool IsOpen() const;
+
+  /// \brief True if Open() created the file, i.e. it holds no data yet.
+  public: bool Created() const;
+
+  /// \brief True if the previous process using the file did not close it,
+  /// e.g. because it crashed.
+  public: bool Recovered() const;
+
+  /// \brief Underflow, bins and overflow counts, NumBins() + 2 entries.
+  public: uint64_t *Counts() const;
+  public: size_t NumBins() const;
+
+  public: MomentsSlots *Moments() const;
+
+  /// \brief Schedule write-back of dirty pages, for durability across
+  /// host crashes. Not needed to survive a process crash.
+  public: void Sync();
+
+  protected: void *data{nullptr};
+  protected: size_t size{0};
+  protected: PersistentStateHeader *header{nullptr};
+  protected: bool created{false};
+  protected: bool recovered{false};
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__PERSISTENT_STATE_HH_
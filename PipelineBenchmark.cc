@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ArrowExport.hh"
+#include "ClockSample.hh"
+#include "ClockSource.hh"
+#include "Distribution.hh"
+#include "IngestPipeline.hh"
+#include "IngestQueue.hh"
+#include "MetricRegistry.hh"
+#include "RemoteWrite.hh"
+#include "RingFile.hh"
+
+// Feeds a FakeClockSource through the same steps main.cc takes for every
+// /clock message, without ign-transport: converting the message, the
+// ingest queue, and the IngestPipeline main.cc uses. First synchronously,
+// adding one step at a time so every line is the cost of our code up to
+// that step, then from the source's thread at fixed rates with a consumer
+// thread draining, as in main.cc.
+
+namespace
+{
+
+const size_t kMessages = 1000000;
+const size_t kInjectBatch = 256;
+const double kStep = 0.001;
+const double kJitter = 0.05;
+const uint32_t kSeed = 1;
+const double kRates[] = {1e4, 1e5, 1e6};
+const double kRateSeconds = 2.0;
+const uint64_t kHistorySize = 1u << 20;
+const char *kFilePrefix = "pipeline_benchmark";
+
+/// \brief Nothing listens there, pushes only queue and get dropped.
+const char *kRemoteWriteUrl = "http://127.0.0.1:1/api/v1/write";
+
+using Clock = std::chrono::steady_clock;
+
+enum class Stage
+{
+  kDeliver,
+  kEnqueue,
+  kRtf,
+  kAccumulate,
+  kOutputs
+};
+
+const char *StageName(Stage _stage)
+{
+  switch (_stage)
+  {
+    case Stage::kDeliver:
+      return "deliver";
+    case Stage::kEnqueue:
+      return "+ convert, enqueue, drain";
+    case Stage::kRtf:
+      return "+ RTF step";
+    case Stage::kAccumulate:
+      return "+ accumulators";
+    case Stage::kOutputs:
+      return "+ history, Arrow, remote write";
+  }
+  return "";
+}
+
+/// \brief What the pipeline feeds in main.cc without --lazy, set up the
+/// way main.cc does by default.
+struct Sinks
+{
+  explicit Sinks(const ign_imgui::Distribution &_baseline)
+  {
+    this->distribution.SetBackend(ign_imgui::Distribution::MakeBackend(
+          ign_imgui::Distribution::Kind::kDense));
+    ign_imgui::HistogramAxis axis;
+    axis.Set(200, 0.0f, 2.0f, ign_imgui::HistogramAxis::Scale::kUniform);
+    this->distribution.SetDisplayAxis(axis);
+    this->intervals.SetNumBins(200);
+    this->intervals.SetRange(0.0f, 2.0f);
+    this->intervals.SetInterval(10.0);
+
+    ign_imgui::HistogramAxis xAxis;
+    xAxis.Set(100, 1e-5f, 1.0f, ign_imgui::HistogramAxis::Scale::kLog);
+    ign_imgui::HistogramAxis yAxis;
+    yAxis.Set(100, 0.0f, 2.0f, ign_imgui::HistogramAxis::Scale::kUniform);
+    this->hist2d.SetAxes(xAxis, yAxis);
+
+    this->correlation.SetPeriod(0.1);
+    std::vector<int> lags;
+    for (int lag = -20; lag <= 20; ++lag)
+      lags.push_back(lag);
+    this->correlation.SetLags(lags);
+    this->msgSeries = this->correlation.AddSeries("msgs",
+        ign_imgui::LaggedCorrelation::Aggregation::kSum);
+
+    this->drift.SetBaseline(_baseline);
+
+    ign_imgui::HistogramAxis metricAxis;
+    metricAxis.Set(40, 0.0f, 2.0f,
+        ign_imgui::HistogramAxis::Scale::kUniform);
+    this->rtfMetric = this->metrics.Histogram("ign_imgui_rtf", "RTF.",
+        {"source"}, metricAxis).WithLabels({"fake"});
+  }
+
+  ~Sinks()
+  {
+    if (this->remoteWrite.Running())
+      this->remoteWrite.Stop();
+    if (this->arrow.IsOpen())
+    {
+      this->arrow.Close();
+      for (const char *suffix : {".samples.arrow", ".stats.arrow"})
+        std::remove((std::string(kFilePrefix) + suffix).c_str());
+    }
+    if (this->history.IsOpen())
+    {
+      this->history.Close();
+      std::remove((std::string(kFilePrefix) + ".ring").c_str());
+    }
+  }
+
+  /// \brief Sinks of every stage up to _stage, opening the outputs.
+  ign_imgui::IngestSinks For(Stage _stage)
+  {
+    ign_imgui::IngestSinks sinks;
+    if (_stage < Stage::kAccumulate)
+      return sinks;
+    sinks.moments = &this->moments;
+    sinks.distribution = &this->distribution;
+    sinks.intervals = &this->intervals;
+    sinks.reservoir = &this->reservoir;
+    sinks.hist2d = &this->hist2d;
+    sinks.lsqRtf = &this->lsqRtf;
+    sinks.anomalies = &this->anomalies;
+    sinks.drift = &this->drift;
+    sinks.rtfMetric = this->rtfMetric;
+    sinks.correlation = &this->correlation;
+    sinks.msgSeries = this->msgSeries;
+    if (_stage < Stage::kOutputs)
+      return sinks;
+
+    this->history.Open(std::string(kFilePrefix) + ".ring", kHistorySize);
+    this->arrow.Open(kFilePrefix);
+    this->remoteWrite.SetPeriod(0.01);
+    this->remoteWrite.Start(kRemoteWriteUrl, nullptr);
+    sinks.history = &this->history;
+    sinks.arrow = &this->arrow;
+    sinks.remoteWrite = &this->remoteWrite;
+    return sinks;
+  }
+
+  ign_imgui::Moments moments;
+  ign_imgui::Distribution distribution;
+  ign_imgui::IntervalHeatmap intervals;
+  ign_imgui::Reservoir reservoir;
+  ign_imgui::Histogram2D hist2d;
+  ign_imgui::LeastSquaresRtf lsqRtf;
+  ign_imgui::AnomalyDetector anomalies;
+  ign_imgui::DriftMonitor drift;
+  ign_imgui::MetricRegistry metrics;
+  ign_imgui::HistogramMetric *rtfMetric{nullptr};
+  ign_imgui::LaggedCorrelation correlation;
+  size_t msgSeries{0};
+  ign_imgui::RingFileWriter history;
+  ign_imgui::ArrowExport arrow;
+  ign_imgui::RemoteWriteExporter remoteWrite;
+};
+
+//////////////////////////////////////////////////
+/// \brief Steady time in seconds, as SteadySeconds() in main.cc.
+double SteadySeconds()
+{
+  return std::chrono::duration<double>(Clock::now().time_since_epoch())
+    .count();
+}
+
+//////////////////////////////////////////////////
+void RunSynchronous(Stage _stage,
+    const std::vector<ignition::msgs::Clock> &_messages,
+    const ign_imgui::Distribution &_baseline)
+{
+  auto sinks = std::make_unique<Sinks>(_baseline);
+  ign_imgui::IngestPipeline pipeline(sinks->For(_stage));
+  ign_imgui::IngestQueue<ign_imgui::ClockSample> queue(kInjectBatch);
+  uint64_t delivered = 0;
+
+  ign_imgui::FakeClockSource source;
+  source.SetMessages(_messages);
+  source.Start([&](const ignition::msgs::Clock &_msg)
+  {
+    ++delivered;
+    if (_stage != Stage::kDeliver)
+      queue.Push(ign_imgui::ToClockSample(_msg, SteadySeconds()));
+  });
+
+  auto consume = [&](const ign_imgui::ClockSample &_sample)
+  {
+    if (_stage != Stage::kEnqueue)
+      pipeline.Insert(_sample);
+  };
+
+  // Arrow batches are written in line here, main.cc writes them from its
+  // main loop.
+  const auto start = Clock::now();
+  while (source.Inject(kInjectBatch) > 0)
+  {
+    queue.Drain(consume);
+    if (_stage == Stage::kOutputs)
+      sinks->arrow.WriteSamples();
+  }
+  const double seconds =
+    std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::printf("%-32s %8.1f ns/msg", StageName(_stage),
+      seconds * 1e9 / static_cast<double>(delivered));
+  if (_stage >= Stage::kAccumulate)
+    std::printf("  mean RTF %.9f", sinks->moments.Mean());
+  std::printf("\n");
+}
+
+//////////////////////////////////////////////////
+void RunAtRate(double _rate,
+    const std::vector<ignition::msgs::Clock> &_messages,
+    const ign_imgui::Distribution &_baseline)
+{
+  auto sinks = std::make_unique<Sinks>(_baseline);
+  ign_imgui::IngestPipeline pipeline(sinks->For(Stage::kAccumulate));
+  ign_imgui::IngestQueue<ign_imgui::ClockSample> queue(4096);
+  std::atomic<bool> running{true};
+  uint64_t processed = 0;
+
+  std::thread consumer([&]()
+  {
+    while (true)
+    {
+      const bool wasRunning = running;
+      const size_t count = queue.Drain(
+          [&](const ign_imgui::ClockSample &_sample)
+          {
+            pipeline.Insert(_sample);
+          });
+      processed += count;
+      if (!wasRunning && count == 0)
+        break;
+      if (count == 0)
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+  });
+
+  ign_imgui::FakeClockSource source;
+  source.SetMessages(_messages);
+  source.SetLoop(true);
+  source.SetRate(_rate);
+  source.Start([&](const ignition::msgs::Clock &_msg)
+  {
+    queue.Push(ign_imgui::ToClockSample(_msg, SteadySeconds()));
+  });
+  std::this_thread::sleep_for(std::chrono::duration<double>(kRateSeconds));
+  source.Stop();
+  running = false;
+  consumer.join();
+
+  const auto stats = queue.Stats();
+  std::printf("%9.0f msg/s: %9.0f delivered/s, %llu processed, "
+      "%llu dropped\n", _rate,
+      source.Delivered() / kRateSeconds,
+      static_cast<unsigned long long>(processed),
+      static_cast<unsigned long long>(stats.dropped + stats.overflowed));
+}
+
+}  // namespace
+
+//////////////////////////////////////////////////
+int main()
+{
+  const auto messages = ign_imgui::FakeClockSource::MakeSequence(
+      kMessages, kStep, 1.0, kJitter, kSeed);
+
+  // The drift monitor compares against the RTF of the same sequence.
+  ign_imgui::Distribution baseline;
+  {
+    ign_imgui::IngestSinks sinks;
+    sinks.distribution = &baseline;
+    ign_imgui::IngestPipeline pipeline(sinks);
+    for (const auto &msg : messages)
+      pipeline.Insert(ign_imgui::ToClockSample(msg, 0.0));
+  }
+
+  std::printf("%zu messages, injected synchronously %zu at a time\n",
+      kMessages, kInjectBatch);
+  for (const Stage stage : {Stage::kDeliver, Stage::kEnqueue, Stage::kRtf,
+                            Stage::kAccumulate, Stage::kOutputs})
+  {
+    RunSynchronous(stage, messages, baseline);
+  }
+
+  std::printf("\nfrom the source thread for %.0f s\n", kRateSeconds);
+  for (const double rate : kRates)
+    RunAtRate(rate, messages, baseline);
+  return 0;
+}
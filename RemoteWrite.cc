@@ -0,0 +1,617 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "RemoteWrite.hh"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include "AllocTracker.hh"
+#include "Snappy.hh"
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+/// \brief Send and receive timeout, a receiver that hangs is retried.
+const int kSocketTimeoutSeconds = 5;
+const std::chrono::milliseconds kMinBackoff{500};
+const std::chrono::milliseconds kMaxBackoff{30000};
+
+/// \brief Largest response header accepted.
+const size_t kMaxResponseHeader = 16 << 10;
+
+//////////////////////////////////////////////////
+size_t VarintSize(uint64_t _value)
+{
+  size_t size = 1;
+  while (_value >= 0x80)
+  {
+    _value >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+//////////////////////////////////////////////////
+void PutVarint(std::string &_out, uint64_t _value)
+{
+  while (_value >= 0x80)
+  {
+    _out.push_back(static_cast<char>(_value | 0x80));
+    _value >>= 7;
+  }
+  _out.push_back(static_cast<char>(_value));
+}
+
+//////////////////////////////////////////////////
+/// \brief Size of a length-delimited field with a one byte tag.
+size_t FieldSize(size_t _size)
+{
+  return 1 + VarintSize(_size) + _size;
+}
+
+//////////////////////////////////////////////////
+void PutString(std::string &_out, char _tag, const std::string &_value)
+{
+  _out.push_back(_tag);
+  PutVarint(_out, _value.size());
+  _out.append(_value);
+}
+
+//////////////////////////////////////////////////
+size_t LabelSize(const std::pair<std::string, std::string> &_label)
+{
+  return FieldSize(_label.first.size()) + FieldSize(_label.second.size());
+}
+
+//////////////////////////////////////////////////
+size_t SampleSize(const ign_imgui::RemoteWriteSample &_sample)
+{
+  return 1 + sizeof(double) + 1 +
+    VarintSize(static_cast<uint64_t>(_sample.first));
+}
+
+//////////////////////////////////////////////////
+int64_t WallMilliseconds()
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+//////////////////////////////////////////////////
+bool SendAll(int _fd, const char *_data, size_t _size)
+{
+  while (_size > 0)
+  {
+    const ssize_t sent = send(_fd, _data, _size, MSG_NOSIGNAL);
+    if (sent <= 0)
+      return false;
+    _data += sent;
+    _size -= static_cast<size_t>(sent);
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Value of header _name in the header block _header, lower case
+/// names only, or an empty string.
+std::string HeaderValue(const std::string &_header, const char *_name)
+{
+  std::string lower(_header);
+  std::transform(lower.begin(), lower.end(), lower.begin(),
+      [](unsigned char _c) { return static_cast<char>(std::tolower(_c)); });
+  const std::string key = std::string("\r\n") + _name + ":";
+  const auto start = lower.find(key);
+  if (start == std::string::npos)
+    return "";
+  const auto end = lower.find("\r\n", start + key.size());
+  std::string value = lower.substr(start + key.size(),
+      end - start - key.size());
+  value.erase(0, value.find_first_not_of(" \t"));
+  value.erase(value.find_last_not_of(" \t") + 1);
+  return value;
+}
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+constexpr size_t RemoteWriteExporter::kDefaultMaxQueuedBytes;
+constexpr size_t RemoteWriteExporter::kMaxSamplesPerRequest;
+constexpr size_t RemoteWriteExporter::kSampleQueueCapacity;
+
+//////////////////////////////////////////////////
+void EncodeWriteRequest(const RemoteWriteSeries *_series, size_t _count,
+    std::string &_out)
+{
+  // Sizes are computed up front so every message is written in place.
+  _out.clear();
+  for (size_t ii = 0; ii < _count; ++ii)
+  {
+    const RemoteWriteSeries &series = _series[ii];
+    size_t size = 0;
+    for (const auto &label : *series.labels)
+      size += FieldSize(LabelSize(label));
+    for (size_t jj = 0; jj < series.count; ++jj)
+      size += FieldSize(SampleSize(series.samples[jj]));
+
+    // WriteRequest.timeseries = 1
+    _out.push_back(0x0a);
+    PutVarint(_out, size);
+    for (const auto &label : *series.labels)
+    {
+      // TimeSeries.labels = 1, Label.name = 1, Label.value = 2
+      _out.push_back(0x0a);
+      PutVarint(_out, LabelSize(label));
+      PutString(_out, 0x0a, label.first);
+      PutString(_out, 0x12, label.second);
+    }
+    for (size_t jj = 0; jj < series.count; ++jj)
+    {
+      // TimeSeries.samples = 2, Sample.value = 1, Sample.timestamp = 2
+      const RemoteWriteSample &sample = series.samples[jj];
+      _out.push_back(0x12);
+      PutVarint(_out, SampleSize(sample));
+      _out.push_back(0x09);
+      uint64_t bits;
+      std::memcpy(&bits, &sample.second, sizeof(bits));
+      for (int kk = 0; kk < 8; ++kk)
+        _out.push_back(static_cast<char>(bits >> (8 * kk)));
+      _out.push_back(0x10);
+      PutVarint(_out, static_cast<uint64_t>(sample.first));
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+RemoteWriteExporter::RemoteWriteExporter()
+  : samples(kSampleQueueCapacity)
+{
+}
+
+//////////////////////////////////////////////////
+RemoteWriteExporter::~RemoteWriteExporter()
+{
+  this->Stop();
+}
+
+//////////////////////////////////////////////////
+void RemoteWriteExporter::SetPeriod(double _seconds)
+{
+  if (!(_seconds > 0.0))
+    throw std::runtime_error{"remote write period must be positive"};
+  this->period = _seconds;
+}
+
+//////////////////////////////////////////////////
+void RemoteWriteExporter::SetMaxQueuedBytes(size_t _bytes)
+{
+  this->maxQueuedBytes = _bytes;
+}
+
+//////////////////////////////////////////////////
+size_t RemoteWriteExporter::MaxQueuedBytes() const
+{
+  return this->maxQueuedBytes;
+}
+
+//////////////////////////////////////////////////
+void RemoteWriteExporter::SetSampleSeries(const std::string &_name,
+    const RemoteWriteLabels &_labels)
+{
+  this->sampleName = _name;
+  this->sampleLabels = _labels;
+  this->sampleLabels.emplace_back("__name__", _name);
+  std::sort(this->sampleLabels.begin(), this->sampleLabels.end());
+}
+
+//////////////////////////////////////////////////
+void RemoteWriteExporter::Start(const std::string &_url,
+    const MetricRegistry *_registry)
+{
+  this->Stop();
+
+  const std::string scheme = "http://";
+  if (_url.compare(0, scheme.size(), scheme) != 0)
+  {
+    throw std::runtime_error{"invalid remote write URL [" + _url +
+      "], expected http://HOST[:PORT]/PATH"};
+  }
+  const auto slash = _url.find('/', scheme.size());
+  const std::string authority = _url.substr(scheme.size(),
+      slash == std::string::npos ? std::string::npos : slash - scheme.size());
+  this->path = slash == std::string::npos ? "/" : _url.substr(slash);
+  const auto colon = authority.rfind(':');
+  this->host = authority.substr(0, colon);
+  this->port = colon == std::string::npos ? "80" : authority.substr(colon + 1);
+  if (this->host.empty() || this->port.empty())
+    throw std::runtime_error{"invalid remote write URL [" + _url + "]"};
+
+  this->registry = _registry;
+  this->stopping = false;
+  this->running = true;
+  this->thread = std::thread(&RemoteWriteExporter::Run, this);
+}
+
+//////////////////////////////////////////////////
+void RemoteWriteExporter::Stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stopping = true;
+  }
+  this->wake.notify_all();
+  if (this->thread.joinable())
+    this->thread.join();
+  this->running = false;
+}
+
+//////////////////////////////////////////////////
+bool RemoteWriteExporter::Running() const
+{
+  return this->running;
+}
+
+//////////////////////////////////////////////////
+bool RemoteWriteExporter::Push(double _value, int64_t _timestamp)
+{
+  return this->samples.Push(LiveSample{_value, _timestamp});
+}
+
+//////////////////////////////////////////////////
+RemoteWriteStats RemoteWriteExporter::Stats() const
+{
+  RemoteWriteStats stats;
+  stats.requests = this->requests;
+  stats.samples = this->sampleCount;
+  stats.retries = this->retries;
+  stats.rejected = this->rejected;
+  stats.dropped = this->dropped;
+  const auto queueStats = this->samples.Stats();
+  stats.samplesDropped = queueStats.dropped + queueStats.overflowed;
+  stats.queuedBytes = this->queuedBytes;
+  stats.lastStatus = this->lastStatus;
+  return stats;
+}
+
+//////////////////////////////////////////////////
+void RemoteWriteExporter::Run()
+{
+  AllocScope allocScope(AllocStage::kExport);
+  const auto period = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(this->period));
+  auto nextBatch = Clock::now() + period;
+  auto nextSend = nextBatch;
+  auto backoff = kMinBackoff;
+
+  while (true)
+  {
+    bool stop;
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      const auto until = this->queue.empty() ? nextBatch :
+        std::min(nextBatch, nextSend);
+      this->wake.wait_until(lock, until, [this] { return this->stopping; });
+      stop = this->stopping;
+    }
+
+    const auto now = Clock::now();
+    if (stop)
+    {
+      // One last attempt, without waiting for a backoff to pass.
+      this->Batch(WallMilliseconds(), true);
+      this->Send();
+      break;
+    }
+
+    if (now >= nextBatch)
+    {
+      this->Batch(WallMilliseconds(), false);
+      nextBatch += period;
+      if (nextBatch < now)
+        nextBatch = now + period;
+    }
+
+    if (!this->queue.empty() && now >= nextSend)
+    {
+      if (this->Send())
+      {
+        backoff = kMinBackoff;
+        nextSend = nextBatch;
+      }
+      else
+      {
+        nextSend = now + backoff;
+        backoff = std::min(backoff * 2, kMaxBackoff);
+      }
+    }
+  }
+  this->Disconnect();
+}
+
+//////////////////////////////////////////////////
+void RemoteWriteExporter::Batch(int64_t _now, bool _final)
+{
+  // Live samples, averaged per millisecond.
+  this->liveValues.clear();
+  this->samples.Drain([this](const LiveSample &_sample)
+  {
+    if (this->pendingCount > 0 && _sample.timestamp <= this->pendingTimestamp)
+    {
+      // Wall time that stepped back joins the latest millisecond, so the
+      // series stays ordered.
+      this->pendingSum += _sample.value;
+      ++this->pendingCount;
+      return;
+    }
+    if (this->pendingCount > 0)
+    {
+      this->liveValues.emplace_back(this->pendingTimestamp,
+          this->pendingSum / this->pendingCount);
+    }
+    this->pendingTimestamp = _sample.timestamp;
+    this->pendingSum = _sample.value;
+    this->pendingCount = 1;
+  });
+  if (_final && this->pendingCount > 0)
+  {
+    this->liveValues.emplace_back(this->pendingTimestamp,
+        this->pendingSum / this->pendingCount);
+    this->pendingCount = 0;
+  }
+
+  // Without a series to put them in, samples are only drained.
+  if (this->sampleName.empty())
+    this->liveValues.clear();
+  for (size_t start = 0; start < this->liveValues.size();
+       start += kMaxSamplesPerRequest)
+  {
+    RemoteWriteSeries live;
+    live.labels = &this->sampleLabels;
+    live.samples = this->liveValues.data() + start;
+    live.count = std::min(kMaxSamplesPerRequest,
+        this->liveValues.size() - start);
+    this->Enqueue(&live, 1);
+  }
+
+  if (!this->registry)
+    return;
+
+  // One sample per registry series, all at the same time.
+  size_t count = 0;
+  this->registry->Collect([this, &count, _now](const MetricSeries &_series)
+  {
+    if (this->labels.size() <= count)
+      this->labels.emplace_back();
+    RemoteWriteLabels &labels = this->labels[count];
+    labels.resize(_series.labels.size() + 1);
+    labels[0].first = "__name__";
+    labels[0].second = *_series.name;
+    for (size_t ii = 0; ii < _series.labels.size(); ++ii)
+    {
+      labels[ii + 1].first = *_series.labels[ii].first;
+      labels[ii + 1].second = *_series.labels[ii].second;
+    }
+    std::sort(labels.begin(), labels.end());
+    if (this->registryValues.size() <= count)
+      this->registryValues.emplace_back();
+    this->registryValues[count] = RemoteWriteSample(_now, _series.value);
+    ++count;
+  });
+
+  this->series.resize(count);
+  for (size_t ii = 0; ii < count; ++ii)
+  {
+    this->series[ii].labels = &this->labels[ii];
+    this->series[ii].samples = &this->registryValues[ii];
+    this->series[ii].count = 1;
+  }
+  for (size_t start = 0; start < count; start += kMaxSamplesPerRequest)
+  {
+    this->Enqueue(this->series.data() + start,
+        std::min(kMaxSamplesPerRequest, count - start));
+  }
+}
+
+//////////////////////////////////////////////////
+void RemoteWriteExporter::Enqueue(const RemoteWriteSeries *_series,
+    size_t _count)
+{
+  EncodeWriteRequest(_series, _count, this->encoded);
+  SnappyCompress(this->encoded.data(), this->encoded.size(),
+      this->compressed);
+
+  size_t numSamples = 0;
+  for (size_t ii = 0; ii < _count; ++ii)
+    numSamples += _series[ii].count;
+
+  this->queuedBytes += this->compressed.size();
+  this->queue.emplace_back(this->compressed, numSamples);
+  while (!this->queue.empty() && this->queuedBytes > this->maxQueuedBytes)
+  {
+    this->queuedBytes -= this->queue.front().first.size();
+    this->queue.pop_front();
+    ++this->dropped;
+  }
+}
+
+//////////////////////////////////////////////////
+bool RemoteWriteExporter::Send()
+{
+  while (!this->queue.empty())
+  {
+    const auto &request = this->queue.front();
+    const int status = this->Post(request.first);
+    this->lastStatus = status;
+    if (status >= 200 && status < 300)
+    {
+      ++this->requests;
+      this->sampleCount += request.second;
+    }
+    else if (status == 0 || status == 429 || status >= 500)
+    {
+      ++this->retries;
+      return false;
+    }
+    else
+    {
+      // The receiver will never take it, sending it again won't help.
+      ++this->rejected;
+    }
+    this->queuedBytes -= request.first.size();
+    this->queue.pop_front();
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+int RemoteWriteExporter::Post(const std::string &_body)
+{
+  // A kept-alive connection may have been closed by the receiver since
+  // the last request, try once more on a new one.
+  const bool reused = this->fd >= 0;
+  const int status = this->PostOnce(_body);
+  if (status == 0 && reused)
+    return this->PostOnce(_body);
+  return status;
+}
+
+//////////////////////////////////////////////////
+int RemoteWriteExporter::PostOnce(const std::string &_body)
+{
+  if (this->fd < 0)
+  {
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *addresses = nullptr;
+    if (0 != getaddrinfo(this->host.c_str(), this->port.c_str(), &hints,
+                         &addresses))
+    {
+      return 0;
+    }
+    for (addrinfo *addr = addresses; addr; addr = addr->ai_next)
+    {
+      this->fd = socket(addr->ai_family, addr->ai_socktype | SOCK_CLOEXEC,
+          addr->ai_protocol);
+      if (this->fd < 0)
+        continue;
+      timeval timeout;
+      timeout.tv_sec = kSocketTimeoutSeconds;
+      timeout.tv_usec = 0;
+      setsockopt(this->fd, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+          sizeof(timeout));
+      setsockopt(this->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+          sizeof(timeout));
+      const int one = 1;
+      setsockopt(this->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      if (0 == connect(this->fd, addr->ai_addr, addr->ai_addrlen))
+        break;
+      this->Disconnect();
+    }
+    freeaddrinfo(addresses);
+    if (this->fd < 0)
+      return 0;
+  }
+
+  const std::string request = "POST " + this->path + " HTTP/1.1\r\n"
+    "Host: " + this->host + ":" + this->port + "\r\n"
+    "User-Agent: ign_imgui\r\n"
+    "Content-Type: application/x-protobuf\r\n"
+    "Content-Encoding: snappy\r\n"
+    "X-Prometheus-Remote-Write-Version: 0.1.0\r\n"
+    "Content-Length: " + std::to_string(_body.size()) + "\r\n\r\n";
+  if (!SendAll(this->fd, request.data(), request.size()) ||
+      !SendAll(this->fd, _body.data(), _body.size()))
+  {
+    this->Disconnect();
+    return 0;
+  }
+
+  // Read the header, then skip the body so the connection can be reused.
+  this->response.clear();
+  size_t headerEnd = std::string::npos;
+  char buffer[4096];
+  while (headerEnd == std::string::npos)
+  {
+    const ssize_t received = recv(this->fd, buffer, sizeof(buffer), 0);
+    if (received <= 0 || this->response.size() > kMaxResponseHeader)
+    {
+      this->Disconnect();
+      return 0;
+    }
+    this->response.append(buffer, static_cast<size_t>(received));
+    headerEnd = this->response.find("\r\n\r\n");
+  }
+
+  int status = 0;
+  if (this->response.compare(0, 5, "HTTP/") == 0)
+  {
+    const auto space = this->response.find(' ');
+    if (space != std::string::npos)
+      status = std::atoi(this->response.c_str() + space + 1);
+  }
+  const std::string header = this->response.substr(0, headerEnd + 2);
+  const std::string length = HeaderValue(header, "content-length");
+  const bool close = HeaderValue(header, "connection") == "close" ||
+    (length.empty() && status != 204 && status != 304);
+  if (status == 0 || close)
+  {
+    // Without a length the body ends when the connection does.
+    this->Disconnect();
+    return status;
+  }
+
+  size_t remaining = std::strtoull(length.c_str(), nullptr, 10);
+  const size_t buffered = this->response.size() - headerEnd - 4;
+  remaining -= std::min(remaining, buffered);
+  while (remaining > 0)
+  {
+    const ssize_t received = recv(this->fd, buffer,
+        std::min(remaining, sizeof(buffer)), 0);
+    if (received <= 0)
+    {
+      this->Disconnect();
+      break;
+    }
+    remaining -= static_cast<size_t>(received);
+  }
+  return status;
+}
+
+//////////////////////////////////////////////////
+void RemoteWriteExporter::Disconnect()
+{
+  if (this->fd >= 0)
+    close(this->fd);
+  this->fd = -1;
+}
+
+}  // namespace ign_imgui
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__REMOTE_WRITE_HH_
+#define IGN_IMGUI__REMOTE_WRITE_HH_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "IngestQueue.hh"
+#include "MetricRegistry.hh"
+
+namespace ign_imgui
+{
+
+/// \brief Label name and value pairs of a remote-write series.
+using RemoteWriteLabels = std::vector<std::pair<std::string, std::string>>;
+
+/// \brief Timestamp in milliseconds and value.
+using RemoteWriteSample = std::pair<int64_t, double>;
+
+/// \brief Series of a WriteRequest, pointing at the caller's data.
+struct RemoteWriteSeries
+{
+  /// \brief Sorted by name, including __name__.
+  const RemoteWriteLabels *labels{nullptr};
+  const RemoteWriteSample *samples{nullptr};
+  size_t count{0};
+};
+
+/// \brief Replace _out with a Prometheus remote-write WriteRequest
+/// protobuf holding _count series.
+void EncodeWriteRequest(const RemoteWriteSeries *_series, size_t _count,
+    std::string &_out);
+
+struct RemoteWriteStats
+{
+  /// \brief Requests the receiver accepted.
+  uint64_t requests{0};
+  uint64_t samples{0};
+
+  /// \brief Failed sends of a request that was kept to send again.
+  uint64_t retries{0};
+
+  /// \brief Requests the receiver refused with a 4xx status, which are
+  /// not sent again.
+  uint64_t rejected{0};
+
+  /// \brief Requests dropped unsent because the queue was over its limit.
+  uint64_t dropped{0};
+
+  /// \brief Live samples dropped because the sample queue was full.
+  uint64_t samplesDropped{0};
+
+  /// \brief Compressed bytes waiting to be sent.
+  uint64_t queuedBytes{0};
+
+  /// \brief HTTP status of the last response, 0 if the connection failed.
+  int lastStatus{0};
+};
+
+/// \brief Pushes metrics to a Prometheus remote-write endpoint, for hosts
+/// that cannot be scraped.
+///
+/// Every period a thread collects the registry, adds the live samples
+/// queued since the last period and posts them as snappy-compressed
+/// protobuf over HTTP/1.1. Push() only writes to an IngestQueue, so the
+/// ingest thread never waits for the network. Requests that fail with a
+/// network error, 429 or 5xx stay queued and are sent again with
+/// exponential backoff; once the queue holds more than MaxQueuedBytes()
+/// the oldest requests are dropped.
+class RemoteWriteExporter
+{
+  public: static constexpr size_t kDefaultMaxQueuedBytes = 16 << 20;
+  public: static constexpr size_t kMaxSamplesPerRequest = 2000;
+
+  /// \brief Live samples per producer thread between two periods.
+  public: static constexpr size_t kSampleQueueCapacity = 1 << 16;
+
+  public: RemoteWriteExporter();
+  public: ~RemoteWriteExporter();
+
+  public: RemoteWriteExporter(const RemoteWriteExporter &) = delete;
+  public: RemoteWriteExporter &operator=(const RemoteWriteExporter &) =
+    delete;
+
+  /// \brief Seconds between two pushes, set before Start().
+  public: void SetPeriod(double _seconds);
+
+  /// \brief Limit of the retry queue, set before Start().
+  public: void SetMaxQueuedBytes(size_t _bytes);
+  public: size_t MaxQueuedBytes() const;
+
+  /// \brief Name and labels of the series Push() appends to, set before
+  /// Start().
+  public: void SetSampleSeries(const std::string &_name,
+      const RemoteWriteLabels &_labels);
+
+  /// \brief Start pushing to _url.
+  /// \param[in] _url http://HOST[:PORT]/PATH, HTTPS needs a local proxy.
+  /// \param[in] _registry Collected every period, may be null.
+  /// \throws std::runtime_error if _url is invalid.
+  public: void Start(const std::string &_url,
+      const MetricRegistry *_registry);
+
+  /// \brief Push what is queued once more and stop.
+  public: void Stop();
+
+  public: bool Running() const;
+
+  /// \brief Queue a live sample, never blocks.
+  /// \param[in] _value Sample value.
+  /// \param[in] _timestamp Wall time in milliseconds. Samples sharing a
+  /// millisecond are averaged, remote write takes one per timestamp.
+  /// \return False if the sample was dropped.
+  public: bool Push(double _value, int64_t _timestamp);
+
+  public: RemoteWriteStats Stats() const;
+
+  protected: struct LiveSample
+  {
+    double value;
+    int64_t timestamp;
+  };
+
+  protected: void Run();
+
+  /// \brief Build requests from the registry and the live samples.
+  /// \param[in] _now Wall time in milliseconds.
+  /// \param[in] _final Also send the samples of the last millisecond, which
+  /// are otherwise held back in case more arrive for it.
+  protected: void Batch(int64_t _now, bool _final);
+
+  /// \brief Encode and compress _count series and queue the request,
+  /// dropping the oldest ones beyond MaxQueuedBytes().
+  protected: void Enqueue(const RemoteWriteSeries *_series, size_t _count);
+
+  /// \brief Send queued requests in order until one fails.
+  /// \return False if a request has to be sent again later.
+  protected: bool Send();
+
+  /// \brief POST _body, reconnecting if needed.
+  /// \return HTTP status, or 0 on a connection error.
+  protected: int Post(const std::string &_body);
+  protected: int PostOnce(const std::string &_body);
+  protected: void Disconnect();
+
+  protected: std::string host;
+  protected: std::string port;
+  protected: std::string path;
+  protected: int fd{-1};
+
+  protected: const MetricRegistry *registry{nullptr};
+  protected: std::string sampleName;
+  protected: RemoteWriteLabels sampleLabels;
+  protected: IngestQueue<LiveSample> samples;
+  protected: double period{10.0};
+  protected: size_t maxQueuedBytes{kDefaultMaxQueuedBytes};
+
+  /// \brief Compressed requests and their number of samples, oldest first.
+  protected: std::deque<std::pair<std::string, size_t>> queue;
+
+  /// \brief Live samples of the last millisecond seen, averaged.
+  protected: int64_t pendingTimestamp{0};
+  protected: double pendingSum{0.0};
+  protected: size_t pendingCount{0};
+
+  /// \brief Scratch reused across periods.
+  protected: std::vector<RemoteWriteLabels> labels;
+  protected: std::vector<RemoteWriteSample> registryValues;
+  protected: std::vector<RemoteWriteSample> liveValues;
+  protected: std::vector<RemoteWriteSeries> series;
+  protected: std::string encoded;
+  protected: std::string compressed;
+  protected: std::string response;
+
+  protected: std::thread thread;
+  protected: std::mutex mutex;
+  protected: std::condition_variable wake;
+  protected: bool stopping{false};
+  protected: std::atomic<bool> running{false};
+
+  protected: std::atomic<uint64_t> requests{0};
+  protected: std::atomic<uint64_t> sampleCount{0};
+  protected: std::atomic<uint64_t> retries{0};
+  protected: std::atomic<uint64_t> rejected{0};
+  protected: std::atomic<uint64_t> dropped{0};
+  protected: std::atomic<uint64_t> queuedBytes{0};
+  protected: std::atomic<int> lastStatus{0};
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__REMOTE_WRITE_HH_
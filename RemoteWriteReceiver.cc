@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Snappy.hh"
+
+// Stand-in for a Prometheus remote-write receiver, to try the exporter
+// without a Prometheus server. Accepts POSTs on 127.0.0.1, decodes the
+// snappy-compressed WriteRequest and prints every sample as
+//   name{label="value",...} value timestamp
+// --fail N answers the first N requests with 503 to exercise retries.
+
+namespace
+{
+
+const int kDefaultPort = 9201;
+
+volatile std::sig_atomic_t shouldClose = 0;
+
+/// \brief Cursor over a protobuf message.
+struct Reader
+{
+  const uint8_t *data;
+  const uint8_t *end;
+
+  bool Varint(uint64_t &_value)
+  {
+    _value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+      if (this->data == this->end)
+        return false;
+      const uint8_t byte = *this->data++;
+      _value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (byte < 0x80)
+        return true;
+    }
+    return false;
+  }
+
+  /// \brief Next field, with _sub spanning it if length-delimited.
+  bool Field(uint64_t &_number, uint64_t &_wireType, Reader &_sub,
+             uint64_t &_value)
+  {
+    uint64_t key;
+    if (!this->Varint(key))
+      return false;
+    _number = key >> 3;
+    _wireType = key & 7;
+    switch (_wireType)
+    {
+      case 0:
+        return this->Varint(_value);
+      case 1:
+        if (this->end - this->data < 8)
+          return false;
+        std::memcpy(&_value, this->data, 8);
+        this->data += 8;
+        return true;
+      case 2:
+      {
+        uint64_t size;
+        if (!this->Varint(size) ||
+            size > static_cast<uint64_t>(this->end - this->data))
+        {
+          return false;
+        }
+        _sub.data = this->data;
+        _sub.end = this->data + size;
+        this->data += size;
+        return true;
+      }
+      case 5:
+        if (this->end - this->data < 4)
+          return false;
+        this->data += 4;
+        return true;
+      default:
+        return false;
+    }
+  }
+};
+
+//////////////////////////////////////////////////
+/// \brief Print every sample of a WriteRequest.
+/// \return Number of samples, or -1 if the message is malformed.
+long PrintWriteRequest(const std::string &_message, bool _quiet)
+{
+  Reader request{reinterpret_cast<const uint8_t *>(_message.data()),
+    reinterpret_cast<const uint8_t *>(_message.data()) + _message.size()};
+  long count = 0;
+  uint64_t number, wireType, value;
+  Reader series{nullptr, nullptr};
+  while (request.data < request.end)
+  {
+    if (!request.Field(number, wireType, series, value))
+      return -1;
+    if (number != 1 || wireType != 2)
+      continue;
+
+    std::string name;
+    std::string labels;
+    std::vector<std::pair<double, int64_t>> samples;
+    Reader field{nullptr, nullptr};
+    while (series.data < series.end)
+    {
+      if (!series.Field(number, wireType, field, value))
+        return -1;
+      if (wireType != 2)
+        continue;
+      std::string key;
+      std::string text;
+      double sampleValue = 0.0;
+      int64_t timestamp = 0;
+      Reader inner{nullptr, nullptr};
+      while (field.data < field.end)
+      {
+        uint64_t innerNumber, innerType;
+        if (!field.Field(innerNumber, innerType, inner, value))
+          return -1;
+        if (number == 1 && innerType == 2)
+        {
+          std::string &target = innerNumber == 1 ? key : text;
+          target.assign(reinterpret_cast<const char *>(inner.data),
+              inner.end - inner.data);
+        }
+        else if (number == 2 && innerNumber == 1 && innerType == 1)
+        {
+          std::memcpy(&sampleValue, &value, sizeof(sampleValue));
+        }
+        else if (number == 2 && innerNumber == 2 && innerType == 0)
+        {
+          timestamp = static_cast<int64_t>(value);
+        }
+      }
+      if (number == 1 && key == "__name__")
+        name = text;
+      else if (number == 1)
+        labels += (labels.empty() ? "" : ",") + key + "=\"" + text + "\"";
+      else if (number == 2)
+        samples.emplace_back(sampleValue, timestamp);
+    }
+
+    for (const auto &sample : samples)
+    {
+      if (!_quiet)
+      {
+        std::printf("%s{%s} %.17g %lld\n", name.c_str(), labels.c_str(),
+            sample.first, static_cast<long long>(sample.second));
+      }
+      ++count;
+    }
+  }
+  return count;
+}
+
+//////////////////////////////////////////////////
+bool SendAll(int _fd, const std::string &_data)
+{
+  size_t sent = 0;
+  while (sent < _data.size())
+  {
+    const ssize_t n = send(_fd, _data.data() + sent, _data.size() - sent,
+        MSG_NOSIGNAL);
+    if (n <= 0)
+      return false;
+    sent += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+}  // namespace
+
+//////////////////////////////////////////////////
+int main(int _argc, char **_argv)
+{
+  int port = kDefaultPort;
+  long failures = 0;
+  bool quiet = false;
+  for (int i = 1; i < _argc; ++i)
+  {
+    if (0 == std::strcmp(_argv[i], "--port") && i + 1 < _argc)
+      port = std::atoi(_argv[++i]);
+    else if (0 == std::strcmp(_argv[i], "--fail") && i + 1 < _argc)
+      failures = std::atol(_argv[++i]);
+    else if (0 == std::strcmp(_argv[i], "--quiet"))
+      quiet = true;
+    else
+    {
+      std::printf("%s [--port <PORT>] [--fail <REQUESTS>] [--quiet]\n",
+          _argv[0]);
+      return 0;
+    }
+  }
+
+  // Without SA_RESTART, so a blocked accept() returns on Ctrl-C.
+  struct sigaction action;
+  std::memset(&action, 0, sizeof(action));
+  action.sa_handler = [](int) { shouldClose = 1; };
+  sigaction(SIGINT, &action, nullptr);
+
+  const int listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  const int one = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(static_cast<uint16_t>(port));
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (0 != bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) ||
+      0 != listen(listener, 16))
+  {
+    std::perror("failed to listen");
+    return 1;
+  }
+  std::fprintf(stderr, "Listening on http://127.0.0.1:%d/\n", port);
+
+  long requests = 0;
+  long total = 0;
+  std::string buffer;
+  std::string body;
+  std::string message;
+  char chunk[65536];
+  while (!shouldClose)
+  {
+    const int fd = accept(listener, nullptr, nullptr);
+    if (fd < 0)
+      continue;
+    buffer.clear();
+
+    // Requests on one kept-alive connection, until the client closes it.
+    bool open = true;
+    while (open && !shouldClose)
+    {
+      size_t headerEnd;
+      while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos)
+      {
+        const ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0)
+        {
+          open = false;
+          break;
+        }
+        buffer.append(chunk, static_cast<size_t>(n));
+      }
+      if (!open)
+        break;
+
+      size_t length = 0;
+      const char *found = strcasestr(buffer.c_str(), "\r\ncontent-length:");
+      if (found && found < buffer.c_str() + headerEnd)
+        length = std::strtoull(found + 17, nullptr, 10);
+      while (buffer.size() < headerEnd + 4 + length)
+      {
+        const ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0)
+        {
+          open = false;
+          break;
+        }
+        buffer.append(chunk, static_cast<size_t>(n));
+      }
+      if (!open)
+        break;
+      body.assign(buffer, headerEnd + 4, length);
+      buffer.erase(0, headerEnd + 4 + length);
+
+      ++requests;
+      std::string reply;
+      long count = -1;
+      if (requests <= failures)
+      {
+        reply = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n";
+      }
+      else if (!ign_imgui::SnappyUncompress(body.data(), body.size(),
+                                            message) ||
+               (count = PrintWriteRequest(message, quiet)) < 0)
+      {
+        const std::string error = "malformed write request\n";
+        reply = "HTTP/1.1 400 Bad Request\r\nContent-Length: " +
+          std::to_string(error.size()) + "\r\n\r\n" + error;
+      }
+      else
+      {
+        total += count;
+        reply = "HTTP/1.1 204 No Content\r\n\r\n";
+      }
+      std::fflush(stdout);
+      std::fprintf(stderr, "request %ld: %zu bytes, %ld samples\n", requests,
+          body.size(), count);
+      open = SendAll(fd, reply);
+    }
+    close(fd);
+  }
+  close(listener);
+  std::fprintf(stderr, "%ld requests, %ld samples\n", requests, total);
+  return 0;
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "RenderThread.hh"
+
+#include <algorithm>
+#include <chrono>
+
+#include <imgui/imgui.h>
+
+namespace
+{
+
+/// \brief Window over which RenderStats::fps is averaged, in seconds.
+const double kFpsPeriod = 1.0;
+
+/// \brief Weight of the newest frame in the smoothed frame cost.
+const double kFrameCpuSmoothing = 0.2;
+
+//////////////////////////////////////////////////
+ign_imgui::WindowBackend &Backend()
+{
+  static ign_imgui::WindowBackend backend;
+  return backend;
+}
+
+//////////////////////////////////////////////////
+double Now()
+{
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+void FrameGovernor::SetMaxFps(double _fps)
+{
+  this->maxFps = std::max(_fps, 1.0);
+}
+
+//////////////////////////////////////////////////
+void FrameGovernor::SetCpuBudget(double _fraction)
+{
+  this->cpuBudget = std::min(std::max(_fraction, 0.01), 1.0);
+}
+
+//////////////////////////////////////////////////
+void FrameGovernor::MarkDirty()
+{
+  this->pendingFrames = kSettleFrames;
+}
+
+//////////////////////////////////////////////////
+double FrameGovernor::Delay(double _now, bool _visible) const
+{
+  if (!_visible)
+    return kHiddenWait;
+  if (this->pendingFrames <= 0)
+    return kIdleWait;
+  return std::max(0.0, this->lastFrame + this->MinInterval() - _now);
+}
+
+//////////////////////////////////////////////////
+void FrameGovernor::FrameDone(double _now, double _cpuSeconds)
+{
+  this->lastFrame = _now;
+  this->frameCpu = this->frameCpu > 0.0 ?
+    this->frameCpu + kFrameCpuSmoothing * (_cpuSeconds - this->frameCpu) :
+    _cpuSeconds;
+  this->pendingFrames = std::max(0, this->pendingFrames - 1);
+}
+
+//////////////////////////////////////////////////
+double FrameGovernor::MinInterval() const
+{
+  return std::max(1.0 / this->maxFps, this->frameCpu / this->cpuBudget);
+}
+
+//////////////////////////////////////////////////
+RenderThread::~RenderThread()
+{
+  this->Stop();
+}
+
+//////////////////////////////////////////////////
+void RenderThread::SetBackend(const WindowBackend &_backend)
+{
+  Backend() = _backend;
+}
+
+//////////////////////////////////////////////////
+bool RenderThread::HasBackend()
+{
+  const auto &backend = Backend();
+  return backend.init && backend.present;
+}
+
+//////////////////////////////////////////////////
+bool RenderThread::Start(std::function<void()> _draw)
+{
+  if (!HasBackend() || this->thread.joinable())
+    return false;
+
+  std::promise<bool> ready;
+  auto result = ready.get_future();
+  this->running = true;
+  this->thread = std::thread([this, _draw, &ready]()
+  {
+    this->Run(_draw, ready);
+  });
+  if (result.get())
+    return true;
+
+  this->running = false;
+  this->thread.join();
+  return false;
+}
+
+//////////////////////////////////////////////////
+void RenderThread::Stop()
+{
+  if (!this->thread.joinable())
+    return;
+  this->running = false;
+  if (Backend().wake)
+    Backend().wake();
+  this->thread.join();
+}
+
+//////////////////////////////////////////////////
+void RenderThread::Publish()
+{
+  this->published.fetch_add(1);
+  if (this->idle.exchange(false) && Backend().wake)
+    Backend().wake();
+}
+
+//////////////////////////////////////////////////
+bool RenderThread::CloseRequested() const
+{
+  return this->closeRequested;
+}
+
+//////////////////////////////////////////////////
+RenderStats RenderThread::Stats() const
+{
+  return {this->frames.load(), this->fps.load(), this->cpuMeter.Usage()};
+}
+
+//////////////////////////////////////////////////
+void RenderThread::Run(std::function<void()> _draw,
+    std::promise<bool> &_ready)
+{
+  auto &backend = Backend();
+  ImGui::CreateContext();
+  if (!backend.init())
+  {
+    ImGui::DestroyContext();
+    _ready.set_value(false);
+    return;
+  }
+  _ready.set_value(true);
+
+  FrameGovernor governor;
+  uint64_t drawn = UINT64_MAX;
+  double delay = 0.0;
+  double fpsStart = Now();
+  uint64_t fpsFrames = 0;
+  while (this->running)
+  {
+    // Only an idle wait of a visible window needs waking up by Publish().
+    // Re-check after raising the flag so a publish in between is not lost.
+    if (delay >= FrameGovernor::kIdleWait)
+    {
+      this->idle = true;
+      if (this->published.load() != drawn)
+        delay = 0.0;
+    }
+    bool input = false;
+    if (backend.waitEvents)
+      input = backend.waitEvents(delay);
+    else if (delay > 0.0)
+      std::this_thread::sleep_for(std::chrono::duration<double>(delay));
+    this->idle = false;
+
+    if (backend.shouldClose && backend.shouldClose())
+    {
+      this->closeRequested = true;
+      break;
+    }
+
+    const uint64_t generation = this->published.load();
+    if (generation != drawn || input)
+      governor.MarkDirty();
+
+    const bool visible = !backend.visible || backend.visible();
+    const double now = Now();
+    this->cpuMeter.Sample();
+    if (now - fpsStart >= kFpsPeriod)
+    {
+      this->fps = fpsFrames / (now - fpsStart);
+      fpsStart = now;
+      fpsFrames = 0;
+    }
+
+    delay = governor.Delay(now, visible);
+    if (delay > 0.0)
+      continue;
+
+    drawn = generation;
+    const double cpuStart = ThreadCpuMeter::ThreadSeconds();
+    if (backend.newFrame)
+      backend.newFrame();
+    ImGui::NewFrame();
+    _draw();
+    ImGui::Render();
+    backend.present();
+    governor.FrameDone(now, ThreadCpuMeter::ThreadSeconds() - cpuStart);
+    ++this->frames;
+    ++fpsFrames;
+
+    delay = governor.Delay(Now(), visible);
+  }
+
+  if (backend.shutdown)
+    backend.shutdown();
+  ImGui::DestroyContext();
+}
+
+}  // namespace ign_imgui
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__RENDER_THREAD_HH_
+#define IGN_IMGUI__RENDER_THREAD_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <thread>
+
+#include "HostMetrics.hh"
+
+namespace ign_imgui
+{
+
+/// \brief Window and renderer hooks driven by the render thread.
+///
+/// Like TextureBackend, whoever links a platform backend (e.g. GLFW with
+/// OpenGL) installs these once with RenderThread::SetBackend(). Every hook
+/// except wake is called from the render thread only.
+struct WindowBackend
+{
+  /// \brief Create the window and renderer, after the ImGui context.
+  std::function<bool()> init;
+  /// \brief Block for up to _timeout seconds or until an input event.
+  /// \return True if input arrived.
+  std::function<bool(double _timeout)> waitEvents;
+  /// \brief Make a pending waitEvents() return early. Thread safe.
+  std::function<void()> wake;
+  std::function<bool()> visible;
+  std::function<bool()> shouldClose;
+  /// \brief Platform and renderer NewFrame, before ImGui::NewFrame().
+  std::function<void()> newFrame;
+  /// \brief Render ImGui::GetDrawData() and swap buffers.
+  std::function<void()> present;
+  std::function<void()> shutdown;
+};
+
+/// \brief Decides when the next frame may be drawn.
+///
+/// Frames are only drawn while something changed: new data was published
+/// or input arrived, plus a few settle frames for ImGui to catch up. The
+/// rate is capped at the maximum frame rate and lowered further whenever
+/// the measured render cost would exceed the CPU budget. Hidden windows
+/// draw nothing.
+class FrameGovernor
+{
+  /// \brief Frames drawn after the last change.
+  public: static constexpr int kSettleFrames = 3;
+
+  /// \brief Wait between event polls with nothing to draw, in seconds.
+  public: static constexpr double kIdleWait = 1.0;
+  public: static constexpr double kHiddenWait = 0.25;
+
+  public: void SetMaxFps(double _fps);
+
+  /// \brief Fraction of one core the render thread may use.
+  public: void SetCpuBudget(double _fraction);
+
+  /// \brief Data or input changed, the next frames must be drawn.
+  public: void MarkDirty();
+
+  /// \brief Seconds until the next frame should be drawn, 0 to draw now.
+  public: double Delay(double _now, bool _visible) const;
+
+  /// \brief Record a frame drawn at _now costing _cpuSeconds.
+  public: void FrameDone(double _now, double _cpuSeconds);
+
+  /// \brief Current shortest interval between frames, in seconds.
+  public: double MinInterval() const;
+
+  protected: double maxFps{60.0};
+  protected: double cpuBudget{0.25};
+  protected: double frameCpu{0.0};
+  protected: double lastFrame{0.0};
+  protected: int pendingFrames{0};
+};
+
+/// \brief Counters of the render thread, readable from any thread.
+struct RenderStats
+{
+  uint64_t frames;
+  double fps;
+  double cpu;
+};
+
+/// \brief Runs the ImGui frame loop on its own thread.
+///
+/// Ingest publishes after it changed the accumulators, the render thread
+/// only draws a frame when a new generation was published or input
+/// arrived, as paced by a FrameGovernor. Widgets lock their own data while
+/// drawing, so ingest is only ever blocked for the copy a widget makes.
+class RenderThread
+{
+  public: RenderThread() = default;
+  public: ~RenderThread();
+
+  public: RenderThread(const RenderThread &) = delete;
+  public: RenderThread &operator=(const RenderThread &) = delete;
+
+  public: static void SetBackend(const WindowBackend &_backend);
+  public: static bool HasBackend();
+
+  /// \brief Start the frame loop, calling _draw between ImGui::NewFrame()
+  /// and ImGui::Render() for every frame.
+  /// \return False if no window backend is installed or init failed.
+  public: bool Start(std::function<void()> _draw);
+  public: void Stop();
+
+  /// \brief Announce new data. Cheap enough to call for every batch.
+  public: void Publish();
+
+  /// \brief True once the user asked to close the window.
+  public: bool CloseRequested() const;
+
+  public: RenderStats Stats() const;
+
+  protected: void Run(std::function<void()> _draw,
+                      std::promise<bool> &_ready);
+
+  protected: std::thread thread;
+  protected: std::atomic<bool> running{false};
+  protected: std::atomic<bool> closeRequested{false};
+  protected: std::atomic<uint64_t> published{0};
+
+  /// \brief Set while the render thread waits with nothing to draw, so
+  /// Publish() only wakes it when needed.
+  protected: std::atomic<bool> idle{false};
+  protected: std::atomic<uint64_t> frames{0};
+  protected: std::atomic<double> fps{0.0};
+  protected: ThreadCpuMeter cpuMeter;
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__RENDER_THREAD_HH_
@@ -0,0 +1,380 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "BinaryUtils.hh"
+#include "CsvUtils.hh"
+#include "Reservoir.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+
+const size_t kDefaultReservoirCapacity = 4096;
+
+//////////////////////////////////////////////////
+/// \brief Uniform draw in the open interval (0, 1), safe to take the log of.
+double UniformOpen(std::mt19937_64 &_rng)
+{
+  std::uniform_real_distribution<double> dist(
+      std::numeric_limits<double>::min(), 1.0);
+  return dist(_rng);
+}
+
+//////////////////////////////////////////////////
+/// \brief Move a uniformly chosen subset of _count elements to the front.
+void PartialShuffle(std::vector<ign_imgui::RtfSample> &_samples,
+                    size_t _count, std::mt19937_64 &_rng)
+{
+  for (size_t ii = 0; ii < _count; ++ii)
+  {
+    std::uniform_int_distribution<size_t> dist(ii, _samples.size() - 1);
+    std::swap(_samples[ii], _samples[dist(_rng)]);
+  }
+}
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+constexpr size_t Reservoir::kMaxCapacity;
+
+//////////////////////////////////////////////////
+Reservoir::Reservoir()
+  : capacity(kDefaultReservoirCapacity),
+    rng(std::random_device{}())
+{
+  this->samples.reserve(this->capacity);
+}
+
+//////////////////////////////////////////////////
+void Reservoir::SetCapacity(size_t _capacity)
+{
+  if (_capacity > kMaxCapacity)
+    throw std::runtime_error{"reservoir capacity must be at most 2^24"};
+
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->capacity = _capacity;
+  this->samples.clear();
+  this->samples.shrink_to_fit();
+  this->samples.reserve(this->capacity);
+  this->seen = 0;
+  this->skip = 0;
+  this->w = 0.0;
+}
+
+//////////////////////////////////////////////////
+void Reservoir::SetSeed(uint64_t _seed)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->rng.seed(_seed);
+}
+
+//////////////////////////////////////////////////
+void Reservoir::InsertData(const RtfSample &_sample)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  const bool filling = this->Filling();
+  ++this->seen;
+
+  if (this->skip > 0)
+  {
+    --this->skip;
+    return;
+  }
+
+  if (filling)
+  {
+    this->samples.push_back(_sample);
+    if (this->samples.size() == this->capacity)
+      this->RestartSkip();
+    return;
+  }
+
+  if (this->samples.empty())
+    return;
+
+  std::uniform_int_distribution<size_t> slot(0, this->samples.size() - 1);
+  this->samples[slot(this->rng)] = _sample;
+  this->NextSkip();
+}
+
+//////////////////////////////////////////////////
+void Reservoir::InsertData(const RtfSample *_samples, size_t _count)
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  size_t ii = 0;
+  while (ii < _count)
+  {
+    if (this->skip > 0)
+    {
+      const uint64_t skipped = std::min<uint64_t>(this->skip, _count - ii);
+      this->skip -= skipped;
+      this->seen += skipped;
+      ii += skipped;
+      continue;
+    }
+
+    const bool filling = this->Filling();
+    ++this->seen;
+    const RtfSample &sample = _samples[ii++];
+    if (filling)
+    {
+      this->samples.push_back(sample);
+      if (this->samples.size() == this->capacity)
+        this->RestartSkip();
+      continue;
+    }
+
+    if (this->samples.empty())
+      continue;
+
+    std::uniform_int_distribution<size_t> slot(0, this->samples.size() - 1);
+    this->samples[slot(this->rng)] = sample;
+    this->NextSkip();
+  }
+}
+
+//////////////////////////////////////////////////
+void Reservoir::Reset()
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->samples.clear();
+  this->seen = 0;
+  this->skip = 0;
+  this->w = 0.0;
+}
+
+//////////////////////////////////////////////////
+void Reservoir::Merge(const Reservoir &_other)
+{
+  if (&_other == this)
+    return;
+
+  std::vector<RtfSample> otherSamples;
+  uint64_t otherSeen;
+  {
+    std::lock_guard<std::mutex> lock(_other.dataMutex);
+    otherSamples = _other.samples;
+    otherSeen = _other.seen;
+  }
+
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+
+  const bool thisComplete = this->seen == this->samples.size();
+  const bool otherComplete = otherSeen == otherSamples.size();
+  const size_t available = this->samples.size() + otherSamples.size();
+  if (thisComplete && otherComplete && available <= this->capacity)
+  {
+    // Neither side has dropped anything, keep it all.
+    this->samples.insert(this->samples.end(),
+        otherSamples.begin(), otherSamples.end());
+    this->seen += otherSeen;
+    this->RestartSkip();
+    return;
+  }
+
+  // Sequential hypergeometric draw: each pick comes from a side with
+  // probability proportional to how many of its stream samples remain.
+  // A side that has down-sampled can run out of samples to stand for its
+  // stream, then the merged sample stops short rather than over-weighting
+  // the other side.
+  uint64_t remainingThis = this->seen;
+  uint64_t remainingOther = otherSeen;
+  size_t fromThis = 0;
+  size_t fromOther = 0;
+  const size_t picks = std::min(this->capacity, available);
+  for (size_t ii = 0; ii < picks; ++ii)
+  {
+    std::uniform_int_distribution<uint64_t> dist(
+        0, remainingThis + remainingOther - 1);
+    const bool pickThis = dist(this->rng) < remainingThis;
+    if (pickThis ? fromThis == this->samples.size() :
+                   fromOther == otherSamples.size())
+    {
+      break;
+    }
+
+    if (pickThis)
+    {
+      ++fromThis;
+      --remainingThis;
+    }
+    else
+    {
+      ++fromOther;
+      --remainingOther;
+    }
+  }
+
+  PartialShuffle(this->samples, fromThis, this->rng);
+  PartialShuffle(otherSamples, fromOther, this->rng);
+  this->samples.resize(fromThis);
+  this->samples.insert(this->samples.end(),
+      otherSamples.begin(), otherSamples.begin() + fromOther);
+
+  this->seen += otherSeen;
+  this->RestartSkip();
+}
+
+//////////////////////////////////////////////////
+size_t Reservoir::Capacity() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->capacity;
+}
+
+//////////////////////////////////////////////////
+uint64_t Reservoir::Seen() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->seen;
+}
+
+//////////////////////////////////////////////////
+std::vector<RtfSample> Reservoir::Samples() const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  return this->samples;
+}
+
+//////////////////////////////////////////////////
+void Reservoir::RestartSkip()
+{
+  this->skip = 0;
+  this->w = 0.0;
+  if (this->samples.empty() || this->Filling())
+    return;
+
+  // After n samples the acceptance threshold is the k-th smallest of n
+  // uniform keys, i.e. Beta(k, n - k + 1) distributed.
+  const size_t k = this->samples.size();
+  std::gamma_distribution<double> head(static_cast<double>(k));
+  std::gamma_distribution<double> tail(static_cast<double>(this->seen - k + 1));
+  const double x = head(this->rng);
+  const double y = tail(this->rng);
+  this->w = x / (x + y);
+  this->w = std::min(std::max(this->w, std::numeric_limits<double>::min()),
+                     1.0 - std::numeric_limits<double>::epsilon());
+
+  const double skipLength =
+      std::floor(std::log(UniformOpen(this->rng)) / std::log1p(-this->w));
+  this->skip = skipLength < static_cast<double>(
+      std::numeric_limits<uint64_t>::max()) ?
+    static_cast<uint64_t>(skipLength) : std::numeric_limits<uint64_t>::max();
+}
+
+//////////////////////////////////////////////////
+bool Reservoir::Filling() const
+{
+  return this->samples.size() < this->capacity &&
+    this->samples.size() == this->seen;
+}
+
+//////////////////////////////////////////////////
+void Reservoir::NextSkip()
+{
+  this->w *= std::exp(std::log(UniformOpen(this->rng)) /
+      static_cast<double>(this->samples.size()));
+  const double skipLength =
+      std::floor(std::log(UniformOpen(this->rng)) / std::log1p(-this->w));
+  this->skip = skipLength < static_cast<double>(
+      std::numeric_limits<uint64_t>::max()) ?
+    static_cast<uint64_t>(skipLength) : std::numeric_limits<uint64_t>::max();
+}
+
+//////////////////////////////////////////////////
+void Reservoir::ToCsv(std::ostream & ost) const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  const auto precision = ost.precision(std::numeric_limits<double>::max_digits10);
+  ost << this->capacity << "," << this->seen << "," << this->samples.size() <<
+    "," << std::endl;
+  for (const auto &sample : this->samples)
+    ost << sample.rtf << "," << sample.sim << "," << sample.real << "," << std::endl;
+  ost.precision(precision);
+}
+
+//////////////////////////////////////////////////
+void Reservoir::FromCsv(std::istream & ist)
+{
+  size_t newCapacity;
+  uint64_t newSeen;
+  size_t size;
+  GetNextCsv(ist, newCapacity);
+  GetNextCsv(ist, newSeen);
+  GetNextCsv(ist, size);
+  GetNewLine(ist);
+  if (newCapacity > kMaxCapacity || size > newCapacity || size > newSeen)
+    throw std::runtime_error{"failed to parse input csv file"};
+
+  std::vector<RtfSample> newSamples(size);
+  for (auto &sample : newSamples)
+  {
+    GetNextCsv(ist, sample.rtf);
+    GetNextCsv(ist, sample.sim);
+    GetNextCsv(ist, sample.real);
+  }
+  ist >> std::ws;
+
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->capacity = newCapacity;
+  this->seen = newSeen;
+  this->samples = std::move(newSamples);
+  this->samples.reserve(this->capacity);
+  this->RestartSkip();
+}
+
+//////////////////////////////////////////////////
+void Reservoir::ToBinary(std::ostream & ost) const
+{
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  WriteBinary(ost, static_cast<uint64_t>(this->capacity));
+  WriteBinary(ost, this->seen);
+  WriteBinary(ost, this->samples);
+}
+
+//////////////////////////////////////////////////
+void Reservoir::FromBinary(std::istream & ist)
+{
+  uint64_t newCapacity;
+  uint64_t newSeen;
+  std::vector<RtfSample> newSamples;
+  ReadBinary(ist, newCapacity);
+  ReadBinary(ist, newSeen);
+  if (newCapacity > kMaxCapacity)
+    throw std::runtime_error{"failed to parse input binary file"};
+  ReadBinary(ist, newSamples);
+  if (newSamples.size() > newCapacity || newSamples.size() > newSeen)
+    throw std::runtime_error{"failed to parse input binary file"};
+
+  std::lock_guard<std::mutex> lock(this->dataMutex);
+  this->capacity = newCapacity;
+  this->seen = newSeen;
+  this->samples = std::move(newSamples);
+  this->samples.reserve(this->capacity);
+  this->RestartSkip();
+}
+
+}  // namespace ign_imgui
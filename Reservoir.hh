@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__RESERVOIR_HH_
+#define IGN_IMGUI__RESERVOIR_HH_
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <random>
+#include <vector>
+
+namespace ign_imgui
+{
+
+/// \brief One raw real time factor sample and the clock it was computed at.
+struct RtfSample
+{
+  double rtf;
+  double sim;
+  double real;
+};
+
+/// \brief Fixed-size uniform sample of every RtfSample seen over a run.
+///
+/// Uses Li's Algorithm L: once the reservoir is full, the number of samples
+/// to skip before the next replacement is drawn up front, so most inserts
+/// only decrement a counter.
+class Reservoir
+{
+  /// \brief Largest capacity, loads claiming more are rejected before
+  /// anything is reserved for them.
+  public: static constexpr size_t kMaxCapacity = size_t{1} << 24;
+
+  public: Reservoir();
+
+  /// \throws std::runtime_error if _capacity is > kMaxCapacity.
+  public: void SetCapacity(size_t _capacity);
+  public: void SetSeed(uint64_t _seed);
+  public: void InsertData(const RtfSample &_sample);
+
+  /// \brief Same as inserting each sample in turn, but runs of skipped
+  /// samples are passed over in one step.
+  public: void InsertData(const RtfSample *_samples, size_t _count);
+  public: void Reset();
+
+  /// \brief Merge another reservoir into this one.
+  ///
+  /// The result is a uniform sample of the union of both streams: the number
+  /// of samples taken from each side is drawn from the hypergeometric
+  /// distribution given by how many samples each side has seen. Everything
+  /// is kept only if neither side has dropped samples and it all fits.
+  public: void Merge(const Reservoir &_other);
+
+  public: size_t Capacity() const;
+  public: uint64_t Seen() const;
+  public: std::vector<RtfSample> Samples() const;
+
+  public: void ToCsv(std::ostream & ost) const;
+
+  public: void FromCsv(std::istream & ist);
+
+  public: void ToBinary(std::ostream & ost) const;
+
+  public: void FromBinary(std::istream & ist);
+
+  /// \brief Draw the skip length and threshold matching the current number
+  /// of seen samples, so insertion can continue after a load or merge.
+  protected: void RestartSkip();
+
+  protected: void NextSkip();
+
+  /// \brief True while every sample seen is kept and there is room for the
+  /// next one. A merge of down-sampled reservoirs can leave fewer
+  /// than capacity samples standing for more, those are then replaced like
+  /// in a full reservoir of that size.
+  protected: bool Filling() const;
+
+  protected: size_t capacity;
+  protected: uint64_t seen{0};
+  protected: uint64_t skip{0};
+  protected: double w{0.0};
+  protected: std::vector<RtfSample> samples;
+  protected: std::mt19937_64 rng;
+  protected: mutable std::mutex dataMutex;
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__RESERVOIR_HH_
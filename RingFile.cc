@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "RingFile.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+
+const char kRingFileMagic[8] = {'I', 'G', 'N', 'R', 'I', 'N', 'G', '\0'};
+const uint32_t kRingFileVersion = 1;
+
+/// \brief Records start on their own cache line after the header.
+const size_t kRecordsOffset = 64;
+
+static_assert(sizeof(ign_imgui::RingFileHeader) <= kRecordsOffset,
+    "ring file header does not fit before the records");
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+    "ring file sequence numbers must be lock-free to live in shared memory");
+
+//////////////////////////////////////////////////
+size_t FileSize(uint64_t _capacity)
+{
+  return kRecordsOffset + _capacity * sizeof(ign_imgui::RingFileRecord);
+}
+
+//////////////////////////////////////////////////
+bool HeaderMatches(const ign_imgui::RingFileHeader &_header,
+                   uint64_t _capacity)
+{
+  return std::memcmp(_header.magic, kRingFileMagic, sizeof(kRingFileMagic)) == 0 &&
+    _header.version == kRingFileVersion &&
+    _header.recordSize == sizeof(ign_imgui::RingFileRecord) &&
+    (_capacity == 0 || _header.capacity == _capacity);
+}
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+RingFileWriter::~RingFileWriter()
+{
+  this->Close();
+}
+
+//////////////////////////////////////////////////
+void RingFileWriter::Open(const std::string &_path, uint64_t _capacity)
+{
+  this->Close();
+  if (_capacity == 0)
+    throw std::runtime_error{"ring file capacity must be positive"};
+
+  int fd = ::open(_path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0)
+    throw std::runtime_error{"failed to open ring file " + _path};
+
+  const size_t expectedSize = FileSize(_capacity);
+  struct stat st;
+  bool reuse = ::fstat(fd, &st) == 0 &&
+    static_cast<size_t>(st.st_size) == expectedSize;
+
+  if (!reuse && ::ftruncate(fd, expectedSize) != 0)
+  {
+    ::close(fd);
+    throw std::runtime_error{"failed to resize ring file " + _path};
+  }
+
+  void *mapped = ::mmap(nullptr, expectedSize, PROT_READ | PROT_WRITE,
+      MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED)
+    throw std::runtime_error{"failed to map ring file " + _path};
+
+  this->data = mapped;
+  this->size = expectedSize;
+  this->header = static_cast<RingFileHeader *>(mapped);
+  this->records = reinterpret_cast<RingFileRecord *>(
+      static_cast<char *>(mapped) + kRecordsOffset);
+
+  if (!reuse || !HeaderMatches(*this->header, _capacity))
+  {
+    // A fresh or foreign file: clear every sequence number before the
+    // header is made valid, so no stale record can ever be read.
+    std::memset(mapped, 0, expectedSize);
+    std::memcpy(this->header->magic, kRingFileMagic, sizeof(kRingFileMagic));
+    this->header->version = kRingFileVersion;
+    this->header->recordSize = sizeof(RingFileRecord);
+    this->header->capacity = _capacity;
+    this->header->written.store(0, std::memory_order_release);
+  }
+
+  // Writes sweep the file front to back, let the kernel drop old pages.
+  ::madvise(mapped, expectedSize, MADV_SEQUENTIAL);
+}
+
+//////////////////////////////////////////////////
+void RingFileWriter::Close()
+{
+  if (this->data)
+  {
+    ::msync(this->data, this->size, MS_ASYNC);
+    ::munmap(this->data, this->size);
+  }
+  this->data = nullptr;
+  this->size = 0;
+  this->header = nullptr;
+  this->records = nullptr;
+}
+
+//////////////////////////////////////////////////
+bool RingFileWriter::IsOpen() const
+{
+  return this->data != nullptr;
+}
+
+//////////////////////////////////////////////////
+void RingFileWriter::Append(const RtfSample &_sample)
+{
+  const uint64_t index = this->header->written.load(std::memory_order_relaxed);
+  auto &record = this->records[index % this->header->capacity];
+
+  record.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  record.sample = _sample;
+  record.sequence.store(index + 1, std::memory_order_release);
+  this->header->written.store(index + 1, std::memory_order_release);
+}
+
+//////////////////////////////////////////////////
+void RingFileWriter::Sync()
+{
+  if (this->data)
+    ::msync(this->data, this->size, MS_ASYNC);
+}
+
+//////////////////////////////////////////////////
+RingFileReader::~RingFileReader()
+{
+  this->Close();
+}
+
+//////////////////////////////////////////////////
+void RingFileReader::Open(const std::string &_path)
+{
+  this->Close();
+
+  int fd = ::open(_path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error{"failed to open ring file " + _path};
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < kRecordsOffset)
+  {
+    ::close(fd);
+    throw std::runtime_error{"not a ring file " + _path};
+  }
+
+  void *mapped = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED)
+    throw std::runtime_error{"failed to map ring file " + _path};
+
+  this->data = mapped;
+  this->size = st.st_size;
+  this->header = static_cast<const RingFileHeader *>(mapped);
+  if (!HeaderMatches(*this->header, 0) ||
+      FileSize(this->header->capacity) != this->size)
+  {
+    this->Close();
+    throw std::runtime_error{"not a ring file " + _path};
+  }
+  this->records = reinterpret_cast<const RingFileRecord *>(
+      static_cast<const char *>(mapped) + kRecordsOffset);
+}
+
+//////////////////////////////////////////////////
+void RingFileReader::Close()
+{
+  if (this->data)
+    ::munmap(this->data, this->size);
+  this->data = nullptr;
+  this->size = 0;
+  this->header = nullptr;
+  this->records = nullptr;
+}
+
+//////////////////////////////////////////////////
+uint64_t RingFileReader::Written() const
+{
+  return this->header ?
+    this->header->written.load(std::memory_order_acquire) : 0;
+}
+
+//////////////////////////////////////////////////
+uint64_t RingFileReader::Size() const
+{
+  return this->header ?
+    std::min(this->Written(), this->header->capacity) : 0;
+}
+
+//////////////////////////////////////////////////
+bool RingFileReader::At(uint64_t _index, RtfSample &_sample) const
+{
+  const uint64_t written = this->Written();
+  const uint64_t retained = this->header ?
+    std::min(written, this->header->capacity) : 0;
+  if (_index >= retained)
+    return false;
+
+  const uint64_t absolute = written - retained + _index;
+  const auto &record = this->records[absolute % this->header->capacity];
+
+  const uint64_t before = record.sequence.load(std::memory_order_acquire);
+  _sample = record.sample;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const uint64_t after = record.sequence.load(std::memory_order_relaxed);
+  return before == absolute + 1 && after == before;
+}
+
+}  // namespace ign_imgui
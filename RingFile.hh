@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__RING_FILE_HH_
+#define IGN_IMGUI__RING_FILE_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+#include <string>
+
+#include "Reservoir.hh"
+
+namespace ign_imgui
+{
+
+/// \brief On-disk layout of a ring file header.
+struct RingFileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t recordSize;
+  uint64_t capacity;
+  /// \brief Number of records ever committed; the slot of record n is
+  /// n % capacity.
+  std::atomic<uint64_t> written;
+};
+
+/// \brief On-disk layout of one ring file record.
+///
+/// The sequence number is cleared before the payload is overwritten and set
+/// to the record index + 1 afterwards, so a record is valid only if its
+/// sequence matches the index it is read at. A writer killed mid-record
+/// leaves that one slot invalid and everything else readable.
+struct RingFileRecord
+{
+  std::atomic<uint64_t> sequence;
+  RtfSample sample;
+};
+
+/// \brief Appends samples to a fixed-size memory-mapped ring file.
+///
+/// Appends are plain stores into a shared mapping; the kernel owns the dirty
+/// pages, so they reach the file even if this process dies, and pages of old
+/// records can be evicted instead of staying resident.
+class RingFileWriter
+{
+  public: RingFileWriter() = default;
+  public: ~RingFileWriter();
+
+  public: RingFileWriter(const RingFileWriter &) = delete;
+  public: RingFileWriter &operator=(const RingFileWriter &) = delete;
+
+  /// \brief Create the file, or reopen it and continue after the last
+  /// committed record if it already has a matching layout.
+  /// \throws std::runtime_error if the file cannot be created or mapped.
+  public: void Open(const std::string &_path, uint64_t _capacity);
+  public: void Close();
+  public: bool IsOpen() const;
+
+  public: void Append(const RtfSample &_sample);
+
+  /// \brief Schedule write-back of dirty pages, for durability across
+  /// host crashes. Not needed to survive a process crash.
+  public: void Sync();
+
+  protected: void *data{nullptr};
+  protected: size_t size{0};
+  protected: RingFileHeader *header{nullptr};
+  protected: RingFileRecord *records{nullptr};
+};
+
+/// \brief Read-only random access to a ring file, possibly while a writer
+/// in another process is still appending to it.
+class RingFileReader
+{
+  public: RingFileReader() = default;
+  public: ~RingFileReader();
+
+  public: RingFileReader(const RingFileReader &) = delete;
+  public: RingFileReader &operator=(const RingFileReader &) = delete;
+
+  /// \throws std::runtime_error if the file is missing or not a ring file.
+  public: void Open(const std::string &_path);
+  public: void Close();
+
+  /// \brief Number of records ever written.
+  public: uint64_t Written() const;
+
+  /// \brief Number of records still retained, at most the capacity.
+  public: uint64_t Size() const;
+
+  /// \brief Read the retained record at _index, 0 being the oldest.
+  /// \return False if the record was overwritten or left incomplete.
+  public: bool At(uint64_t _index, RtfSample &_sample) const;
+
+  protected: void *data{nullptr};
+  protected: size_t size{0};
+  protected: const RingFileHeader *header{nullptr};
+  protected: const RingFileRecord *records{nullptr};
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__RING_FILE_HH_
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "SlidingRegression.hh"
+
+#include <stdexcept>
+
+namespace
+{
+
+const size_t kDefaultWindow = 100;
+
+//////////////////////////////////////////////////
+/// \brief |_a - _b| <= _limit, without overflowing on the subtraction.
+bool Near(int64_t _a, int64_t _b, int64_t _limit)
+{
+  return _a >= _b ? static_cast<uint64_t>(_a) - static_cast<uint64_t>(_b) <=
+                      static_cast<uint64_t>(_limit)
+                  : static_cast<uint64_t>(_b) - static_cast<uint64_t>(_a) <=
+                      static_cast<uint64_t>(_limit);
+}
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+constexpr int64_t SlidingRegression::kMaxOffset;
+constexpr size_t SlidingRegression::kMinWindow;
+constexpr size_t SlidingRegression::kMaxWindow;
+
+//////////////////////////////////////////////////
+SlidingRegression::SlidingRegression()
+{
+  this->SetWindow(kDefaultWindow);
+}
+
+//////////////////////////////////////////////////
+void SlidingRegression::SetWindow(size_t _points)
+{
+  if (_points < kMinWindow || _points > kMaxWindow)
+    throw std::runtime_error{"regression window must be 3 to 2^20 points"};
+  this->window = _points;
+  this->xs.assign(_points, 0);
+  this->ys.assign(_points, 0);
+  this->Clear();
+}
+
+//////////////////////////////////////////////////
+size_t SlidingRegression::Window() const
+{
+  return this->window;
+}
+
+//////////////////////////////////////////////////
+void SlidingRegression::Add(int64_t _x, int64_t _y)
+{
+  if (this->count == this->window)
+    this->RemoveOldest();
+
+  if (this->count == 0)
+  {
+    this->refX = _x;
+    this->refY = _y;
+  }
+  else if (!Near(_x, this->refX, kMaxOffset) ||
+           !Near(_y, this->refY, kMaxOffset))
+  {
+    const size_t oldest = this->head;
+    if (Near(_x, this->xs[oldest], kMaxOffset) &&
+        Near(_y, this->ys[oldest], kMaxOffset))
+    {
+      this->Rebase(this->xs[oldest], this->ys[oldest]);
+    }
+    else
+    {
+      this->Clear();
+      this->refX = _x;
+      this->refY = _y;
+    }
+  }
+
+  const size_t slot = (this->head + this->count) % this->window;
+  this->xs[slot] = _x;
+  this->ys[slot] = _y;
+  ++this->count;
+
+  const Sum dx = _x - this->refX;
+  const Sum dy = _y - this->refY;
+  this->sumX += dx;
+  this->sumY += dy;
+  this->sumXX += dx * dx;
+  this->sumXY += dx * dy;
+  this->sumYY += dy * dy;
+}
+
+//////////////////////////////////////////////////
+void SlidingRegression::RemoveOldest()
+{
+  if (this->count == 0)
+    return;
+  const Sum dx = this->xs[this->head] - this->refX;
+  const Sum dy = this->ys[this->head] - this->refY;
+  this->sumX -= dx;
+  this->sumY -= dy;
+  this->sumXX -= dx * dx;
+  this->sumXY -= dx * dy;
+  this->sumYY -= dy * dy;
+  this->head = (this->head + 1) % this->window;
+  --this->count;
+}
+
+//////////////////////////////////////////////////
+void SlidingRegression::Clear()
+{
+  this->head = 0;
+  this->count = 0;
+  this->sumX = 0;
+  this->sumY = 0;
+  this->sumXX = 0;
+  this->sumXY = 0;
+  this->sumYY = 0;
+}
+
+//////////////////////////////////////////////////
+size_t SlidingRegression::Count() const
+{
+  return this->count;
+}
+
+//////////////////////////////////////////////////
+bool SlidingRegression::Fit(RegressionFit &_fit) const
+{
+  if (this->count < 3)
+    return false;
+
+  // Centred sums n * Σ(x - x̄)², exact in integers.
+  const Sum n = static_cast<Sum>(this->count);
+  const Sum cxx = n * this->sumXX - this->sumX * this->sumX;
+  if (cxx <= 0)
+    return false;
+  const Sum cxy = n * this->sumXY - this->sumX * this->sumY;
+  const Sum cyy = n * this->sumYY - this->sumY * this->sumY;
+
+  const long double lxx = static_cast<long double>(cxx);
+  const long double lxy = static_cast<long double>(cxy);
+  const long double lyy = static_cast<long double>(cyy);
+  const long double slope = lxy / lxx;
+  const long double meanX = static_cast<long double>(this->sumX) / this->count;
+  const long double meanY = static_cast<long double>(this->sumY) / this->count;
+  const long double sse = (lyy - lxy * slope) / this->count;
+
+  _fit.slope = static_cast<double>(slope);
+  _fit.intercept = static_cast<double>(
+      (this->refY + meanY) - slope * (this->refX + meanX));
+  _fit.residualVariance = sse > 0 ?
+    static_cast<double>(sse / (this->count - 2)) : 0.0;
+  _fit.count = this->count;
+  return true;
+}
+
+//////////////////////////////////////////////////
+void SlidingRegression::Rebase(int64_t _x, int64_t _y)
+{
+  this->refX = _x;
+  this->refY = _y;
+  this->sumX = 0;
+  this->sumY = 0;
+  this->sumXX = 0;
+  this->sumXY = 0;
+  this->sumYY = 0;
+  for (size_t ii = 0; ii < this->count; ++ii)
+  {
+    const size_t slot = (this->head + ii) % this->window;
+    const Sum dx = this->xs[slot] - this->refX;
+    const Sum dy = this->ys[slot] - this->refY;
+    this->sumX += dx;
+    this->sumY += dy;
+    this->sumXX += dx * dx;
+    this->sumXY += dx * dy;
+    this->sumYY += dy * dy;
+  }
+}
+
+}  // namespace ign_imgui
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__SLIDING_REGRESSION_HH_
+#define IGN_IMGUI__SLIDING_REGRESSION_HH_
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <vector>
+
+namespace ign_imgui
+{
+
+/// \brief Least-squares line y = slope * x + intercept, in the units of the
+/// points it was fitted to.
+struct RegressionFit
+{
+  double slope{0.0};
+  double intercept{0.0};
+
+  /// \brief Sum of squared residuals over count - 2 degrees of freedom.
+  double residualVariance{0.0};
+  size_t count{0};
+};
+
+/// \brief Linear regression over the last Window() points, O(1) per point.
+///
+/// Points are kept as int64 offsets from a reference point in the window
+/// and summed in 128 bit integers, so adding and removing points is exact
+/// and a window can slide forever without the sums drifting. The reference
+/// moves to the oldest point when offsets grow past kMaxOffset, which costs
+/// one pass over the window.
+class SlidingRegression
+{
+  /// \brief Largest offset from the reference, 2^40 ns is about 18 minutes.
+  public: static constexpr int64_t kMaxOffset = int64_t{1} << 40;
+
+  /// \brief Smallest window, fewer points leave no residual to estimate.
+  public: static constexpr size_t kMinWindow = 3;
+
+  /// \brief Largest window, keeps every sum within 128 bits.
+  public: static constexpr size_t kMaxWindow = size_t{1} << 20;
+
+  public: SlidingRegression();
+
+  /// \brief Keep the last _points points, clears the window.
+  /// \throws std::runtime_error if _points is < kMinWindow or
+  /// > kMaxWindow.
+  public: void SetWindow(size_t _points);
+  public: size_t Window() const;
+
+  /// \brief Add a point, removing the oldest one if the window is full.
+  /// Only a point more than kMaxOffset from the window starts a new one,
+  /// callers clear the window themselves when e.g. the simulation resets.
+  public: void Add(int64_t _x, int64_t _y);
+
+  /// \brief Remove the oldest point, if any.
+  public: void RemoveOldest();
+
+  public: void Clear();
+  public: size_t Count() const;
+
+  /// \brief Fit the points in the window.
+  /// \return False with fewer than 3 points or all x equal.
+  public: bool Fit(RegressionFit &_fit) const;
+
+  protected: void Rebase(int64_t _x, int64_t _y);
+
+  protected: __extension__ typedef __int128 Sum;
+
+  protected: std::vector<int64_t> xs;
+  protected: std::vector<int64_t> ys;
+  protected: size_t window{0};
+  protected: size_t head{0};
+  protected: size_t count{0};
+
+  protected: int64_t refX{0};
+  protected: int64_t refY{0};
+  protected: Sum sumX{0};
+  protected: Sum sumY{0};
+  protected: Sum sumXX{0};
+  protected: Sum sumXY{0};
+  protected: Sum sumYY{0};
+};
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__SLIDING_REGRESSION_HH_
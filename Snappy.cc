@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "Snappy.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+
+/// \brief Copies never reach back further than a block, so every offset
+/// fits the 2 byte copy element.
+const size_t kBlockSize = 1 << 16;
+const int kHashBits = 14;
+
+/// \brief Inputs shorter than this are emitted as one literal.
+const size_t kMinCompressSize = 16;
+
+//////////////////////////////////////////////////
+void PutVarint(std::string &_out, uint64_t _value)
+{
+  while (_value >= 0x80)
+  {
+    _out.push_back(static_cast<char>(_value | 0x80));
+    _value >>= 7;
+  }
+  _out.push_back(static_cast<char>(_value));
+}
+
+//////////////////////////////////////////////////
+uint32_t Load32(const char *_p)
+{
+  uint32_t value;
+  std::memcpy(&value, _p, sizeof(value));
+  return value;
+}
+
+//////////////////////////////////////////////////
+uint32_t Hash(uint32_t _bytes)
+{
+  return (_bytes * 0x1e35a7bdu) >> (32 - kHashBits);
+}
+
+//////////////////////////////////////////////////
+void EmitLiteral(std::string &_out, const char *_data, size_t _size)
+{
+  size_t n = _size - 1;
+  if (n < 60)
+  {
+    _out.push_back(static_cast<char>(n << 2));
+  }
+  else
+  {
+    // Tags 60 to 63 say the length follows in 1 to 4 bytes.
+    char bytes[4];
+    int count = 0;
+    while (n > 0)
+    {
+      bytes[count++] = static_cast<char>(n & 0xff);
+      n >>= 8;
+    }
+    _out.push_back(static_cast<char>((59 + count) << 2));
+    _out.append(bytes, count);
+  }
+  _out.append(_data, _size);
+}
+
+//////////////////////////////////////////////////
+/// \brief One copy element, 4 <= _length <= 64.
+void EmitShortCopy(std::string &_out, size_t _offset, size_t _length)
+{
+  if (_length < 12 && _offset < 2048)
+  {
+    _out.push_back(static_cast<char>(
+          1 | ((_length - 4) << 2) | ((_offset >> 8) << 5)));
+    _out.push_back(static_cast<char>(_offset & 0xff));
+  }
+  else
+  {
+    _out.push_back(static_cast<char>(2 | ((_length - 1) << 2)));
+    _out.push_back(static_cast<char>(_offset & 0xff));
+    _out.push_back(static_cast<char>(_offset >> 8));
+  }
+}
+
+//////////////////////////////////////////////////
+void EmitCopy(std::string &_out, size_t _offset, size_t _length)
+{
+  // Split so that no piece is shorter than 4 bytes.
+  while (_length >= 68)
+  {
+    EmitShortCopy(_out, _offset, 64);
+    _length -= 64;
+  }
+  if (_length > 64)
+  {
+    EmitShortCopy(_out, _offset, 60);
+    _length -= 60;
+  }
+  EmitShortCopy(_out, _offset, _length);
+}
+
+//////////////////////////////////////////////////
+void CompressBlock(const char *_data, size_t _size, std::string &_out,
+                   std::vector<uint16_t> &_table)
+{
+  size_t literalStart = 0;
+  if (_size >= kMinCompressSize)
+  {
+    std::fill(_table.begin(), _table.end(), 0);
+    const size_t last = _size - 4;
+    size_t pos = 1;
+    // Step further the longer nothing matched, incompressible data is
+    // then skipped through quickly.
+    size_t skip = 32;
+    while (pos <= last)
+    {
+      const uint32_t bytes = Load32(_data + pos);
+      const uint32_t hash = Hash(bytes);
+      const size_t candidate = _table[hash];
+      _table[hash] = static_cast<uint16_t>(pos);
+      if (Load32(_data + candidate) != bytes)
+      {
+        pos += skip++ >> 5;
+        continue;
+      }
+
+      size_t length = 4;
+      while (pos + length < _size &&
+             _data[candidate + length] == _data[pos + length])
+      {
+        ++length;
+      }
+      if (literalStart < pos)
+        EmitLiteral(_out, _data + literalStart, pos - literalStart);
+      EmitCopy(_out, pos - candidate, length);
+      pos += length;
+      literalStart = pos;
+      skip = 32;
+    }
+  }
+  if (literalStart < _size)
+    EmitLiteral(_out, _data + literalStart, _size - literalStart);
+}
+
+}  // namespace
+
+namespace ign_imgui
+{
+
+//////////////////////////////////////////////////
+void SnappyCompress(const char *_data, size_t _size, std::string &_out)
+{
+  _out.clear();
+  _out.reserve(32 + _size + _size / 6);
+  PutVarint(_out, _size);
+
+  static thread_local std::vector<uint16_t> table(size_t{1} << kHashBits);
+  for (size_t start = 0; start < _size; start += kBlockSize)
+  {
+    const size_t size = std::min(kBlockSize, _size - start);
+    CompressBlock(_data + start, size, _out, table);
+  }
+}
+
+//////////////////////////////////////////////////
+bool SnappyUncompress(const char *_data, size_t _size, std::string &_out)
+{
+  const auto *in = reinterpret_cast<const uint8_t *>(_data);
+  const uint8_t *end = in + _size;
+
+  uint64_t length = 0;
+  for (int shift = 0; ; shift += 7)
+  {
+    if (in == end || shift > 28)
+      return false;
+    const uint8_t byte = *in++;
+    length |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (byte < 0x80)
+      break;
+  }
+
+  _out.clear();
+  _out.reserve(length);
+  while (in < end)
+  {
+    const uint8_t tag = *in++;
+    size_t size;
+    size_t offset = 0;
+    switch (tag & 3)
+    {
+      case 0:
+      {
+        size = tag >> 2;
+        if (size >= 60)
+        {
+          const size_t count = size - 59;
+          if (static_cast<size_t>(end - in) < count)
+            return false;
+          size = 0;
+          for (size_t ii = 0; ii < count; ++ii)
+            size |= static_cast<size_t>(in[ii]) << (8 * ii);
+          in += count;
+        }
+        ++size;
+        if (static_cast<size_t>(end - in) < size ||
+            _out.size() + size > length)
+        {
+          return false;
+        }
+        _out.append(reinterpret_cast<const char *>(in), size);
+        in += size;
+        continue;
+      }
+      case 1:
+        if (end - in < 1)
+          return false;
+        size = 4 + ((tag >> 2) & 7);
+        offset = (static_cast<size_t>(tag >> 5) << 8) | in[0];
+        in += 1;
+        break;
+      case 2:
+        if (end - in < 2)
+          return false;
+        size = 1 + (tag >> 2);
+        offset = in[0] | (static_cast<size_t>(in[1]) << 8);
+        in += 2;
+        break;
+      default:
+        if (end - in < 4)
+          return false;
+        size = 1 + (tag >> 2);
+        offset = in[0] | (static_cast<size_t>(in[1]) << 8) |
+          (static_cast<size_t>(in[2]) << 16) |
+          (static_cast<size_t>(in[3]) << 24);
+        in += 4;
+        break;
+    }
+
+    if (offset == 0 || offset > _out.size() || _out.size() + size > length)
+      return false;
+    // Copies may overlap their own output, e.g. runs of one byte.
+    const size_t from = _out.size() - offset;
+    for (size_t ii = 0; ii < size; ++ii)
+      _out.push_back(_out[from + ii]);
+  }
+  return _out.size() == length;
+}
+
+}  // namespace ign_imgui
@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGN_IMGUI__SNAPPY_HH_
+#define IGN_IMGUI__SNAPPY_HH_
+
+#include <cstdlib>
+#include <string>
+
+namespace ign_imgui
+{
+
+/// \brief Compress _size bytes at _data in the snappy block format, which
+/// Prometheus remote write expects, replacing the contents of _out.
+///
+/// Greedy matching on 4 byte hashes within 64 KiB blocks, like the
+/// reference encoder, so the output is close in size to what it produces.
+void SnappyCompress(const char *_data, size_t _size, std::string &_out);
+
+/// \brief Decompress a snappy block into _out.
+/// \return False if the input is malformed or truncated.
+bool SnappyUncompress(const char *_data, size_t _size, std::string &_out);
+
+}  // namespace ign_imgui
+
+#endif  // IGN_IMGUI__SNAPPY_HH_
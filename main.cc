@@ -15,19 +15,49 @@
  *
  */
 
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <csignal>
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
 
 #include <ignition/msgs.hh>
 #include <ignition/common/Console.hh>
 #include <ignition/common/Time.hh>
-#include <ignition/math/SignalStats.hh>
 #include <ignition/transport/Node.hh>
 
 #include <imgui/imgui.h>
 
-#include "CsvUtils.hh"
-#include "Histogram.hh"
+#include "AllocTracker.hh"
+#include "AnomalyDetector.hh"
+#include "ArrowExport.hh"
+#include "AsyncLog.hh"
+#include "ClockSample.hh"
+#include "ClockSource.hh"
+#include "DatagramSource.hh"
+#include "Distribution.hh"
+#include "DriftMonitor.hh"
+#include "Export.hh"
+#include "Histogram2D.hh"
+#include "HostMetrics.hh"
+#include "IngestPipeline.hh"
+#include "IngestQueue.hh"
+#include "IntervalHeatmap.hh"
+#include "LaggedCorrelation.hh"
+#include "LeastSquaresRtf.hh"
+#include "MappedFile.hh"
+#include "MetricRegistry.hh"
+#include "PersistentState.hh"
+#include "RemoteWrite.hh"
+#include "RenderThread.hh"
+#include "Moments.hh"
+#include "Reservoir.hh"
+#include "RingFile.hh"
+#include "SlidingRegression.hh"
 
 using namespace ignition;
 
@@ -38,60 +68,66 @@ const float kDefaultHistMax = 2.0f;
 const float kDefaultRTFMin = 0.0f;
 const float kDefaultRTFMax = 2.0f;
 
+const size_t kDefaultHist2dBins = 100;
+const float kDefaultHist2dStepMin = 1e-5f;
+const float kDefaultHist2dStepMax = 1.0f;
+const float kDefaultHist2dSimMax = 3600.0f;
+
+const double kDefaultInterval = 10.0;
+const size_t kDefaultIntervalColumns = 4096;
+
+const uint64_t kDefaultHistorySize = 1u << 22;
+
+const double kCorrelationPeriod = 0.1;
+const int kCorrelationMaxLag = 20;
+
+const double kDefaultCheckpointPeriod = 60.0;
+
+const size_t kIngestQueueCapacity = 4096;
+
+/// \brief Samples ingested before --alloc-check expects no allocations.
+const uint64_t kAllocCheckWarmup = 4096;
+const std::chrono::microseconds kIngestIdleSleep{500};
+
+const size_t kMetricRtfBins = 40;
+
+/// \brief Sequence --fake-clock loops over: 1 ms steps at RTF 1 with 5%
+/// jitter in the real time steps.
+const size_t kFakeClockMessages = 10000;
+const double kFakeClockStep = 0.001;
+const double kFakeClockJitter = 0.05;
+
 namespace ign_imgui
 {
 
 //////////////////////////////////////////////////
-void ToCsv(
-  std::ostream & ost, const ignition::math::SignalStats & stats,
-  const ign_imgui::Histogram & hist, double simTime, double realTime)
+/// \brief Local monotonic time in seconds, the common time grid used to
+/// align the RTF series with host metrics.
+double SteadySeconds()
 {
-  ost << simTime << "," << realTime << "," << std::endl;
-  ost << stats.Count() << "," << stats.Map()["mean"] << "," << stats.Map()["var"] <<
-    "," << stats.Map()["min"] << "," << stats.Map()["max"] << "," << std::endl;
-  hist.ToCsv(ost);
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-struct LoadedData
-{
-  size_t count;
-  double mean;
-  double var;
-  double max;
-  double min;
-
-  double realTime;
-  double simTime;
-};
-
 //////////////////////////////////////////////////
-LoadedData FromCsv(
-  std::istream & ist, ign_imgui::Histogram & hist)
+/// \brief Replace _path with _contents, never leaving a partially written
+/// file behind if the process dies mid-write.
+void WriteFileAtomically(const std::string & _path,
+                         const std::string & _contents)
 {
-  using ign_imgui::GetNextCsv;
-  using ign_imgui::GetNewLine;
-
-  LoadedData data;
-  GetNextCsv(ist, data.simTime);
-  GetNextCsv(ist, data.realTime);
-  GetNewLine(ist);
-  GetNextCsv(ist, data.count);
-  GetNextCsv(ist, data.mean);
-  GetNextCsv(ist, data.var);
-  GetNextCsv(ist, data.min);
-  GetNextCsv(ist, data.max);
-  GetNewLine(ist);
-
-  hist.FromCsv(ist);
-  while (ist.good()) {
-    std::string str;
-    ist >> str;
-    std::cout << str;
-  }
-  std::cout << std::endl;
-  IGN_IMGUI_CHECK_STREAM(ist, eof);
-
-  return data;
+  const std::string tmpPath = _path + ".tmp";
+  {
+    std::ofstream fs(tmpPath, std::ios::binary | std::ios::trunc);
+    fs.write(_contents.data(), _contents.size());
+    fs.flush();
+    if (!fs.good()) {
+      ignerr << "Failed to write [" << tmpPath << "]" << std::endl;
+      return;
+    }
+  }
+  if (0 != std::rename(tmpPath.c_str(), _path.c_str())) {
+    ignerr << "Failed to replace [" << _path << "]" << std::endl;
+  }
 }
 
 }  // namespace ign_imgui
@@ -107,45 +143,268 @@ int main(int _argc, char** _argv)
 
   std::string outputCsv;
   std::string inputCsv;
+  std::string baselineCsv;
+  std::string historyFile;
+  std::string checkpointFile;
+  std::string resumeFile;
+  std::string persistFile;
+  std::string arrowPrefix;
+  std::string listenAddress;
+  std::string metricsFile;
+  std::string remoteWriteUrl;
+  double fakeClockRate = 0.0;
+  size_t driftWindow = ign_imgui::DriftMonitor::kDefaultWindow;
+  double driftThreshold = ign_imgui::DriftMonitor::kDefaultThreshold;
+  bool arrowStream = false;
+  bool allocCheck = false;
+  double checkpointPeriod = kDefaultCheckpointPeriod;
+  uint64_t historySize = kDefaultHistorySize;
+  size_t lsqWindow = ign_imgui::LeastSquaresRtf::kDefaultWindow;
+  ign_imgui::Hist2dX hist2dX = ign_imgui::Hist2dX::kStep;
+  auto backendKind = ign_imgui::Distribution::Kind::kDense;
+  double interval = kDefaultInterval;
+  bool lazy = false;
   for (size_t i = 1; i < _argc; ++i) {
+    if (0 == strcmp(_argv[i], "--lazy")) {
+      lazy = true;
+      continue;
+    }
+    if (0 == strcmp(_argv[i], "--alloc-check")) {
+      allocCheck = true;
+      if (!ign_imgui::AllocTracker::Enabled()) {
+        ignwarn << "--alloc-check needs a build with "
+          "IGN_IMGUI_TRACK_ALLOCATIONS, no allocations are counted" <<
+          std::endl;
+      }
+      continue;
+    }
+    if (0 == strcmp(_argv[i], "--arrow-stream")) {
+      arrowStream = true;
+      continue;
+    }
     if (i + 1u < _argc) {
       if (0 == strcmp(_argv[i], "--output") || 0 == strcmp(_argv[i], "-o")) {
         outputCsv = _argv[++i];
-        ++i;
         continue;
       }
       if (0 == strcmp(_argv[i], "--input") || 0 == strcmp(_argv[i], "-i")) {
         inputCsv = _argv[++i];
-        ++i;
         continue;
       }
+      if (0 == strcmp(_argv[i], "--baseline")) {
+        baselineCsv = _argv[++i];
+        continue;
+      }
+      if (0 == strcmp(_argv[i], "--drift-window")) {
+        driftWindow = std::stoull(_argv[++i]);
+        if (driftWindow == 0) {
+          ignerr << "--drift-window needs at least one sample" << std::endl;
+          std::exit(1);
+        }
+        continue;
+      }
+      if (0 == strcmp(_argv[i], "--drift-threshold")) {
+        driftThreshold = std::stod(_argv[++i]);
+        continue;
+      }
+      if (0 == strcmp(_argv[i], "--history")) {
+        historyFile = _argv[++i];
+        continue;
+      }
+      if (0 == strcmp(_argv[i], "--checkpoint")) {
+        checkpointFile = _argv[++i];
+        continue;
+      }
+      if (0 == strcmp(_argv[i], "--checkpoint-period")) {
+        checkpointPeriod = std::stod(_argv[++i]);
+        continue;
+      }
+      if (0 == strcmp(_argv[i], "--resume")) {
+        resumeFile = _argv[++i];
+        continue;
+      }
+      if (0 == strcmp(_argv[i], "--persist")) {
+        persistFile = _argv[++i];
+        continue;
+      }
+      if (0 == strcmp(_argv[i], "--arrow")) {
+        arrowPrefix = _argv[++i];
+        continue;
+      }
+      if (0 == strcmp(_argv[i], "--listen")) {
+        listenAddress = _argv[++i];
+        continue;
+      }
+      if (0 == strcmp(_argv[i], "--metrics")) {
+        metricsFile = _argv[++i];
+        continue;
+      }
+      if (0 == strcmp(_argv[i], "--remote-write")) {
+        remoteWriteUrl = _argv[++i];
+        continue;
+      }
+      if (0 == strcmp(_argv[i], "--fake-clock")) {
+        fakeClockRate = std::stod(_argv[++i]);
+        continue;
+      }
+      if (0 == strcmp(_argv[i], "--history-size")) {
+        historySize = std::stoull(_argv[++i]);
+        continue;
+      }
+      if (0 == strcmp(_argv[i], "--lsq-window")) {
+        lsqWindow = std::stoull(_argv[++i]);
+        if (lsqWindow < ign_imgui::SlidingRegression::kMinWindow ||
+            lsqWindow > ign_imgui::SlidingRegression::kMaxWindow) {
+          ignerr << "--lsq-window must be " <<
+            ign_imgui::SlidingRegression::kMinWindow << " to " <<
+            ign_imgui::SlidingRegression::kMaxWindow << " samples" <<
+            std::endl;
+          std::exit(1);
+        }
+        continue;
+      }
+      if (0 == strcmp(_argv[i], "--interval")) {
+        interval = std::stod(_argv[++i]);
+        continue;
+      }
+      if (0 == strcmp(_argv[i], "--backend")) {
+        if (ign_imgui::Distribution::ParseKind(_argv[++i], backendKind)) {
+          continue;
+        }
+      }
+      if (0 == strcmp(_argv[i], "--hist2d-x")) {
+        ++i;
+        if (0 == strcmp(_argv[i], "step")) {
+          hist2dX = ign_imgui::Hist2dX::kStep;
+          continue;
+        }
+        if (0 == strcmp(_argv[i], "sim")) {
+          hist2dX = ign_imgui::Hist2dX::kSimTime;
+          continue;
+        }
+        if (0 == strcmp(_argv[i], "cpu")) {
+          hist2dX = ign_imgui::Hist2dX::kCpu;
+          continue;
+        }
+      }
     }
-    std::cout << std::endl << _argv[0] << " [--output <OUTPUT_FILE_PATH>] [--input <OUTPUT_FILE_PATH>]" << std::endl;
+    std::cout << std::endl << _argv[0] <<
+      " [--output <OUTPUT_FILE_PATH>] [--input <OUTPUT_FILE_PATH>]" <<
+      " [--history <RING_FILE_PATH>] [--history-size <NUM_SAMPLES>]" <<
+      " [--hist2d-x <step|sim|cpu>] [--interval <SECONDS>]" <<
+      " [--backend <dense|loglinear|sparse|ddsketch>] [--lazy]" <<
+      " [--checkpoint <CHECKPOINT_FILE_PATH>]" <<
+      " [--checkpoint-period <SECONDS>] [--resume <CHECKPOINT_FILE_PATH>]" <<
+      " [--persist <STATE_FILE_PATH>]" <<
+      " [--arrow <ARROW_FILE_PREFIX>] [--arrow-stream] [--alloc-check]" <<
+      " [--listen <udp:[HOST:]PORT|unix:PATH>] [--lsq-window <SAMPLES>]" <<
+      " [--metrics <METRICS_FILE_PATH>] [--remote-write <URL>]" <<
+      " [--fake-clock <MESSAGES_PER_SECOND>]" <<
+      " [--baseline <INPUT_FILE_PATH>] [--drift-window <SAMPLES>]" <<
+      " [--drift-threshold <RTF>]" << std::endl;
     std::exit(0);
   }
 
   // Set verbosity
   ignition::common::Console::SetVerbosity(4);
-  ignition::transport::Node node;
 
   std::mutex rtfsMutex;
-  ignition::msgs::Clock msg_z;
-  bool first = true;
 
-  bool animate = true;
+  ign_imgui::Moments moments;
 
-  std::vector<float> rtfs;
+  // Only the dense back-end has a fixed size that can live in a mapped file.
+  if (persistFile.size() &&
+      backendKind != ign_imgui::Distribution::Kind::kDense) {
+    ignwarn << "--persist needs the dense back-end, ignoring --backend " <<
+      ign_imgui::Distribution::KindName(backendKind) << std::endl;
+    backendKind = ign_imgui::Distribution::Kind::kDense;
+  }
 
-  ignition::math::SignalStats stats;
-  stats.InsertStatistic("max");
-  stats.InsertStatistic("min");
-  stats.InsertStatistic("mean");
-  stats.InsertStatistic("var");
+  ign_imgui::Distribution distribution;
+  distribution.SetBackend(ign_imgui::Distribution::MakeBackend(backendKind));
+  {
+    ign_imgui::HistogramAxis displayAxis;
+    displayAxis.Set(200, 0.0f, 2.0f, ign_imgui::HistogramAxis::Scale::kUniform);
+    distribution.SetDisplayAxis(displayAxis);
+  }
+
+  // Median and MAD are re-estimated from the distribution every refresh
+  // interval, scoring a sample against them is O(1).
+  ign_imgui::AnomalyDetector anomalies;
+
+  // Recent samples against a known-good export, with --baseline.
+  ign_imgui::DriftMonitor drift;
+  drift.SetWindow(driftWindow);
+  drift.SetThreshold(driftThreshold);
+  bool monitorDrift{false};
+
+  ign_imgui::IntervalHeatmap intervals;
+  intervals.SetNumBins(200);
+  intervals.SetRange(0.0f, 2.0f);
+  intervals.SetCapacity(kDefaultIntervalColumns);
+  intervals.SetInterval(interval);
+
+  // RTF as the slope of sim against real time, robust to clock jitter.
+  ign_imgui::LeastSquaresRtf lsqRtf;
+  lsqRtf.SetWindow(lsqWindow);
+  lsqRtf.SetRange(kDefaultRTFMin, kDefaultRTFMax);
+  lsqRtf.SetIntervals(interval, kDefaultIntervalColumns);
+
+  ign_imgui::Reservoir reservoir;
+
+  ign_imgui::LaggedCorrelation correlation;
+  correlation.SetPeriod(kCorrelationPeriod);
+  std::vector<int> lags;
+  for (int lag = -kCorrelationMaxLag; lag <= kCorrelationMaxLag; ++lag)
+    lags.push_back(lag);
+  correlation.SetLags(lags);
+  const size_t cpuSeries = correlation.AddSeries("cpu",
+      ign_imgui::LaggedCorrelation::Aggregation::kMean);
+  const size_t ioSeries = correlation.AddSeries("io",
+      ign_imgui::LaggedCorrelation::Aggregation::kMean);
+  const size_t msgSeries = correlation.AddSeries("msgs",
+      ign_imgui::LaggedCorrelation::Aggregation::kSum);
+
+  ign_imgui::HostMetrics hostMetrics;
+  std::atomic<float> cpuUsage{0.0f};
+
+  ign_imgui::Histogram2D hist2d;
+  {
+    ign_imgui::HistogramAxis xAxis;
+    switch (hist2dX)
+    {
+      case ign_imgui::Hist2dX::kStep:
+        xAxis.Set(kDefaultHist2dBins, kDefaultHist2dStepMin,
+            kDefaultHist2dStepMax, ign_imgui::HistogramAxis::Scale::kLog);
+        break;
+      case ign_imgui::Hist2dX::kSimTime:
+        xAxis.Set(kDefaultHist2dBins, 0.0f, kDefaultHist2dSimMax,
+            ign_imgui::HistogramAxis::Scale::kUniform);
+        break;
+      case ign_imgui::Hist2dX::kCpu:
+        xAxis.Set(kDefaultHist2dBins, 0.0f, 1.0f,
+            ign_imgui::HistogramAxis::Scale::kUniform);
+        break;
+    }
+    ign_imgui::HistogramAxis yAxis;
+    yAxis.Set(kDefaultHist2dBins, kDefaultHistMin, kDefaultHistMax,
+        ign_imgui::HistogramAxis::Scale::kUniform);
+    hist2d.SetAxes(xAxis, yAxis);
+  }
 
-  ign_imgui::Histogram hist;
+  ign_imgui::RingFileWriter history;
+  if (historyFile.size()) {
+    try {
+      history.Open(historyFile, historySize);
+    } catch (const std::runtime_error &_e) {
+      ignerr << _e.what() << ", not recording history" << std::endl;
+    }
+  }
 
-  hist.SetNumBins(200);
-  hist.SetRange(0.0f, 2.0f);
+  // Streaming appends every raw sample, and a batch of closed intervals
+  // and a stats row each interval. Otherwise the files are written once at
+  // exit, with the reservoir standing in for the raw samples.
+  ign_imgui::ArrowExport arrow;
 
   ignition::common::Time real_z{};
   ignition::common::Time sim_z{};
@@ -153,64 +412,440 @@ int main(int _argc, char** _argv)
   bool usingLoadedData{false};
   ign_imgui::LoadedData loadedData;
 
+  // Clock of the last message before the checkpoint, the first live message
+  // after resuming is compared against it to report the gap.
+  bool resumed{false};
+  ign_imgui::Checkpoint resumedFrom;
+
   if (inputCsv.size()) {
     std::ifstream fs;
     fs.open(inputCsv);
-    loadedData = ign_imgui::FromCsv(fs, hist);
+    loadedData = ign_imgui::FromCsv(fs, distribution, reservoir, correlation,
+                                    hist2d, intervals);
+    moments.SetSummary(loadedData.count, loadedData.mean, loadedData.var,
+        loadedData.skewness, loadedData.kurtosis, loadedData.min,
+        loadedData.max);
+    sim_z = ignition::common::Time(loadedData.simTime);
+    real_z = ignition::common::Time(loadedData.realTime);
     usingLoadedData = true;
+  } else if (resumeFile.size()) {
+    // A checkpoint that doesn't exist yet is the first run of
+    // --checkpoint f --resume f. One that fails to parse has already
+    // filled part of the accumulators, so there is nothing sane to go on
+    // with.
+    ign_imgui::MappedFile mapped;
+    bool opened{false};
+    try {
+      mapped.Open(resumeFile);
+      opened = true;
+    } catch (const std::runtime_error &_e) {
+      ignwarn << _e.what() << ", starting without a checkpoint" << std::endl;
+    }
+    if (opened) {
+      ign_imgui::MemoryStreamBuf buf(mapped.Data(), mapped.Size());
+      std::istream ist(&buf);
+      try {
+        resumedFrom = ign_imgui::FromBinary(ist, moments, distribution,
+            reservoir, correlation, hist2d, intervals);
+      } catch (const std::runtime_error &_e) {
+        ignerr << "Failed to resume from [" << resumeFile << "]: " <<
+          _e.what() << std::endl;
+        return 1;
+      }
+      resumed = true;
+      sim_z = ignition::common::Time(resumedFrom.simTime);
+      real_z = ignition::common::Time(resumedFrom.realTime);
+      ignmsg << "Resumed " << moments.Count() << " samples from [" <<
+        resumeFile << "] at sim time " << resumedFrom.simTime << std::endl;
+    }
   }
 
-  if (!usingLoadedData) {
-    std::function<void(const ignition::msgs::Clock&)> cb =
-      [&](const ignition::msgs::Clock &_msg)
-      {
-        std::lock_guard<std::mutex> lock(rtfsMutex);
+  // Only the distribution of the export is compared against, the rest is
+  // read to get past it.
+  if (baselineCsv.size() && usingLoadedData) {
+    ignwarn << "--baseline compares live data, ignoring it with --input" <<
+      std::endl;
+  } else if (baselineCsv.size()) {
+    std::ifstream fs;
+    fs.open(baselineCsv);
+    ign_imgui::Distribution baseline;
+    ign_imgui::Reservoir baselineReservoir;
+    ign_imgui::LaggedCorrelation baselineCorrelation;
+    ign_imgui::Histogram2D baselineHist2d;
+    ign_imgui::IntervalHeatmap baselineIntervals;
+    try {
+      if (!fs.is_open()) {
+        throw std::runtime_error{"failed to open [" + baselineCsv + "]"};
+      }
+      ign_imgui::FromCsv(fs, baseline, baselineReservoir,
+                         baselineCorrelation, baselineHist2d,
+                         baselineIntervals);
+      drift.SetBaseline(baseline);
+      monitorDrift = true;
+      ignmsg << "Comparing the last " << driftWindow <<
+        " samples against " << baseline.Count() << " from [" <<
+        baselineCsv << "]" << std::endl;
+    } catch (const std::runtime_error &_e) {
+      ignerr << "Can't use [" << baselineCsv << "] as the baseline: " <<
+        _e.what() << ", not monitoring drift" << std::endl;
+    }
+  }
 
-        if (first)
-        {
-          msg_z = _msg;
-          first = false;
-          return;
-        }
+  // Keep the live histogram and moments in a shared mapping, so they
+  // survive the process being killed. A new file starts from the current
+  // state, an existing one carries on from where it was left.
+  ign_imgui::PersistentState persistent;
+  const ign_imgui::HistogramAxis persistAxis =
+    ign_imgui::DenseBackend().Axis();
+  if (persistFile.size() && !usingLoadedData) {
+    try {
+      persistent.Open(persistFile, persistAxis);
+    } catch (const std::runtime_error &_e) {
+      ignerr << _e.what() << ", not persisting" << std::endl;
+    }
+  }
+  if (persistent.IsOpen()) {
+    const bool adopt = !persistent.Created() && !resumed;
+    if (!persistent.Created() && resumed) {
+      ignwarn << "Replacing the state in [" << persistFile <<
+        "] with the resumed checkpoint" << std::endl;
+    }
+    if (distribution.AttachDenseStorage(persistent.Counts(), persistAxis,
+          adopt)) {
+      moments.AttachStorage(persistent.Moments(), adopt);
+      if (adopt) {
+        ignmsg << "Continuing " << moments.Count() << " samples from [" <<
+          persistFile << "]" << std::endl;
+      }
+      if (adopt && persistent.Recovered()) {
+        // Moments and counts are published separately, a kill between the
+        // two leaves them one sample or batch apart.
+        const int64_t skew = static_cast<int64_t>(distribution.Count()) -
+          static_cast<int64_t>(moments.Count());
+        ignwarn << "Previous run did not shut down cleanly, recovered " <<
+          distribution.Count() << " histogram samples (" << skew <<
+          " not in the moments)" << std::endl;
+      }
+    } else {
+      ignwarn << "Resumed histogram does not match [" << persistFile <<
+        "], not persisting" << std::endl;
+      persistent.Close();
+    }
+  }
 
-        real_z = ignition::common::Time(msg_z.real().sec(), msg_z.real().nsec());
-        sim_z= ignition::common::Time(msg_z.sim().sec(), msg_z.sim().nsec());
-        ignition::common::Time real(_msg.real().sec(), _msg.real().nsec());
-        ignition::common::Time sim(_msg.sim().sec(), _msg.sim().nsec());
+  if (arrowPrefix.size() && arrowStream && !usingLoadedData) {
+    try {
+      arrow.Open(arrowPrefix);
+    } catch (const std::runtime_error &_e) {
+      ignerr << _e.what() << ", not streaming to Arrow" << std::endl;
+    }
+  }
 
-        auto real_dt = (real - real_z);
-        auto sim_dt = (sim - sim_z);
-        auto rtf = sim_dt.Double() / real_dt.Double();
+  // Callbacks may run on several transport threads, they only enqueue and
+  // a single thread folds the samples into the accumulators.
+  ign_imgui::IngestQueue<ign_imgui::ClockSample> ingestQueue(
+      kIngestQueueCapacity);
+  std::atomic<bool> ingestRunning{true};
+  std::thread ingestThread;
+  ign_imgui::ThreadCpuMeter ingestCpu;
+  // Ingest allocations after warm-up, only counted with --alloc-check.
+  std::atomic<uint64_t> steadyAllocations{0};
+  ign_imgui::DatagramSource datagrams;
+  std::unique_ptr<ign_imgui::ClockSource> clockSource;
 
-        msg_z = _msg;
+  // Exported in the Prometheus text format with --metrics. Series are
+  // labelled by where the clock samples come from, and the hot paths keep
+  // the handles looked up here.
+  ign_imgui::MetricRegistry metrics;
+  const std::string source = listenAddress.size() ? listenAddress :
+    fakeClockRate > 0.0 ? "fake" : "/clock";
+  ign_imgui::CounterMetric *samplesMetric = metrics.Counter(
+      "ign_imgui_clock_samples_total", "Clock samples received.",
+      {"source"}).WithLabels({source});
+  ign_imgui::CounterMetric *lostMetric = metrics.Counter(
+      "ign_imgui_clock_samples_lost_total",
+      "Clock samples dropped by the ingest queue.",
+      {"source"}).WithLabels({source});
+  ign_imgui::HistogramMetric *rtfMetric = nullptr;
+  {
+    ign_imgui::HistogramAxis axis;
+    axis.Set(kMetricRtfBins, kDefaultRTFMin, kDefaultRTFMax,
+        ign_imgui::HistogramAxis::Scale::kUniform);
+    rtfMetric = metrics.Histogram("ign_imgui_rtf",
+        "Real time factor between consecutive clock samples.", {"source"},
+        axis).WithLabels({source});
+  }
+  ign_imgui::GaugeMetric *lsqRtfMetric = metrics.Gauge(
+      "ign_imgui_rtf_least_squares",
+      "Real time factor fitted over the least-squares window.",
+      {"source"}).WithLabels({source});
+  ign_imgui::GaugeMetric *driftMetric = nullptr;
+  ign_imgui::GaugeMetric *driftAlarmMetric = nullptr;
+  if (monitorDrift) {
+    driftMetric = metrics.Gauge("ign_imgui_rtf_drift_wasserstein",
+        "Wasserstein distance of the recent RTF distribution from the "
+        "baseline.", {"source"}).WithLabels({source});
+    driftAlarmMetric = metrics.Gauge("ign_imgui_rtf_drift_alarm",
+        "1 while the RTF drift is above the threshold.",
+        {"source"}).WithLabels({source});
+  }
 
-        if (animate && std::isfinite(rtf))
-        {
-          stats.InsertData(rtf);
-          hist.InsertData(rtf);
+  // Pushes the registry and every RTF sample for hosts that can't be
+  // scraped, ingest only enqueues.
+  ign_imgui::RemoteWriteExporter remoteWrite;
+  remoteWrite.SetPeriod(interval);
+  remoteWrite.SetSampleSeries("ign_imgui_rtf_sample", {{"source", source}});
 
-          if (rtfs.size() > 250)
-          {
-            for(size_t ii = 1; ii < rtfs.size(); ++ii)
-            {
-              rtfs[ii-1] = rtfs[ii];
-            }
-            rtfs[rtfs.size() - 1] = rtf;
-          }
-          else
+  // Draws on its own thread once a window backend is installed, ingest
+  // only publishes that something changed.
+  ign_imgui::RenderThread render;
+
+  // Every clock sample goes through here on the ingest thread. In lazy
+  // mode samples are only buffered, and aggregated a chunk at a time when
+  // the buffer fills, the queue goes idle or a snapshot is taken.
+  ign_imgui::IngestSinks sinks;
+  sinks.moments = &moments;
+  sinks.distribution = &distribution;
+  sinks.intervals = &intervals;
+  sinks.reservoir = &reservoir;
+  sinks.hist2d = &hist2d;
+  sinks.lsqRtf = &lsqRtf;
+  sinks.anomalies = &anomalies;
+  sinks.drift = monitorDrift ? &drift : nullptr;
+  sinks.rtfMetric = rtfMetric;
+  sinks.correlation = &correlation;
+  sinks.msgSeries = msgSeries;
+  sinks.history = &history;
+  sinks.arrow = &arrow;
+  sinks.remoteWrite = &remoteWrite;
+  ign_imgui::IngestPipeline pipeline(sinks);
+  pipeline.SetLazy(lazy);
+  pipeline.SetHist2dX(hist2dX);
+  pipeline.SetCpuUsage(&cpuUsage);
+  if (resumed)
+    pipeline.SetResumedFrom(resumedFrom);
+
+  // Clock of the last sample, before the first live one that of the
+  // loaded or resumed data. Needs the ingest lock.
+  auto latestSim = [&]()
+  {
+    return pipeline.Started() ? pipeline.Latest().Sim().Double() :
+      sim_z.Double();
+  };
+  auto latestReal = [&]()
+  {
+    return pipeline.Started() ? pipeline.Latest().Real().Double() :
+      real_z.Double();
+  };
+
+  if (!usingLoadedData) {
+    // Before ingest starts, so a bad URL exits with nothing to join.
+    if (remoteWriteUrl.size()) {
+      try {
+        remoteWrite.Start(remoteWriteUrl, &metrics);
+      } catch (const std::runtime_error &_e) {
+        ignerr << _e.what() << std::endl;
+        return 1;
+      }
+      ignmsg << "Pushing metrics to [" << remoteWriteUrl << "]" << std::endl;
+    }
+
+    auto byRealTime = [](const ign_imgui::ClockSample &_a,
+                         const ign_imgui::ClockSample &_b)
+    {
+      return _a.RealNs() < _b.RealNs();
+    };
+    auto ingest = [&](const ign_imgui::ClockSample &_sample)
+    {
+      pipeline.Insert(_sample);
+    };
+
+    ingestThread = std::thread([&]()
+    {
+      ign_imgui::AllocScope allocScope(ign_imgui::AllocStage::kIngest);
+      uint64_t ingested = 0;
+      while (true)
+      {
+        // Read the flag first so the last drain sees everything pushed
+        // before the subscription was removed.
+        const bool running = ingestRunning.load();
+        const uint64_t allocsBefore = ign_imgui::AllocTracker::
+          ThreadAllocations(ign_imgui::AllocStage::kIngest);
+        size_t count;
+        {
+          std::lock_guard<std::mutex> lock(rtfsMutex);
+          count = ingestQueue.DrainOrdered(ingest, byRealTime);
+        }
+        if (count == 0)
+        {
+          std::lock_guard<std::mutex> lock(rtfsMutex);
+          if (pipeline.Buffered())
           {
-            rtfs.push_back(rtf);
+            pipeline.Flush();
+            render.Publish();
           }
         }
+        else
+        {
+          render.Publish();
+        }
+        ingestCpu.Sample();
 
+        ingested += count;
+        const uint64_t allocs = ign_imgui::AllocTracker::ThreadAllocations(
+            ign_imgui::AllocStage::kIngest) - allocsBefore;
+        if (allocCheck && allocs > 0 && ingested > kAllocCheckWarmup)
+        {
+          steadyAllocations += allocs;
+          IGN_IMGUI_LOG_ERR("Ingest allocated {} times after {} samples",
+              allocs, ingested);
+        }
+        if (!running && count == 0)
+          break;
+        if (count == 0)
+          std::this_thread::sleep_for(kIngestIdleSleep);
+      }
+    });
+
+    // A source that fails to start leaves nothing to show. Join the ingest
+    // thread before returning, destroying it while joinable would
+    // terminate.
+    auto stopIngest = [&]()
+    {
+      ingestRunning = false;
+      ingestThread.join();
+    };
+
+    std::function<void(const ignition::msgs::Clock&)> cb =
+      [&](const ignition::msgs::Clock &_msg)
+      {
+        ign_imgui::AllocScope allocScope(ign_imgui::AllocStage::kTransport);
+        samplesMetric->Add();
+        ingestQueue.Push(
+            ign_imgui::ToClockSample(_msg, ign_imgui::SteadySeconds()));
       };
-    node.Subscribe("/clock", cb);
+
+    // Datagram records feed the same queue in place of /clock messages.
+    if (listenAddress.size()) {
+      try {
+        datagrams.Start(listenAddress,
+            [&](const ign_imgui::DatagramRecord *_records, size_t _count)
+            {
+              const double steady = ign_imgui::SteadySeconds();
+              samplesMetric->Add(_count);
+              for (size_t ii = 0; ii < _count; ++ii) {
+                ign_imgui::ClockSample sample;
+                sample.simSec = _records[ii].sim / 1000000000;
+                sample.simNsec = _records[ii].sim % 1000000000;
+                sample.realSec = _records[ii].real / 1000000000;
+                sample.realNsec = _records[ii].real % 1000000000;
+                sample.steady = steady;
+                ingestQueue.Push(sample);
+              }
+            });
+      } catch (const std::runtime_error &_e) {
+        ignerr << _e.what() << std::endl;
+        stopIngest();
+        return 1;
+      }
+      ignmsg << "Listening for clock records on [" << listenAddress << "]" <<
+        std::endl;
+    } else {
+      if (fakeClockRate > 0.0) {
+        // Synthetic messages in-process, to try the pipeline without a
+        // simulator and without transport discovery.
+        auto fake = std::make_unique<ign_imgui::FakeClockSource>();
+        fake->SetMessages(ign_imgui::FakeClockSource::MakeSequence(
+              kFakeClockMessages, kFakeClockStep, 1.0, kFakeClockJitter, 1));
+        fake->SetLoop(true);
+        fake->SetRate(fakeClockRate);
+        clockSource = std::move(fake);
+      } else {
+        clockSource =
+          std::make_unique<ign_imgui::TransportClockSource>("/clock");
+      }
+      try {
+        clockSource->Start(cb);
+      } catch (const std::runtime_error &_e) {
+        ignerr << _e.what() << std::endl;
+        stopIngest();
+        return 1;
+      }
+      if (fakeClockRate > 0.0) {
+        ignmsg << "Generating " << fakeClockRate <<
+          " clock messages per second" << std::endl;
+      }
+    }
   }
   double progress = 0;
 
+  auto saveCheckpoint = [&]()
+  {
+    ign_imgui::AllocScope allocScope(ign_imgui::AllocStage::kCheckpoint);
+    // Serialize under the ingest lock so all parts agree on the last sample,
+    // the slow file write happens outside it.
+    std::ostringstream oss;
+    {
+      std::lock_guard<std::mutex> lock(rtfsMutex);
+      pipeline.Flush();
+      ign_imgui::ToBinary(oss, moments, distribution, reservoir, correlation,
+                          hist2d, intervals, pipeline.Gaps(), latestSim(),
+                          latestReal());
+    }
+    ign_imgui::WriteFileAtomically(checkpointFile, oss.str());
+  };
+  double lastCheckpoint = ign_imgui::SteadySeconds();
+
+  // Full sample batches are handed over by the ingest thread and written
+  // here, outside the ingest lock.
+  auto appendArrow = [&]()
+  {
+    ign_imgui::AllocScope allocScope(ign_imgui::AllocStage::kExport);
+    {
+      std::lock_guard<std::mutex> lock(rtfsMutex);
+      pipeline.Flush();
+      arrow.HandOffSamples();
+      arrow.AppendIntervals(intervals);
+      arrow.AppendStats(moments, latestSim(), latestReal());
+    }
+    arrow.WriteSamples();
+  };
+  double lastArrow = lastCheckpoint;
+
+  auto writeMetrics = [&]()
+  {
+    ign_imgui::AllocScope allocScope(ign_imgui::AllocStage::kExport);
+    std::ostringstream oss;
+    metrics.ToText(oss);
+    ign_imgui::WriteFileAtomically(metricsFile, oss.str());
+  };
+  double lastMetrics = lastCheckpoint;
+  uint64_t reportedLost = 0;
+  uint64_t reportedDriftAlarms = 0;
+  bool driftAlarm = false;
+
   float rtfMin = kDefaultRTFMin;
   float rtfMax = kDefaultRTFMax;
 
+  render.Start([&]()
+  {
+    ign_imgui::AllocScope allocScope(ign_imgui::AllocStage::kRender);
+    const auto renderStats = render.Stats();
+    ImGui::Begin("Real time factor");
+    ImGui::Text("%llu samples, mean %.4f",
+        static_cast<unsigned long long>(moments.Count()), moments.Mean());
+    ImGui::Text("render %.1f%% CPU at %.1f fps, ingest %.1f%% CPU",
+        renderStats.cpu * 100.0, renderStats.fps, ingestCpu.Usage() * 100.0);
+    distribution.PlotHistogram("RTF", ImVec2(0, 120));
+    anomalies.Draw();
+    drift.Draw();
+    lsqRtf.Draw();
+    intervals.Plot("RTF over time");
+    hist2d.PlotHeatmap("RTF vs x");
+    correlation.Draw();
+    ImGui::End();
+  });
+
   while(!shouldClose)
   {
     {
@@ -219,15 +854,190 @@ int main(int _argc, char** _argv)
       //ignition::common::Time real_z(msg_z.real().sec(), msg_z.real().nsec());
       //ignition::common::Time sim_z(msg_z.sim().sec(), msg_z.sim().nsec());
     }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(kCorrelationPeriod));
+    if (!usingLoadedData) {
+      hostMetrics.Sample();
+      const double now = ign_imgui::SteadySeconds();
+      correlation.InsertData(cpuSeries, now, hostMetrics.CpuUsage());
+      cpuUsage = hostMetrics.CpuUsage();
+      correlation.InsertData(ioSeries, now, hostMetrics.IoPressure());
+
+      ign_imgui::RegressionFit fit;
+      if (lsqRtf.Latest(fit))
+        lsqRtfMetric->Set(fit.slope);
+
+      if (monitorDrift) {
+        const auto driftStats = drift.Stats();
+        driftMetric->Set(driftStats.wasserstein);
+        driftAlarmMetric->Set(driftStats.alarm ? 1.0 : 0.0);
+        if (driftStats.alarms > reportedDriftAlarms) {
+          ignwarn << "RTF drifted from the baseline: Wasserstein distance " <<
+            driftStats.wasserstein << " above " << driftThreshold <<
+            " (KS " << driftStats.ks << ")" << std::endl;
+          reportedDriftAlarms = driftStats.alarms;
+        } else if (driftAlarm && !driftStats.alarm) {
+          ignmsg << "RTF back near the baseline: Wasserstein distance " <<
+            driftStats.wasserstein << std::endl;
+        }
+        driftAlarm = driftStats.alarm;
+      }
+
+      const auto queueStats = ingestQueue.Stats();
+      const uint64_t lost = queueStats.dropped + queueStats.overflowed;
+      if (lost > reportedLost) {
+        ignwarn << "Ingest queue dropped " << lost - reportedLost <<
+          " clock messages (" << queueStats.producers << " producers, " <<
+          "max depth " << queueStats.maxDepth << ")" << std::endl;
+        lostMetric->Add(lost - reportedLost);
+        reportedLost = lost;
+      }
+
+      if (checkpointFile.size() && now - lastCheckpoint >= checkpointPeriod) {
+        saveCheckpoint();
+        lastCheckpoint = now;
+      }
+
+      if (arrow.IsOpen() && now - lastArrow >= interval) {
+        appendArrow();
+        lastArrow = now;
+      } else if (arrow.IsOpen()) {
+        ign_imgui::AllocScope allocScope(ign_imgui::AllocStage::kExport);
+        arrow.WriteSamples();
+      }
+
+      if (metricsFile.size() && now - lastMetrics >= interval) {
+        writeMetrics();
+        lastMetrics = now;
+      }
+    }
+
+    if (render.CloseRequested()) {
+      shouldClose = true;
+    }
+  }
+  render.Stop();
+  if (clockSource) {
+    clockSource->Stop();
+  }
+  if (listenAddress.size() && !usingLoadedData) {
+    datagrams.Stop();
+    const auto datagramStats = datagrams.Stats();
+    ignmsg << "Datagrams: " << datagramStats.records << " records in " <<
+      datagramStats.datagrams << " datagrams, " << datagramStats.socketDrops <<
+      " dropped by the socket, " << datagramStats.malformed << " malformed, " <<
+      datagramStats.truncated << " truncated" << std::endl;
+    if (datagramStats.error) {
+      ignerr << "Datagram receive failed: " <<
+        std::strerror(datagramStats.error) << std::endl;
+    }
+  }
+  ingestRunning = false;
+  if (ingestThread.joinable()) {
+    ingestThread.join();
+    const auto queueStats = ingestQueue.Stats();
+    ignmsg << "Ingest queue: " << queueStats.enqueued << " enqueued, " <<
+      queueStats.dropped + queueStats.overflowed << " dropped, " <<
+      queueStats.producers << " producers, max depth " <<
+      queueStats.maxDepth << ", " << queueStats.headRefreshes <<
+      " head refreshes, " << pipeline.OutOfOrder() << " out of order" <<
+      std::endl;
+    lostMetric->Add(
+        queueStats.dropped + queueStats.overflowed - reportedLost);
+  }
+
+  if (remoteWrite.Running()) {
+    remoteWrite.Stop();
+    const auto remoteStats = remoteWrite.Stats();
+    ignmsg << "Remote write: " << remoteStats.requests << " requests, " <<
+      remoteStats.samples << " samples, " << remoteStats.retries <<
+      " retries, " << remoteStats.rejected << " rejected, " <<
+      remoteStats.dropped << " requests and " << remoteStats.samplesDropped <<
+      " samples dropped" << std::endl;
+  }
+
+  ign_imgui::AsyncLog::Instance().Stop();
+  const auto logStats = ign_imgui::AsyncLog::Instance().Stats();
+  if (logStats.suppressed + logStats.dropped > 0) {
+    ignmsg << "Log: " << logStats.written << " written, " <<
+      logStats.suppressed << " rate limited, " << logStats.dropped <<
+      " dropped" << std::endl;
+  }
+
+  if (anomalies.Scored() > 0) {
+    ignmsg << "Anomalies: " << anomalies.High() << " high, " <<
+      anomalies.Low() << " low of " << anomalies.Scored() <<
+      " samples (median " << anomalies.Median() << ", MAD " <<
+      anomalies.Mad() << ")" << std::endl;
+    for (const auto &event : anomalies.Extremes()) {
+      ignmsg << "  RTF " << event.rtf << " (score " << event.score <<
+        ") at sim time " << event.simTime << std::endl;
+    }
+  }
+
+  if (monitorDrift) {
+    const auto driftStats = drift.Stats();
+    ignmsg << "Drift: Wasserstein " << driftStats.wasserstein << ", KS " <<
+      driftStats.ks << " over the last " << driftStats.samples <<
+      " samples, alarm raised " << driftStats.alarms << " times" << std::endl;
+  }
+
+  if (checkpointFile.size() && !usingLoadedData) {
+    saveCheckpoint();
   }
-  node.Unsubscribe("/clock");
 
   if (outputCsv.size()) {
     std::ofstream fs;
     fs.open(outputCsv, std::ios::trunc);
-    ign_imgui::ToCsv(fs, stats, hist, sim_z.Double(), real_z.Double());
+    ign_imgui::ToCsv(fs, moments, distribution, reservoir, correlation,
+                     hist2d, intervals,
+                     usingLoadedData ? loadedData.gaps : pipeline.Gaps(),
+                     latestSim(), latestReal());
     fs.close();
   }
 
+  // The other exports at exit are written whatever happens here.
+  if (arrowPrefix.size()) {
+    ign_imgui::AllocScope allocScope(ign_imgui::AllocStage::kExport);
+    try {
+      if (!arrow.IsOpen()) {
+        arrow.Open(arrowPrefix);
+        arrow.AppendSamples(reservoir);
+      }
+      appendArrow();
+      arrow.Close();
+    } catch (const std::runtime_error &_e) {
+      ignerr << "Failed to export to Arrow: " << _e.what() << std::endl;
+    }
+  }
+
+  if (metricsFile.size() && !usingLoadedData) {
+    writeMetrics();
+  }
+
+  if (persistent.IsOpen()) {
+    distribution.DetachStorage();
+    moments.DetachStorage();
+    persistent.Close();
+  }
+
+  if (ign_imgui::AllocTracker::Enabled()) {
+    std::ostringstream oss;
+    for (size_t i = 0;
+         i < static_cast<size_t>(ign_imgui::AllocStage::kNumStages); ++i) {
+      const auto stage = static_cast<ign_imgui::AllocStage>(i);
+      const auto stats = ign_imgui::AllocTracker::Stage(stage);
+      oss << " " << ign_imgui::AllocTracker::StageName(stage) << " " <<
+        stats.allocations << " (" << stats.bytes << " bytes)";
+    }
+    ignmsg << "Allocations:" << oss.str() << std::endl;
+  }
+
+  if (allocCheck && steadyAllocations > 0) {
+    ignerr << "Ingest allocated " << steadyAllocations <<
+      " times in steady state" << std::endl;
+    return 1;
+  }
+
   return 0;
 }